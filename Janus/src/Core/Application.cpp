@@ -4,6 +4,7 @@
 #include "Core/Input.h"
 
 #include "Graphics/Renderer.h"
+#include "Graphics/ShaderReloader.h"
 
 #include <glfw/glfw3.h>
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -52,22 +53,31 @@ namespace Janus
 
 	void Application::Run()
 	{
+		// From here on GL commands are executed on the render thread, one frame behind the main thread
+		Renderer::StartRenderThread(*m_Window);
+
 		// MAIN APP LOOP
 		while (m_Running)
 		{
 			float time = (float)glfwGetTime(); // Should be Platform::GetTime
 			Timestep timestep = time - m_LastFrameTime;
 			m_LastFrameTime = time;
+			ShaderReloader::Update();
 			// Update all layers
 			for (Layer *layer : m_LayerStack)
 				layer->OnUpdate(timestep);
 
-			Application *app = this;
-			Renderer::Submit([app]()
-							 { app->RenderImGui(); });
+			RenderImGui();
+
+			Window *window = m_Window.get();
+			Renderer::Submit([window]()
+							 { window->SwapBuffers(); });
 			Renderer::WaitAndRender();
 			m_Window->OnUpdate();
 		}
+
+		ShaderReloader::Shutdown();
+		Renderer::StopRenderThread(*m_Window);
 	}
 
 	void Application::Close()
@@ -114,6 +124,7 @@ namespace Janus
 		return false;
 	}
 
+	// Builds the UI on the main thread. ImGuiLayer::End hands a snapshot of the draw data to the render thread
 	void Application::RenderImGui()
 	{
 		m_ImGuiLayer->Begin();
@@ -38,6 +38,13 @@ struct Buffer
         Size = size;
     }
 
+    void Release()
+    {
+        delete[] Data;
+        Data = nullptr;
+        Size = 0;
+    }
+
     template<typename T>
     T& Read(uint32_t offset = 0)
     {
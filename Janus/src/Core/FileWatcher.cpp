@@ -0,0 +1,141 @@
+#include "jnpch.h"
+#include "Core/FileWatcher.h"
+
+#include <filesystem>
+#include <unordered_map>
+
+#if defined(JN_PLATFORM_LINUX)
+	#include <sys/inotify.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+namespace Janus
+{
+	// How long the watch thread sleeps between checks for changes, or for the stop flag with inotify
+	static constexpr int s_WatchIntervalMs = 250;
+
+	FileWatcher::FileWatcher(const std::string &directory)
+		: m_Directory(NormalizePath(directory))
+	{
+		m_Thread = std::thread(&FileWatcher::WatchLoop, this);
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		m_Stopping = true;
+		m_Thread.join();
+	}
+
+	std::string FileWatcher::NormalizePath(const std::string &path)
+	{
+		return std::filesystem::absolute(path).lexically_normal().generic_string();
+	}
+
+	std::vector<std::string> FileWatcher::PopChanges()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		std::vector<std::string> changes(m_Changes.begin(), m_Changes.end());
+		m_Changes.clear();
+		return changes;
+	}
+
+	void FileWatcher::AddChange(const std::string &path)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Changes.insert(path);
+	}
+
+#if defined(JN_PLATFORM_LINUX)
+	void FileWatcher::WatchLoop()
+	{
+		int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd == -1)
+		{
+			JN_CORE_ERROR("FILE_WATCHER_ERROR: Could not initialize inotify for {0}", m_Directory);
+			return;
+		}
+
+		// Editors often save by writing a temporary file and renaming it over the original
+		const uint32_t fileEvents = IN_CLOSE_WRITE | IN_MOVED_TO;
+		const uint32_t directoryEvents = IN_CREATE | IN_MOVED_TO;
+		std::unordered_map<int, std::string> directories;
+		auto addWatch = [&](const std::string &directory)
+		{
+			int wd = inotify_add_watch(fd, directory.c_str(), fileEvents | directoryEvents | IN_ONLYDIR);
+			if (wd != -1)
+				directories[wd] = directory;
+		};
+
+		std::error_code error;
+		addWatch(m_Directory);
+		for (auto &entry : std::filesystem::recursive_directory_iterator(m_Directory, error))
+		{
+			if (entry.is_directory())
+				addWatch(entry.path().lexically_normal().generic_string());
+		}
+
+		alignas(inotify_event) char buffer[4096];
+		while (!m_Stopping)
+		{
+			pollfd descriptor = {fd, POLLIN, 0};
+			if (poll(&descriptor, 1, s_WatchIntervalMs) <= 0)
+				continue;
+
+			ssize_t length;
+			while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+			{
+				for (char *ptr = buffer; ptr < buffer + length;)
+				{
+					const inotify_event *event = (const inotify_event *)ptr;
+					ptr += sizeof(inotify_event) + event->len;
+
+					auto directory = directories.find(event->wd);
+					if (directory == directories.end() || event->len == 0)
+						continue;
+
+					std::string path = directory->second + "/" + event->name;
+					if (event->mask & IN_ISDIR)
+						addWatch(path);
+					else if (event->mask & fileEvents)
+						AddChange(path);
+				}
+			}
+		}
+
+		close(fd);
+	}
+#else
+	void FileWatcher::WatchLoop()
+	{
+		std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+		bool firstScan = true;
+		while (!m_Stopping)
+		{
+			std::error_code error;
+			for (auto &entry : std::filesystem::recursive_directory_iterator(m_Directory, error))
+			{
+				if (!entry.is_regular_file(error))
+					continue;
+
+				std::string path = entry.path().lexically_normal().generic_string();
+				auto writeTime = entry.last_write_time(error);
+				auto it = writeTimes.find(path);
+				if (it == writeTimes.end())
+				{
+					writeTimes[path] = writeTime;
+					if (!firstScan)
+						AddChange(path);
+				}
+				else if (it->second != writeTime)
+				{
+					it->second = writeTime;
+					AddChange(path);
+				}
+			}
+			firstScan = false;
+			std::this_thread::sleep_for(std::chrono::milliseconds(s_WatchIntervalMs));
+		}
+	}
+#endif
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_set>
+
+namespace Janus
+{
+	// Watches a directory tree on a background thread and collects the files written or moved into it.
+	// Uses inotify on Linux and compares modification times everywhere else
+	class FileWatcher
+	{
+	public:
+		FileWatcher(const std::string &directory);
+		~FileWatcher();
+
+		// Returns the files changed since the last call, each once, as absolute normalized paths
+		std::vector<std::string> PopChanges();
+
+		// The form paths are reported in, so callers can compare their own paths against changes
+		static std::string NormalizePath(const std::string &path);
+
+	private:
+		void WatchLoop();
+		void AddChange(const std::string &path);
+
+	private:
+		std::string m_Directory;
+		std::thread m_Thread;
+		std::atomic<bool> m_Stopping{false};
+		std::mutex m_Mutex;
+		std::unordered_set<std::string> m_Changes;
+	};
+}
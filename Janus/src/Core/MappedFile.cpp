@@ -0,0 +1,97 @@
+#include "jnpch.h"
+#include "Core/MappedFile.h"
+
+#if !defined(JN_PLATFORM_WINDOWS)
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace Janus
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#if defined(JN_PLATFORM_WINDOWS)
+	bool MappedFile::Open(const std::string &path)
+	{
+		Close();
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!data)
+		{
+			if (mapping)
+				CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_File = file;
+		m_Mapping = mapping;
+		m_Data = (const uint8_t *)data;
+		m_Size = (size_t)size.QuadPart;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping)
+			CloseHandle(m_Mapping);
+		if (m_File)
+			CloseHandle(m_File);
+		m_Data = nullptr;
+		m_Size = 0;
+		m_Mapping = nullptr;
+		m_File = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::string &path)
+	{
+		Close();
+		int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd == -1)
+			return false;
+
+		struct stat info;
+		if (fstat(fd, &info) == -1 || info.st_size == 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		// The mapping holds its own reference to the file, so the descriptor is not needed past this point
+		void *data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED)
+			return false;
+
+		m_Data = (const uint8_t *)data;
+		m_Size = (size_t)info.st_size;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_Data)
+			munmap((void *)m_Data, m_Size);
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+#endif
+}
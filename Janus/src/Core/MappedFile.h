@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+#include "Core/Ref.h"
+
+namespace Janus
+{
+	// Read-only memory mapping of a whole file. Pages are loaded by the OS on first access, so opening is
+	// cheap however large the file is, and nothing is copied until the data is used. Reference counted so
+	// work queued on other threads can keep the mapping alive while it reads from it
+	class MappedFile : public RefCounted
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+
+		// Returns false if the file does not exist, is empty or cannot be mapped
+		bool Open(const std::string &path);
+		void Close();
+
+		bool IsOpen() const { return m_Data != nullptr; }
+		const uint8_t *GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		const uint8_t *m_Data = nullptr;
+		size_t m_Size = 0;
+#if defined(JN_PLATFORM_WINDOWS)
+		void *m_File = nullptr;
+		void *m_Mapping = nullptr;
+#endif
+	};
+}
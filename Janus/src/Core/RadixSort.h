@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+namespace Janus
+{
+	// Stable LSD radix sort of items by a 64-bit key, one byte per pass. Passes in which every key shares
+	// the same byte are skipped, so keys that only use a few distinct bits sort in a handful of passes.
+	// scratch is resized to match items and can be kept around between calls to avoid reallocating.
+	template <typename T, typename KeyFn>
+	void RadixSort64(std::vector<T> &items, std::vector<T> &scratch, KeyFn getKey)
+	{
+		const uint32_t count = (uint32_t)items.size();
+		if (count < 2)
+			return;
+
+		// One histogram per byte, all built in a single read of the keys
+		uint32_t histograms[8][256] = {};
+		for (const T &item : items)
+		{
+			uint64_t key = getKey(item);
+			for (uint32_t pass = 0; pass < 8; pass++)
+				histograms[pass][(key >> (pass * 8)) & 0xff]++;
+		}
+
+		scratch.resize(count);
+		std::vector<T> *source = &items;
+		std::vector<T> *destination = &scratch;
+		for (uint32_t pass = 0; pass < 8; pass++)
+		{
+			uint32_t *histogram = histograms[pass];
+			uint64_t firstDigit = (getKey((*source)[0]) >> (pass * 8)) & 0xff;
+			if (histogram[firstDigit] == count)
+				continue;
+
+			uint32_t offsets[256];
+			uint32_t total = 0;
+			for (uint32_t digit = 0; digit < 256; digit++)
+			{
+				offsets[digit] = total;
+				total += histogram[digit];
+			}
+
+			for (const T &item : *source)
+				(*destination)[offsets[(getKey(item) >> (pass * 8)) & 0xff]++] = item;
+
+			std::swap(source, destination);
+		}
+
+		if (source != &items)
+			items.swap(scratch);
+	}
+}
@@ -1,24 +1,44 @@
 #pragma once
 
 #include <stdint.h>
+#include <atomic>
 
 namespace Janus {
 
 	class RefCounted
 	{
 	public:
+		RefCounted() = default;
+		// Copies of a ref counted object start out unowned
+		RefCounted(const RefCounted&) {}
+		RefCounted& operator=(const RefCounted&) { return *this; }
+
 		void IncRefCount() const
 		{
-			m_RefCount++;
+			m_RefCount.fetch_add(1, std::memory_order_relaxed);
+		}
+		uint32_t DecRefCount() const
+		{
+			return m_RefCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
 		}
-		void DecRefCount() const
+
+		// Takes a reference unless the last one is already gone. Lets registries of raw pointers, which objects
+		// leave from their destructors, hand out refs without reviving an object that is being destroyed
+		bool TryIncRefCount() const
 		{
-			m_RefCount--;
+			uint32_t count = m_RefCount.load(std::memory_order_relaxed);
+			while (count)
+			{
+				if (m_RefCount.compare_exchange_weak(count, count + 1, std::memory_order_relaxed))
+					return true;
+			}
+			return false;
 		}
 
-		uint32_t GetRefCount() const { return m_RefCount; }
+		uint32_t GetRefCount() const { return m_RefCount.load(std::memory_order_relaxed); }
 	private:
-		mutable uint32_t m_RefCount = 0; // TODO: atomic
+		// Refs are captured by render commands and released on the render thread
+		mutable std::atomic<uint32_t> m_RefCount{ 0 };
 	};
 
 	template<typename T>
@@ -144,8 +164,7 @@ namespace Janus {
 		{
 			if (m_Instance)
 			{
-				m_Instance->DecRefCount();
-				if (m_Instance->GetRefCount() == 0)
+				if (m_Instance->DecRefCount() == 0)
 				{
 					delete m_Instance;
 				}
@@ -0,0 +1,114 @@
+#include "jnpch.h"
+#include "Core/ThreadPool.h"
+
+#include <atomic>
+
+namespace Janus
+{
+	ThreadPool::ThreadPool(uint32_t workerCount)
+	{
+		if (workerCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_Condition.notify_all();
+		for (auto &worker : m_Workers)
+			worker.join();
+	}
+
+	ThreadPool &ThreadPool::Get()
+	{
+		static ThreadPool s_Instance;
+		return s_Instance;
+	}
+
+	void ThreadPool::Enqueue(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push(std::move(job));
+		}
+		m_Condition.notify_one();
+	}
+
+	void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)> &func)
+	{
+		if (count == 0)
+			return;
+
+		if (count == 1)
+		{
+			func(0);
+			return;
+		}
+
+		// Shared with the helper jobs, which may only get scheduled after every index has been claimed
+		struct ParallelForState
+		{
+			const std::function<void(uint32_t)> *Func;
+			uint32_t Count;
+			std::atomic<uint32_t> NextIndex{ 0 };
+			std::atomic<uint32_t> Completed{ 0 };
+			std::mutex Mutex;
+			std::condition_variable Condition;
+		};
+
+		auto state = std::make_shared<ParallelForState>();
+		state->Func = &func;
+		state->Count = count;
+
+		auto work = [](ParallelForState &s)
+		{
+			uint32_t index;
+			while ((index = s.NextIndex.fetch_add(1)) < s.Count)
+			{
+				(*s.Func)(index);
+				if (s.Completed.fetch_add(1) + 1 == s.Count)
+				{
+					std::lock_guard<std::mutex> lock(s.Mutex);
+					s.Condition.notify_all();
+				}
+			}
+		};
+
+		uint32_t helperCount = std::min(count - 1, GetWorkerCount());
+		for (uint32_t i = 0; i < helperCount; i++)
+			Enqueue([state, work]() { work(*state); });
+
+		work(*state);
+
+		std::unique_lock<std::mutex> lock(state->Mutex);
+		state->Condition.wait(lock, [&]() { return state->Completed.load() == count; });
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+				if (m_Stopping && m_Jobs.empty())
+					return;
+
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop();
+			}
+			job();
+		}
+	}
+}
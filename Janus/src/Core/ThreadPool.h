@@ -0,0 +1,41 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace Janus
+{
+	// Fixed set of worker threads shared by engine systems that split work across cores
+	class ThreadPool
+	{
+	public:
+		// Defaults to one worker per hardware thread, leaving one for the caller
+		ThreadPool(uint32_t workerCount = 0);
+		~ThreadPool();
+
+		// Queues a job to run on the next free worker
+		void Enqueue(std::function<void()> job);
+
+		// Runs func(index) for every index in [0, count) on the workers and the calling thread.
+		// Returns once every index has been processed
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)> &func);
+
+		uint32_t GetWorkerCount() const { return (uint32_t)m_Workers.size(); }
+
+		static ThreadPool &Get();
+
+	private:
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> m_Workers;
+		std::queue<std::function<void()>> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_Stopping = false;
+	};
+}
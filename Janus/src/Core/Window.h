@@ -28,7 +28,12 @@ namespace Janus {
 
 		virtual ~Window() {}
 
+		// Polls platform events. Must be called from the main thread
 		virtual void OnUpdate() = 0;
+		// Presents the back buffer. Called from whichever thread owns the graphics context
+		virtual void SwapBuffers() = 0;
+		// Binds or releases the graphics context on the calling thread
+		virtual void SetContextCurrent(bool current) = 0;
 
 		virtual unsigned int GetWidth() const = 0;
 
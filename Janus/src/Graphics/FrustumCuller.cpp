@@ -0,0 +1,88 @@
+#include "jnpch.h"
+#include "Graphics/FrustumCuller.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define JN_CULL_SSE 1
+	#include <xmmintrin.h>
+#else
+	#define JN_CULL_SSE 0
+#endif
+
+namespace Janus
+{
+	void FrustumCuller::Clear()
+	{
+		m_CenterX.clear();
+		m_CenterY.clear();
+		m_CenterZ.clear();
+		m_ExtentX.clear();
+		m_ExtentY.clear();
+		m_ExtentZ.clear();
+	}
+
+	uint32_t FrustumCuller::Add(const AABB &localBounds, const glm::mat4 &transform)
+	{
+		AABB bounds = localBounds.Transform(transform);
+		glm::vec3 center = bounds.GetCenter();
+		glm::vec3 extents = bounds.GetExtents();
+
+		uint32_t index = GetCount();
+		m_CenterX.push_back(center.x);
+		m_CenterY.push_back(center.y);
+		m_CenterZ.push_back(center.z);
+		m_ExtentX.push_back(extents.x);
+		m_ExtentY.push_back(extents.y);
+		m_ExtentZ.push_back(extents.z);
+		return index;
+	}
+
+	void FrustumCuller::Cull(const Frustum &frustum, std::vector<uint8_t> &visible) const
+	{
+		JN_PROFILE_FUNCTION();
+		const uint32_t count = GetCount();
+		visible.resize(count);
+
+		// A box is outside when it lies entirely behind any plane: dot(n, c) + w + dot(|n|, e) < 0
+		uint32_t i = 0;
+#if JN_CULL_SSE
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 cx = _mm_loadu_ps(&m_CenterX[i]);
+			__m128 cy = _mm_loadu_ps(&m_CenterY[i]);
+			__m128 cz = _mm_loadu_ps(&m_CenterZ[i]);
+			__m128 ex = _mm_loadu_ps(&m_ExtentX[i]);
+			__m128 ey = _mm_loadu_ps(&m_ExtentY[i]);
+			__m128 ez = _mm_loadu_ps(&m_ExtentZ[i]);
+
+			__m128 inside = _mm_cmpeq_ps(zero, zero);
+			for (const auto &plane : frustum.Planes)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+											 _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(plane.x)), ex), _mm_mul_ps(_mm_set1_ps(std::abs(plane.y)), ey)),
+										   _mm_mul_ps(_mm_set1_ps(std::abs(plane.z)), ez));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			visible[i + 0] = (mask >> 0) & 1;
+			visible[i + 1] = (mask >> 1) & 1;
+			visible[i + 2] = (mask >> 2) & 1;
+			visible[i + 3] = (mask >> 3) & 1;
+		}
+#endif
+
+		for (; i < count; i++)
+		{
+			bool inside = true;
+			for (const auto &plane : frustum.Planes)
+			{
+				float distance = plane.x * m_CenterX[i] + plane.y * m_CenterY[i] + plane.z * m_CenterZ[i] + plane.w;
+				float radius = std::abs(plane.x) * m_ExtentX[i] + std::abs(plane.y) * m_ExtentY[i] + std::abs(plane.z) * m_ExtentZ[i];
+				inside &= distance + radius >= 0.0f;
+			}
+			visible[i] = inside ? 1 : 0;
+		}
+	}
+}
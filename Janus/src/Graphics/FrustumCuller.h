@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Math/AABB.h"
+#include "Math/Frustum.h"
+
+namespace Janus
+{
+	// Batch frustum culler. Boxes are transformed to world space as they are added and stored as
+	// center/extent arrays, so Cull can test four of them per plane with SSE.
+	class FrustumCuller
+	{
+	public:
+		void Clear();
+		// Returns the index of the box in the visibility results
+		uint32_t Add(const AABB &localBounds, const glm::mat4 &transform);
+
+		// Writes 1 for every box that intersects the frustum and 0 for every box outside it
+		void Cull(const Frustum &frustum, std::vector<uint8_t> &visible) const;
+
+		uint32_t GetCount() const { return (uint32_t)m_CenterX.size(); }
+		glm::vec3 GetCenter(uint32_t index) const { return {m_CenterX[index], m_CenterY[index], m_CenterZ[index]}; }
+		glm::vec3 GetExtents(uint32_t index) const { return {m_ExtentX[index], m_ExtentY[index], m_ExtentZ[index]}; }
+
+	private:
+		std::vector<float> m_CenterX, m_CenterY, m_CenterZ;
+		std::vector<float> m_ExtentX, m_ExtentY, m_ExtentZ;
+	};
+}
@@ -0,0 +1,194 @@
+#include "jnpch.h"
+#include "Graphics/GeometryArena.h"
+
+#include <glad/glad.h>
+
+#include "Graphics/Renderer.h"
+
+namespace Janus
+{
+	GeometryArena::GeometryArena(const BufferLayout &vertexLayout, const BufferLayout &instanceLayout, uint32_t instanceLocation, uint32_t vertexCapacity, uint32_t indexCapacity)
+		: m_VertexStride(vertexLayout.GetStride()), m_VertexCapacity(vertexCapacity), m_IndexCapacity(indexCapacity)
+	{
+		PipelineSpecification pipelineSpecification;
+		pipelineSpecification.Layout = vertexLayout;
+		pipelineSpecification.InstanceLayout = instanceLayout;
+		pipelineSpecification.InstanceLocation = instanceLocation;
+		m_Pipeline = Ref<Pipeline>::Create(pipelineSpecification);
+
+		m_VertexBuffer = Ref<VertexBuffer>::Create(m_VertexCapacity * m_VertexStride, VertexBuffer::VertexBufferUsage::Static);
+		m_VertexBuffer->SetLayout(vertexLayout);
+		m_IndexBuffer = Ref<IndexBuffer>::Create(m_IndexCapacity * (uint32_t)sizeof(uint32_t));
+
+		m_FreeVertices.push_back({0, m_VertexCapacity});
+		m_FreeIndices.push_back({0, m_IndexCapacity});
+	}
+
+	bool GeometryArena::AllocateRange(std::vector<Range> &freeRanges, uint32_t size, uint32_t &offset)
+	{
+		for (auto it = freeRanges.begin(); it != freeRanges.end(); it++)
+		{
+			if (it->Size < size)
+				continue;
+
+			offset = it->Offset;
+			it->Offset += size;
+			it->Size -= size;
+			if (it->Size == 0)
+				freeRanges.erase(it);
+			return true;
+		}
+		return false;
+	}
+
+	void GeometryArena::FreeRange(std::vector<Range> &freeRanges, uint32_t offset, uint32_t size)
+	{
+		auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), offset, [](const Range &range, uint32_t offset)
+									 { return range.Offset < offset; });
+		auto it = freeRanges.insert(next, {offset, size});
+
+		// Merge with the following range, then with the preceding one
+		auto following = it + 1;
+		if (following != freeRanges.end() && it->Offset + it->Size == following->Offset)
+		{
+			it->Size += following->Size;
+			freeRanges.erase(following);
+		}
+		if (it != freeRanges.begin())
+		{
+			auto preceding = it - 1;
+			if (preceding->Offset + preceding->Size == it->Offset)
+			{
+				preceding->Size += it->Size;
+				freeRanges.erase(it);
+			}
+		}
+	}
+
+	void GeometryArena::GrowVertices(uint32_t minCapacity)
+	{
+		uint32_t oldCapacity = m_VertexCapacity;
+		m_VertexCapacity = std::max(m_VertexCapacity * 2, minCapacity);
+		JN_CORE_INFO("GEOMETRY_ARENA_MSG: Growing vertex storage to {0} vertices", m_VertexCapacity);
+
+		Ref<VertexBuffer> oldBuffer = m_VertexBuffer;
+		m_VertexBuffer = Ref<VertexBuffer>::Create(m_VertexCapacity * m_VertexStride, VertexBuffer::VertexBufferUsage::Static);
+		m_VertexBuffer->SetLayout(oldBuffer->GetLayout());
+
+		Ref<VertexBuffer> newBuffer = m_VertexBuffer;
+		uint32_t size = oldCapacity * m_VertexStride;
+		Renderer::Submit([oldBuffer, newBuffer, size]()
+						 { glCopyNamedBufferSubData(oldBuffer->GetRendererID(), newBuffer->GetRendererID(), 0, 0, size); });
+
+		FreeRange(m_FreeVertices, oldCapacity, m_VertexCapacity - oldCapacity);
+	}
+
+	void GeometryArena::GrowIndices(uint32_t minCapacity)
+	{
+		uint32_t oldCapacity = m_IndexCapacity;
+		m_IndexCapacity = std::max(m_IndexCapacity * 2, minCapacity);
+		JN_CORE_INFO("GEOMETRY_ARENA_MSG: Growing index storage to {0} words", m_IndexCapacity);
+
+		Ref<IndexBuffer> oldBuffer = m_IndexBuffer;
+		m_IndexBuffer = Ref<IndexBuffer>::Create(m_IndexCapacity * (uint32_t)sizeof(uint32_t));
+
+		Ref<IndexBuffer> newBuffer = m_IndexBuffer;
+		uint32_t size = oldCapacity * (uint32_t)sizeof(uint32_t);
+		Renderer::Submit([oldBuffer, newBuffer, size]()
+						 { glCopyNamedBufferSubData(oldBuffer->GetRendererID(), newBuffer->GetRendererID(), 0, 0, size); });
+
+		FreeRange(m_FreeIndices, oldCapacity, m_IndexCapacity - oldCapacity);
+	}
+
+	uint32_t GeometryArena::GetIndexWords(uint32_t indexCount, IndexFormat format)
+	{
+		return (uint32_t)(((uint64_t)indexCount * GetIndexSize(format) + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+	}
+
+	GeometryArena::Allocation GeometryArena::AllocateRanges(uint32_t vertexCount, uint32_t indexCount, IndexFormat format)
+	{
+		JN_ASSERT(vertexCount && indexCount, "GEOMETRY_ARENA_ERROR: Cannot allocate empty geometry!");
+
+		Allocation allocation;
+		allocation.VertexCount = vertexCount;
+		allocation.IndexCount = indexCount;
+		allocation.Format = format;
+		uint32_t indexWords = GetIndexWords(indexCount, format);
+		uint32_t baseWord = 0;
+		// Growing appends a free range at the old end, which may merge with a free tail, so retry once
+		if (!AllocateRange(m_FreeVertices, vertexCount, allocation.BaseVertex))
+		{
+			GrowVertices(m_VertexCapacity + vertexCount);
+			AllocateRange(m_FreeVertices, vertexCount, allocation.BaseVertex);
+		}
+		if (!AllocateRange(m_FreeIndices, indexWords, baseWord))
+		{
+			GrowIndices(m_IndexCapacity + indexWords);
+			AllocateRange(m_FreeIndices, indexWords, baseWord);
+		}
+		// Draws address indices in units of their own size
+		allocation.BaseIndex = baseWord * (uint32_t)sizeof(uint32_t) / GetIndexSize(format);
+		return allocation;
+	}
+
+	GeometryArena::Allocation GeometryArena::Allocate(const void *vertices, uint32_t vertexCount, const void *indices, uint32_t indexCount, IndexFormat format)
+	{
+		JN_PROFILE_FUNCTION();
+		Allocation allocation = AllocateRanges(vertexCount, indexCount, format);
+
+		Buffer vertexData = Buffer::Copy((void *)vertices, vertexCount * m_VertexStride);
+		Buffer indexData = Buffer::Copy((void *)indices, indexCount * GetIndexSize(format));
+		Ref<VertexBuffer> vertexBuffer = m_VertexBuffer;
+		Ref<IndexBuffer> indexBuffer = m_IndexBuffer;
+		uint32_t vertexOffset = allocation.BaseVertex * m_VertexStride;
+		uint32_t indexOffset = allocation.BaseIndex * GetIndexSize(format);
+		Renderer::Submit([vertexBuffer, indexBuffer, vertexData, indexData, vertexOffset, indexOffset]() mutable
+						 {
+							 glNamedBufferSubData(vertexBuffer->GetRendererID(), vertexOffset, vertexData.Size, vertexData.Data);
+							 glNamedBufferSubData(indexBuffer->GetRendererID(), indexOffset, indexData.Size, indexData.Data);
+							 vertexData.Release();
+							 indexData.Release();
+						 });
+
+		return allocation;
+	}
+
+	GeometryArena::Allocation GeometryArena::Allocate(const Ref<MappedFile> &file, const void *vertices, uint32_t vertexCount, const void *indices, uint32_t indexCount, IndexFormat format)
+	{
+		JN_PROFILE_FUNCTION();
+		JN_ASSERT(file->IsOpen() && (const uint8_t *)vertices >= file->GetData() && (const uint8_t *)indices >= file->GetData(),
+				  "GEOMETRY_ARENA_ERROR: Geometry must lie inside the mapped file!");
+		Allocation allocation = AllocateRanges(vertexCount, indexCount, format);
+
+		Ref<MappedFile> source = file;
+		Ref<VertexBuffer> vertexBuffer = m_VertexBuffer;
+		Ref<IndexBuffer> indexBuffer = m_IndexBuffer;
+		uint32_t vertexOffset = allocation.BaseVertex * m_VertexStride;
+		uint32_t indexOffset = allocation.BaseIndex * GetIndexSize(format);
+		uint32_t vertexSize = vertexCount * m_VertexStride;
+		uint32_t indexSize = indexCount * GetIndexSize(format);
+		Renderer::Submit([source, vertexBuffer, indexBuffer, vertices, indices, vertexOffset, indexOffset, vertexSize, indexSize]()
+						 {
+							 glNamedBufferSubData(vertexBuffer->GetRendererID(), vertexOffset, vertexSize, vertices);
+							 glNamedBufferSubData(indexBuffer->GetRendererID(), indexOffset, indexSize, indices);
+						 });
+
+		return allocation;
+	}
+
+	void GeometryArena::Free(const Allocation &allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		FreeRange(m_FreeVertices, allocation.BaseVertex, allocation.VertexCount);
+		uint32_t baseWord = allocation.BaseIndex * GetIndexSize(allocation.Format) / (uint32_t)sizeof(uint32_t);
+		FreeRange(m_FreeIndices, baseWord, GetIndexWords(allocation.IndexCount, allocation.Format));
+	}
+
+	void GeometryArena::Bind(const Ref<VertexBuffer> &instanceBuffer)
+	{
+		m_Pipeline->Bind(m_VertexBuffer, instanceBuffer);
+		m_IndexBuffer->Bind();
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include "Core/Core.h"
+#include "Core/MappedFile.h"
+#include "Graphics/VertexBuffer.h"
+#include "Graphics/IndexBuffer.h"
+#include "Graphics/Pipeline.h"
+
+namespace Janus
+{
+	// Matches the command layout read by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand
+	{
+		uint32_t Count;
+		uint32_t InstanceCount;
+		uint32_t FirstIndex;
+		int32_t BaseVertex;
+		uint32_t BaseInstance;
+	};
+
+	static_assert(sizeof(DrawElementsIndirectCommand) == 5 * sizeof(uint32_t));
+
+	// One vertex buffer and one index buffer shared by every mesh with the same vertex layout. Meshes
+	// suballocate ranges of both, so all of them draw through a single vertex array and can be batched
+	// into multi-draw indirect calls. The buffers grow on demand; freed ranges are reused first-fit.
+	// Index storage is counted in 32-bit words, so 16-bit and 32-bit index ranges share one buffer
+	class GeometryArena : public RefCounted
+	{
+	public:
+		// Ranges are in vertices and in indices of Format, not bytes
+		struct Allocation
+		{
+			uint32_t BaseVertex = 0;
+			uint32_t VertexCount = 0;
+			uint32_t BaseIndex = 0;
+			uint32_t IndexCount = 0;
+			IndexFormat Format = IndexFormat::UInt32;
+
+			bool IsValid() const { return VertexCount != 0; }
+		};
+
+		// Instance attributes start at instanceLocation, see PipelineSpecification
+		GeometryArena(const BufferLayout &vertexLayout, const BufferLayout &instanceLayout, uint32_t instanceLocation, uint32_t vertexCapacity, uint32_t indexCapacity);
+
+		// Copies the data and uploads it on the render thread. Indices are relative to the first vertex
+		Allocation Allocate(const void *vertices, uint32_t vertexCount, const void *indices, uint32_t indexCount, IndexFormat format);
+		// Uploads straight from data inside the mapped file, which is kept open until the render thread has read it
+		Allocation Allocate(const Ref<MappedFile> &file, const void *vertices, uint32_t vertexCount, const void *indices, uint32_t indexCount, IndexFormat format);
+		void Free(const Allocation &allocation);
+
+		// Binds the shared vertex array, the arena buffers and the per-instance buffer
+		void Bind(const Ref<VertexBuffer> &instanceBuffer);
+
+		uint32_t GetVertexCapacity() const { return m_VertexCapacity; }
+		// In 32-bit words
+		uint32_t GetIndexCapacity() const { return m_IndexCapacity; }
+
+	private:
+		struct Range
+		{
+			uint32_t Offset;
+			uint32_t Size;
+		};
+
+		// Free lists are kept sorted by offset so neighbouring ranges can be merged
+		static bool AllocateRange(std::vector<Range> &freeRanges, uint32_t size, uint32_t &offset);
+		static void FreeRange(std::vector<Range> &freeRanges, uint32_t offset, uint32_t size);
+		Allocation AllocateRanges(uint32_t vertexCount, uint32_t indexCount, IndexFormat format);
+		// Index storage used by an allocation, in words
+		static uint32_t GetIndexWords(uint32_t indexCount, IndexFormat format);
+
+		void GrowVertices(uint32_t minCapacity);
+		void GrowIndices(uint32_t minCapacity);
+
+	private:
+		Ref<Pipeline> m_Pipeline;
+		Ref<VertexBuffer> m_VertexBuffer;
+		Ref<IndexBuffer> m_IndexBuffer;
+		uint32_t m_VertexStride;
+
+		uint32_t m_VertexCapacity;
+		uint32_t m_IndexCapacity;
+		std::vector<Range> m_FreeVertices;
+		std::vector<Range> m_FreeIndices;
+	};
+}
@@ -0,0 +1,726 @@
+#include "jnpch.h"
+#include "Graphics/GltfImporter.h"
+
+#include <atomic>
+#include <filesystem>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/ext/matrix_transform.hpp>
+
+#include "Core/MappedFile.h"
+#include "Core/ThreadPool.h"
+#include "Graphics/MeshFile.h"
+#include "Utilities/Json.h"
+
+namespace Janus
+{
+	// Elements converted by one job
+	static constexpr uint32_t s_VerticesPerChunk = 16384;
+	static constexpr uint32_t s_IndicesPerChunk = 65536;
+	// Node hierarchies deeper than this are treated as cyclic
+	static constexpr uint32_t s_MaxNodeDepth = 64;
+
+	static constexpr uint32_t s_GlbMagic = 0x46546c67;       // "glTF"
+	static constexpr uint32_t s_GlbJsonChunk = 0x4e4f534a;   // "JSON"
+	static constexpr uint32_t s_GlbBinaryChunk = 0x004e4942; // "BIN\0"
+
+	enum class GltfComponentType : uint32_t
+	{
+		Byte = 5120,
+		UnsignedByte = 5121,
+		Short = 5122,
+		UnsignedShort = 5123,
+		UnsignedInt = 5125,
+		Float = 5126
+	};
+
+	struct GltfBuffer
+	{
+		const uint8_t *Data = nullptr;
+		uint64_t Size = 0;
+	};
+
+	// An accessor whose elements have been checked to lie inside their buffer
+	struct GltfAccessor
+	{
+		const uint8_t *Data = nullptr;
+		uint32_t Count = 0;
+		uint32_t Stride = 0;
+		GltfComponentType ComponentType = GltfComponentType::Float;
+		uint32_t ComponentCount = 0;
+		bool Normalized = false;
+	};
+
+	struct GltfPrimitive
+	{
+		GltfAccessor Positions;
+		GltfAccessor Normals;
+		GltfAccessor Tangents;
+		GltfAccessor Texcoords;
+		GltfAccessor Indices;
+		bool HasTangents = false;
+		bool HasTexcoords = false;
+		bool HasIndices = false;
+
+		uint32_t BaseVertex = 0;
+		uint32_t BaseIndex = 0;
+		uint32_t IndexCount = 0;
+		uint32_t MaterialIndex = 0;
+		AABB BoundingBox;
+	};
+
+	struct GltfDocument
+	{
+		JsonValue Json;
+		std::filesystem::path Directory;
+		// Keeps the buffers mapped until the import is done
+		std::vector<Ref<MappedFile>> Files;
+		std::vector<GltfBuffer> Buffers;
+	};
+
+	// Elements of a primitive converted by one job
+	struct GltfConversionJob
+	{
+		uint32_t Primitive;
+		uint32_t First;
+		uint32_t Count;
+		bool Indices;
+	};
+
+	static uint32_t GetComponentSize(GltfComponentType type)
+	{
+		switch (type)
+		{
+		case GltfComponentType::Byte:
+		case GltfComponentType::UnsignedByte:
+			return 1;
+		case GltfComponentType::Short:
+		case GltfComponentType::UnsignedShort:
+			return 2;
+		case GltfComponentType::UnsignedInt:
+		case GltfComponentType::Float:
+			return 4;
+		}
+		return 0;
+	}
+
+	static uint32_t GetComponentCount(const std::string &type)
+	{
+		if (type == "SCALAR")
+			return 1;
+		if (type == "VEC2")
+			return 2;
+		if (type == "VEC3")
+			return 3;
+		if (type == "VEC4")
+			return 4;
+		// Matrices are never used by mesh attributes
+		return 0;
+	}
+
+	// URIs in glTF are percent encoded
+	static std::string DecodeUri(const std::string &uri)
+	{
+		std::string result;
+		result.reserve(uri.size());
+		for (size_t i = 0; i < uri.size(); i++)
+		{
+			if (uri[i] == '%' && i + 2 < uri.size() && isxdigit((unsigned char)uri[i + 1]) && isxdigit((unsigned char)uri[i + 2]))
+			{
+				result += (char)std::stoi(uri.substr(i + 1, 2), nullptr, 16);
+				i += 2;
+			}
+			else
+			{
+				result += uri[i];
+			}
+		}
+		return result;
+	}
+
+	static bool IsDataUri(const std::string &uri)
+	{
+		return uri.compare(0, 5, "data:") == 0;
+	}
+
+	static bool ReadAccessor(const GltfDocument &document, int64_t index, GltfAccessor &result)
+	{
+		const JsonValue &accessor = document.Json["accessors"][(size_t)index];
+		if (index < 0 || !accessor.IsObject() || accessor.Contains("sparse") || !accessor.Contains("bufferView"))
+			return false;
+
+		int64_t viewIndex = accessor["bufferView"].AsInt(-1);
+		const JsonValue &view = document.Json["bufferViews"][(size_t)viewIndex];
+		int64_t bufferIndex = view["buffer"].AsInt(-1);
+		if (viewIndex < 0 || !view.IsObject() || bufferIndex < 0 || bufferIndex >= (int64_t)document.Buffers.size())
+			return false;
+
+		const GltfBuffer &buffer = document.Buffers[bufferIndex];
+		int64_t viewOffset = view["byteOffset"].AsInt(0);
+		int64_t viewLength = view["byteLength"].AsInt(-1);
+		int64_t accessorOffset = accessor["byteOffset"].AsInt(0);
+		int64_t count = accessor["count"].AsInt(-1);
+		if (viewOffset < 0 || viewLength < 0 || accessorOffset < 0 || count < 0 || count > UINT32_MAX || (uint64_t)(viewOffset + viewLength) > buffer.Size)
+			return false;
+
+		result.ComponentType = (GltfComponentType)accessor["componentType"].AsInt();
+		result.ComponentCount = GetComponentCount(accessor["type"].AsString());
+		result.Normalized = accessor["normalized"].AsBool();
+		result.Count = (uint32_t)count;
+		uint32_t elementSize = GetComponentSize(result.ComponentType) * result.ComponentCount;
+		if (!elementSize)
+			return false;
+
+		// Without a stride the elements are tightly packed
+		int64_t stride = view["byteStride"].AsInt(elementSize);
+		if (stride < elementSize || stride > 252)
+			return false;
+		result.Stride = (uint32_t)stride;
+
+		if (count && accessorOffset + (count - 1) * stride + elementSize > viewLength)
+			return false;
+		result.Data = buffer.Data + viewOffset + accessorOffset;
+		return true;
+	}
+
+	static bool LoadDocument(const std::string &path, GltfDocument &document)
+	{
+		JN_PROFILE_FUNCTION();
+		document.Directory = std::filesystem::path(path).parent_path();
+
+		Ref<MappedFile> file = Ref<MappedFile>::Create();
+		if (!file->Open(path))
+		{
+			JN_CORE_ERROR("MESH_IMPORT_MSG: Could not open {0}", path);
+			return false;
+		}
+		document.Files.push_back(file);
+
+		const char *json = (const char *)file->GetData();
+		size_t jsonLength = file->GetSize();
+		GltfBuffer binaryChunk;
+		if (std::filesystem::path(path).extension() == ".glb")
+		{
+			// Header (magic, version, length), then a JSON chunk and an optional binary chunk, each starting
+			// with its length and type
+			const uint8_t *data = file->GetData();
+			uint64_t size = file->GetSize();
+			uint32_t header[5];
+			if (size < sizeof(header))
+				return false;
+			memcpy(header, data, sizeof(header));
+			if (header[0] != s_GlbMagic || header[1] != 2 || header[2] > size || header[4] != s_GlbJsonChunk || (uint64_t)header[3] + 20 > header[2])
+			{
+				JN_CORE_ERROR("MESH_IMPORT_MSG: {0} is not a valid glTF binary", path);
+				return false;
+			}
+			json = (const char *)data + 20;
+			jsonLength = header[3];
+
+			uint64_t binaryOffset = 20 + (((uint64_t)header[3] + 3) & ~3ull);
+			uint32_t chunk[2];
+			if (binaryOffset + sizeof(chunk) <= header[2])
+			{
+				memcpy(chunk, data + binaryOffset, sizeof(chunk));
+				if (chunk[1] == s_GlbBinaryChunk && binaryOffset + sizeof(chunk) + chunk[0] <= header[2])
+					binaryChunk = {data + binaryOffset + sizeof(chunk), chunk[0]};
+			}
+		}
+
+		std::string error;
+		if (!JsonValue::Parse(json, jsonLength, document.Json, error))
+		{
+			JN_CORE_ERROR("MESH_IMPORT_MSG: Could not parse {0}: {1}", path, error);
+			return false;
+		}
+
+		const JsonValue &requiredExtensions = document.Json["extensionsRequired"];
+		if (requiredExtensions.GetSize())
+		{
+			JN_CORE_WARN("MESH_IMPORT_MSG: {0} requires extension {1}", path, requiredExtensions[(size_t)0].AsString());
+			return false;
+		}
+
+		const JsonValue &buffers = document.Json["buffers"];
+		for (size_t i = 0; i < buffers.GetSize(); i++)
+		{
+			const std::string &uri = buffers[i]["uri"].AsString();
+			uint64_t length = (uint64_t)buffers[i]["byteLength"].AsInt();
+			GltfBuffer buffer;
+			if (uri.empty())
+			{
+				// Only the buffer of a .glb has no uri, and it is the binary chunk
+				buffer = binaryChunk;
+			}
+			else if (IsDataUri(uri))
+			{
+				JN_CORE_WARN("MESH_IMPORT_MSG: {0} embeds buffer data in the document", path);
+				return false;
+			}
+			else
+			{
+				std::string bufferPath = (document.Directory / DecodeUri(uri)).string();
+				Ref<MappedFile> bufferFile = Ref<MappedFile>::Create();
+				if (!bufferFile->Open(bufferPath))
+				{
+					JN_CORE_ERROR("MESH_IMPORT_MSG: Could not open {0}", bufferPath);
+					return false;
+				}
+				document.Files.push_back(bufferFile);
+				buffer = {bufferFile->GetData(), bufferFile->GetSize()};
+			}
+
+			if (buffer.Size < length)
+			{
+				JN_CORE_ERROR("MESH_IMPORT_MSG: Buffer {0} of {1} is truncated", i, path);
+				return false;
+			}
+			document.Buffers.push_back(buffer);
+		}
+		return true;
+	}
+
+	static bool ReadPrimitive(const GltfDocument &document, const JsonValue &primitive, GltfPrimitive &result)
+	{
+		if (primitive["mode"].AsInt(4) != 4)
+			return false;
+
+		const JsonValue &attributes = primitive["attributes"];
+		if (!ReadAccessor(document, attributes["POSITION"].AsInt(-1), result.Positions) ||
+			!ReadAccessor(document, attributes["NORMAL"].AsInt(-1), result.Normals))
+			return false;
+
+		auto isFloats = [](const GltfAccessor &accessor, uint32_t componentCount)
+		{ return accessor.ComponentType == GltfComponentType::Float && accessor.ComponentCount == componentCount; };
+
+		uint32_t vertexCount = result.Positions.Count;
+		if (!isFloats(result.Positions, 3) || !isFloats(result.Normals, 3) || result.Normals.Count != vertexCount || !vertexCount)
+			return false;
+
+		if (attributes.Contains("TANGENT"))
+		{
+			result.HasTangents = true;
+			if (!ReadAccessor(document, attributes["TANGENT"].AsInt(-1), result.Tangents) || !isFloats(result.Tangents, 4) || result.Tangents.Count != vertexCount)
+				return false;
+		}
+
+		if (attributes.Contains("TEXCOORD_0"))
+		{
+			result.HasTexcoords = true;
+			GltfAccessor &texcoords = result.Texcoords;
+			if (!ReadAccessor(document, attributes["TEXCOORD_0"].AsInt(-1), texcoords) || texcoords.ComponentCount != 2 || texcoords.Count != vertexCount)
+				return false;
+			bool normalizedInteger = texcoords.Normalized && (texcoords.ComponentType == GltfComponentType::UnsignedByte || texcoords.ComponentType == GltfComponentType::UnsignedShort);
+			if (texcoords.ComponentType != GltfComponentType::Float && !normalizedInteger)
+				return false;
+		}
+
+		if (primitive.Contains("indices"))
+		{
+			result.HasIndices = true;
+			GltfAccessor &indices = result.Indices;
+			if (!ReadAccessor(document, primitive["indices"].AsInt(-1), indices) || indices.ComponentCount != 1)
+				return false;
+			if (indices.ComponentType != GltfComponentType::UnsignedByte && indices.ComponentType != GltfComponentType::UnsignedShort && indices.ComponentType != GltfComponentType::UnsignedInt)
+				return false;
+			result.IndexCount = indices.Count;
+		}
+		else
+		{
+			result.IndexCount = vertexCount;
+		}
+		return result.IndexCount && result.IndexCount % 3 == 0;
+	}
+
+	static glm::vec2 ReadTexcoord(const GltfAccessor &texcoords, uint32_t index)
+	{
+		const uint8_t *element = texcoords.Data + (size_t)index * texcoords.Stride;
+		glm::vec2 texcoord;
+		switch (texcoords.ComponentType)
+		{
+		case GltfComponentType::UnsignedByte:
+			texcoord = glm::vec2(element[0], element[1]) / 255.0f;
+			break;
+		case GltfComponentType::UnsignedShort:
+		{
+			uint16_t values[2];
+			memcpy(values, element, sizeof(values));
+			texcoord = glm::vec2(values[0], values[1]) / 65535.0f;
+			break;
+		}
+		default:
+			memcpy(&texcoord, element, sizeof(texcoord));
+			break;
+		}
+		return texcoord;
+	}
+
+	static AABB ConvertVertices(const GltfPrimitive &primitive, uint32_t first, uint32_t count, Vertex *vertices)
+	{
+		AABB bounds = AABB::Empty();
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			Vertex &vertex = vertices[i];
+			memcpy(&vertex.Position, primitive.Positions.Data + (size_t)i * primitive.Positions.Stride, sizeof(glm::vec3));
+			memcpy(&vertex.Normal, primitive.Normals.Data + (size_t)i * primitive.Normals.Stride, sizeof(glm::vec3));
+			bounds.Expand(vertex.Position);
+
+			// Texture coordinates are flipped like Assimp does, which the shaders expect
+			vertex.Texcoord = glm::vec2(0.0f);
+			if (primitive.HasTexcoords)
+			{
+				glm::vec2 texcoord = ReadTexcoord(primitive.Texcoords, i);
+				vertex.Texcoord = {texcoord.x, 1.0f - texcoord.y};
+			}
+
+			if (primitive.HasTangents)
+			{
+				glm::vec4 tangent;
+				memcpy(&tangent, primitive.Tangents.Data + (size_t)i * primitive.Tangents.Stride, sizeof(glm::vec4));
+				// w gives the handedness of the bitangent, built the same way Assimp does
+				vertex.Tangent = glm::vec3(tangent);
+				vertex.Binormal = glm::cross(vertex.Normal, vertex.Tangent) * tangent.w;
+			}
+			else
+			{
+				vertex.Tangent = glm::vec3(0.0f);
+				vertex.Binormal = glm::vec3(0.0f);
+			}
+		}
+		return bounds;
+	}
+
+	// Returns false if an index is out of range
+	static bool ConvertIndices(const GltfPrimitive &primitive, uint32_t first, uint32_t count, uint32_t *indices)
+	{
+		uint32_t vertexCount = primitive.Positions.Count;
+		if (!primitive.HasIndices)
+		{
+			for (uint32_t i = first; i < first + count; i++)
+				indices[i] = i;
+			return true;
+		}
+
+		const GltfAccessor &accessor = primitive.Indices;
+		bool valid = true;
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const uint8_t *element = accessor.Data + (size_t)i * accessor.Stride;
+			uint32_t index;
+			if (accessor.ComponentType == GltfComponentType::UnsignedByte)
+			{
+				index = *element;
+			}
+			else if (accessor.ComponentType == GltfComponentType::UnsignedShort)
+			{
+				uint16_t value;
+				memcpy(&value, element, sizeof(value));
+				index = value;
+			}
+			else
+			{
+				memcpy(&index, element, sizeof(index));
+			}
+			valid &= index < vertexCount;
+			indices[i] = index;
+		}
+		return valid;
+	}
+
+	// Per-vertex tangents from the texture coordinate gradients of the surrounding triangles, made orthogonal
+	// to the normal. The bitangent keeps the handedness of the texture mapping
+	static void GenerateTangents(Vertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount)
+	{
+		std::vector<glm::vec3> tangents(vertexCount, glm::vec3(0.0f));
+		std::vector<glm::vec3> bitangents(vertexCount, glm::vec3(0.0f));
+		for (uint32_t i = 0; i < indexCount; i += 3)
+		{
+			uint32_t i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+			const Vertex &v0 = vertices[i0];
+			const Vertex &v1 = vertices[i1];
+			const Vertex &v2 = vertices[i2];
+
+			glm::vec3 edge1 = v1.Position - v0.Position;
+			glm::vec3 edge2 = v2.Position - v0.Position;
+			glm::vec2 delta1 = v1.Texcoord - v0.Texcoord;
+			glm::vec2 delta2 = v2.Texcoord - v0.Texcoord;
+			float determinant = delta1.x * delta2.y - delta2.x * delta1.y;
+			if (std::abs(determinant) < 1e-12f)
+				continue;
+
+			float scale = 1.0f / determinant;
+			glm::vec3 tangent = (edge1 * delta2.y - edge2 * delta1.y) * scale;
+			glm::vec3 bitangent = (edge2 * delta1.x - edge1 * delta2.x) * scale;
+			for (uint32_t index : {i0, i1, i2})
+			{
+				tangents[index] += tangent;
+				bitangents[index] += bitangent;
+			}
+		}
+
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			Vertex &vertex = vertices[i];
+			glm::vec3 normal = vertex.Normal;
+			glm::vec3 tangent = tangents[i] - normal * glm::dot(normal, tangents[i]);
+			if (glm::dot(tangent, tangent) < 1e-12f)
+			{
+				// No usable texture mapping; any direction perpendicular to the normal will do
+				glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+				tangent = glm::cross(axis, normal);
+			}
+			tangent = glm::normalize(tangent);
+
+			glm::vec3 bitangent = glm::cross(normal, tangent);
+			vertex.Tangent = tangent;
+			vertex.Binormal = glm::dot(bitangent, bitangents[i]) < 0.0f ? -bitangent : bitangent;
+		}
+	}
+
+	static glm::mat4 GetNodeTransform(const JsonValue &node)
+	{
+		const JsonValue &matrix = node["matrix"];
+		if (matrix.GetSize() == 16)
+		{
+			// Column major, like glm
+			glm::mat4 transform;
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+					transform[column][row] = matrix[column * 4 + row].AsFloat();
+			}
+			return transform;
+		}
+
+		const JsonValue &t = node["translation"];
+		const JsonValue &r = node["rotation"];
+		const JsonValue &s = node["scale"];
+		glm::vec3 translation(t[(size_t)0].AsFloat(0.0f), t[1].AsFloat(0.0f), t[2].AsFloat(0.0f));
+		// Stored as x, y, z, w
+		glm::quat rotation(r[3].AsFloat(1.0f), r[(size_t)0].AsFloat(0.0f), r[1].AsFloat(0.0f), r[2].AsFloat(0.0f));
+		glm::vec3 scale(s[(size_t)0].AsFloat(1.0f), s[1].AsFloat(1.0f), s[2].AsFloat(1.0f));
+		return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+	}
+
+	static void AddSubmeshes(const GltfPrimitive *primitives, uint32_t count, const glm::mat4 &transform, std::vector<Submesh> &submeshes)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const GltfPrimitive &primitive = primitives[i];
+			Submesh &submesh = submeshes.emplace_back();
+			submesh.BaseVertex = primitive.BaseVertex;
+			submesh.BaseIndex = primitive.BaseIndex;
+			submesh.MaterialIndex = primitive.MaterialIndex;
+			submesh.IndexCount = primitive.IndexCount;
+			submesh.Transform = transform;
+			submesh.BoundingBox = primitive.BoundingBox;
+		}
+	}
+
+	// Every node that references a mesh adds a submesh per primitive. Nodes sharing a mesh share its geometry
+	static void TraverseNodes(const JsonValue &nodes, int64_t index, const glm::mat4 &parentTransform, uint32_t depth,
+							  const std::vector<GltfPrimitive> &primitives, const std::vector<std::pair<uint32_t, uint32_t>> &meshPrimitives,
+							  std::vector<Submesh> &submeshes)
+	{
+		const JsonValue &node = nodes[(size_t)index];
+		if (index < 0 || !node.IsObject() || depth > s_MaxNodeDepth)
+			return;
+
+		glm::mat4 transform = parentTransform * GetNodeTransform(node);
+		int64_t mesh = node["mesh"].AsInt(-1);
+		if (mesh >= 0 && mesh < (int64_t)meshPrimitives.size())
+		{
+			auto [first, count] = meshPrimitives[mesh];
+			AddSubmeshes(&primitives[first], count, transform, submeshes);
+		}
+
+		const JsonValue &children = node["children"];
+		for (size_t i = 0; i < children.GetSize(); i++)
+			TraverseNodes(nodes, children[i].AsInt(-1), transform, depth + 1, primitives, meshPrimitives, submeshes);
+	}
+
+	static std::string GetTexturePath(const GltfDocument &document, const JsonValue &textureInfo)
+	{
+		if (!textureInfo.IsObject())
+			return {};
+
+		const JsonValue &texture = document.Json["textures"][(size_t)textureInfo["index"].AsInt(-1)];
+		const JsonValue &image = document.Json["images"][(size_t)texture["source"].AsInt(-1)];
+		const std::string &uri = image["uri"].AsString();
+		if (uri.empty() || IsDataUri(uri))
+		{
+			JN_CORE_WARN("MESH_IMPORT_MSG: Skipping an image embedded in the document");
+			return {};
+		}
+		return (document.Directory / DecodeUri(uri)).string();
+	}
+
+	static MeshMaterialDescription ReadMaterial(const GltfDocument &document, const JsonValue &material)
+	{
+		MeshMaterialDescription result;
+		result.Name = material["name"].AsString();
+
+		// Defaults are those of the glTF metallic-roughness model
+		const JsonValue &pbr = material["pbrMetallicRoughness"];
+		const JsonValue &baseColor = pbr["baseColorFactor"];
+		result.AlbedoColor = {baseColor[(size_t)0].AsFloat(1.0f), baseColor[1].AsFloat(1.0f), baseColor[2].AsFloat(1.0f)};
+		result.Roughness = pbr["roughnessFactor"].AsFloat(1.0f);
+		result.Metalness = pbr["metallicFactor"].AsFloat(1.0f);
+		// Masked materials are drawn opaque, as the PBR shader has no alpha test
+		result.Transparent = material["alphaMode"].AsString() == "BLEND";
+		if (result.Transparent)
+			result.Opacity = baseColor[3].AsFloat(1.0f);
+		result.AlbedoMap = GetTexturePath(document, pbr["baseColorTexture"]);
+		result.NormalMap = GetTexturePath(document, material["normalTexture"]);
+
+		// The metallic-roughness texture packs both into one image, while the PBR shader reads single channel
+		// maps. The factors only scale that texture, so on their own they would turn a textured material into
+		// bare metal; use what the Assimp import of the same file gave instead
+		if (pbr["metallicRoughnessTexture"].IsObject())
+		{
+			JN_CORE_WARN("MESH_IMPORT_MSG: Dropping the metallic-roughness texture of material {0}", result.Name);
+			float shininess = (1.0f - result.Roughness) * (1.0f - result.Roughness) * 1000.0f;
+			result.Roughness = glm::clamp(1.0f - glm::sqrt(shininess / 100.0f), 0.0f, 1.0f);
+			result.Metalness = 0.0f;
+		}
+		return result;
+	}
+
+	bool GltfImporter::IsGltfPath(const std::string &path)
+	{
+		std::string extension = std::filesystem::path(path).extension().string();
+		return extension == ".gltf" || extension == ".glb";
+	}
+
+	bool GltfImporter::Import(const std::string &path, ImportedMesh &mesh)
+	{
+		JN_PROFILE_FUNCTION();
+		GltfDocument document;
+		if (!LoadDocument(path, document))
+			return false;
+
+		const JsonValue &json = document.Json;
+		const JsonValue &materials = json["materials"];
+		ImportedMesh imported;
+		MeshContents &contents = imported.Contents;
+		for (size_t i = 0; i < materials.GetSize(); i++)
+			contents.Materials.push_back(ReadMaterial(document, materials[i]));
+
+		// Validate every primitive and lay them out one after the other
+		const JsonValue &meshes = json["meshes"];
+		std::vector<GltfPrimitive> primitives;
+		std::vector<std::pair<uint32_t, uint32_t>> meshPrimitives;
+		uint64_t vertexCount = 0, indexCount = 0;
+		int64_t defaultMaterial = -1;
+		for (size_t m = 0; m < meshes.GetSize(); m++)
+		{
+			const JsonValue &meshPrimitiveList = meshes[m]["primitives"];
+			meshPrimitives.push_back({(uint32_t)primitives.size(), (uint32_t)meshPrimitiveList.GetSize()});
+			for (size_t p = 0; p < meshPrimitiveList.GetSize(); p++)
+			{
+				GltfPrimitive &primitive = primitives.emplace_back();
+				if (!ReadPrimitive(document, meshPrimitiveList[p], primitive))
+				{
+					JN_CORE_WARN("MESH_IMPORT_MSG: Primitive {0} of mesh {1} in {2} is not supported by the glTF importer", p, m, path);
+					return false;
+				}
+
+				primitive.BaseVertex = (uint32_t)vertexCount;
+				primitive.BaseIndex = (uint32_t)indexCount;
+				vertexCount += primitive.Positions.Count;
+				indexCount += primitive.IndexCount;
+
+				int64_t material = meshPrimitiveList[p]["material"].AsInt(-1);
+				if (material < 0 || material >= (int64_t)materials.GetSize())
+				{
+					if (defaultMaterial < 0)
+					{
+						defaultMaterial = (int64_t)contents.Materials.size();
+						contents.Materials.emplace_back().Name = "default";
+					}
+					material = defaultMaterial;
+				}
+				primitive.MaterialIndex = (uint32_t)material;
+			}
+		}
+
+		if (primitives.empty() || vertexCount > UINT32_MAX || indexCount > UINT32_MAX)
+		{
+			JN_CORE_WARN("MESH_IMPORT_MSG: {0} has no geometry the glTF importer can load", path);
+			return false;
+		}
+
+		// Convert the vertex and index streams in chunks across the thread pool
+		std::vector<GltfConversionJob> jobs;
+		for (uint32_t p = 0; p < primitives.size(); p++)
+		{
+			for (uint32_t first = 0; first < primitives[p].Positions.Count; first += s_VerticesPerChunk)
+				jobs.push_back({p, first, std::min(s_VerticesPerChunk, primitives[p].Positions.Count - first), false});
+			for (uint32_t first = 0; first < primitives[p].IndexCount; first += s_IndicesPerChunk)
+				jobs.push_back({p, first, std::min(s_IndicesPerChunk, primitives[p].IndexCount - first), true});
+		}
+
+		imported.Vertices.resize(vertexCount);
+		imported.Indices.resize(indexCount / 3);
+		uint32_t *indices = &imported.Indices[0].V1;
+		std::vector<AABB> jobBounds(jobs.size(), AABB::Empty());
+		std::atomic<bool> indicesValid{true};
+		ThreadPool::Get().ParallelFor((uint32_t)jobs.size(), [&](uint32_t j)
+									  {
+										  const GltfConversionJob &job = jobs[j];
+										  const GltfPrimitive &primitive = primitives[job.Primitive];
+										  if (job.Indices)
+										  {
+											  if (!ConvertIndices(primitive, job.First, job.Count, indices + primitive.BaseIndex))
+												  indicesValid.store(false, std::memory_order_relaxed);
+										  }
+										  else
+										  {
+											  jobBounds[j] = ConvertVertices(primitive, job.First, job.Count, &imported.Vertices[primitive.BaseVertex]);
+										  }
+									  });
+
+		if (!indicesValid)
+		{
+			JN_CORE_ERROR("MESH_IMPORT_MSG: {0} has indices outside their primitive", path);
+			return false;
+		}
+
+		for (uint32_t j = 0; j < jobs.size(); j++)
+			primitives[jobs[j].Primitive].BoundingBox.Expand(jobBounds[j]);
+
+		std::vector<uint32_t> untangented;
+		for (uint32_t p = 0; p < primitives.size(); p++)
+		{
+			if (!primitives[p].HasTangents)
+				untangented.push_back(p);
+		}
+		ThreadPool::Get().ParallelFor((uint32_t)untangented.size(), [&](uint32_t i)
+									  {
+										  const GltfPrimitive &primitive = primitives[untangented[i]];
+										  GenerateTangents(&imported.Vertices[primitive.BaseVertex], primitive.Positions.Count, indices + primitive.BaseIndex, primitive.IndexCount);
+									  });
+
+		// Instance the primitives through the node hierarchy of the default scene
+		const JsonValue &nodes = json["nodes"];
+		const JsonValue &scene = json["scenes"][(size_t)json["scene"].AsInt(0)];
+		const JsonValue &roots = scene["nodes"];
+		for (size_t i = 0; i < roots.GetSize(); i++)
+			TraverseNodes(nodes, roots[i].AsInt(-1), glm::mat4(1.0f), 0, primitives, meshPrimitives, contents.Submeshes);
+		// Files without a scene still hold meshes worth loading
+		if (contents.Submeshes.empty())
+			AddSubmeshes(primitives.data(), (uint32_t)primitives.size(), glm::mat4(1.0f), contents.Submeshes);
+
+		contents.BoundingBox = AABB::Empty();
+		for (auto &submesh : contents.Submeshes)
+			contents.BoundingBox.Expand(submesh.BoundingBox.Transform(submesh.Transform));
+
+		contents.Vertices = imported.Vertices.data();
+		contents.VertexCount = (uint32_t)imported.Vertices.size();
+		contents.Indices = imported.Indices.data();
+		contents.IndexCount = (uint32_t)imported.Indices.size() * 3;
+		mesh = std::move(imported);
+		return true;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+namespace Janus
+{
+	struct ImportedMesh;
+
+	// Direct glTF 2.0 import, for .gltf files with external buffers and for .glb. Buffers are memory mapped
+	// and accessors are converted straight into the engine's vertex layout in parallel chunks on the thread
+	// pool, without going through a generic scene graph. Tangents are taken from the file when it has them
+	// and generated from the texture coordinates otherwise
+	class GltfImporter
+	{
+	public:
+		static bool IsGltfPath(const std::string &path);
+
+		// Returns false if the file cannot be read or uses something outside this importer: embedded data
+		// URIs, sparse accessors, non-triangle primitives, primitives without normals or required extensions
+		// such as mesh compression. Such files are left to Assimp
+		static bool Import(const std::string &path, ImportedMesh &mesh);
+	};
+}
@@ -4,6 +4,7 @@
 
 #include "Graphics/IndexBuffer.h"
 #include "Graphics/Renderer.h"
+#include "Graphics/RenderStateCache.h"
 
 namespace Janus
 {
@@ -19,24 +20,38 @@ namespace Janus
                      });
   }
 
+  IndexBuffer::IndexBuffer(uint32_t size)
+      : m_RendererID(0), m_Size(size)
+  {
+    Ref<IndexBuffer> instance = this;
+    Renderer::Submit([instance]() mutable
+                     {
+                       glCreateBuffers(1, &instance->m_RendererID);
+                       glNamedBufferData(instance->m_RendererID, instance->m_Size, nullptr, GL_STATIC_DRAW);
+                     });
+  }
+
   IndexBuffer::~IndexBuffer()
   {
     GLuint rendererID = m_RendererID;
     Renderer::Submit([rendererID]()
-                     { glDeleteBuffers(1, &rendererID); });
+                     {
+                       glDeleteBuffers(1, &rendererID);
+                       RenderStateCache::OnBuffersDeleted(1, &rendererID);
+                     });
   }
 
   void IndexBuffer::Bind()
   {
     Ref<IndexBuffer> instance = this;
     Renderer::Submit([instance]()
-                     { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, instance->m_RendererID); });
+                     { RenderStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, instance->m_RendererID); });
   }
 
   void IndexBuffer::Unbind()
   {
     Ref<IndexBuffer> instance = this;
     Renderer::Submit([instance]()
-                     { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); });
+                     { RenderStateCache::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); });
   }
 }
\ No newline at end of file
@@ -4,14 +4,26 @@
 #include "Core/Buffer.h"
 
 namespace Janus {
+    // Element type of a range of indices
+    enum class IndexFormat : uint8_t
+    {
+        UInt16 = 0,
+        UInt32
+    };
+
+    inline uint32_t GetIndexSize(IndexFormat format) { return format == IndexFormat::UInt16 ? 2 : 4; }
+
     class IndexBuffer : public RefCounted
     {
     public:
         IndexBuffer(void *indices, uint32_t size);
+        // Uninitialized storage of the given size in bytes, filled later with glNamedBufferSubData
+        IndexBuffer(uint32_t size);
         ~IndexBuffer();
         void Bind();
         void Unbind();
         uint32_t getSize() const { return m_Size; };
+        uint32_t GetRendererID() const { return m_RendererID; }
 
     private:
         uint32_t m_RendererID;
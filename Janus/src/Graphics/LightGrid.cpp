@@ -0,0 +1,224 @@
+#include "jnpch.h"
+#include "Graphics/LightGrid.h"
+
+#include "Core/ThreadPool.h"
+#include "Scene/Scene.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define JN_LIGHT_GRID_SSE 1
+	#include <xmmintrin.h>
+#else
+	#define JN_LIGHT_GRID_SSE 0
+#endif
+
+namespace Janus
+{
+	// Padding spheres sit far behind the camera with no radius, so they fail every test
+	static constexpr float s_PaddingDepth = 1e30f;
+
+	// Index of the lowest set bit of a non-zero four bit mask
+	static uint32_t LowestBit(int mask)
+	{
+		return (mask & 1) ? 0 : (mask & 2) ? 1 : (mask & 4) ? 2 : 3;
+	}
+
+	// Bit i is set when sphere i of the four given overlaps the view depth range [minZ, maxZ]
+	static int DepthOverlapMask4(const float *z, const float *radius, float minZ, float maxZ)
+	{
+#if JN_LIGHT_GRID_SSE
+		__m128 center = _mm_loadu_ps(z);
+		__m128 r = _mm_loadu_ps(radius);
+		__m128 front = _mm_cmpge_ps(_mm_add_ps(center, r), _mm_set1_ps(minZ));
+		__m128 back = _mm_cmple_ps(_mm_sub_ps(center, r), _mm_set1_ps(maxZ));
+		return _mm_movemask_ps(_mm_and_ps(front, back));
+#else
+		int mask = 0;
+		for (int i = 0; i < 4; i++)
+			mask |= (z[i] + radius[i] >= minZ && z[i] - radius[i] <= maxZ) << i;
+		return mask;
+#endif
+	}
+
+	// Bit i is set when sphere i of the four given intersects the box
+	static int SphereBoxMask4(const float *x, const float *y, const float *z, const float *radius, const glm::vec3 &min, const glm::vec3 &max)
+	{
+#if JN_LIGHT_GRID_SSE
+		// Distance from the center to the box along each axis; at most one side can be positive
+		const __m128 zero = _mm_setzero_ps();
+		auto axisDistance = [&zero](const float *center, float min, float max)
+		{
+			__m128 c = _mm_loadu_ps(center);
+			__m128 d = _mm_max_ps(_mm_sub_ps(_mm_set1_ps(min), c), _mm_sub_ps(c, _mm_set1_ps(max)));
+			d = _mm_max_ps(d, zero);
+			return _mm_mul_ps(d, d);
+		};
+
+		__m128 distance2 = _mm_add_ps(_mm_add_ps(axisDistance(x, min.x, max.x), axisDistance(y, min.y, max.y)), axisDistance(z, min.z, max.z));
+		__m128 r = _mm_loadu_ps(radius);
+		return _mm_movemask_ps(_mm_cmple_ps(distance2, _mm_mul_ps(r, r)));
+#else
+		int mask = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			float dx = std::max(std::max(min.x - x[i], x[i] - max.x), 0.0f);
+			float dy = std::max(std::max(min.y - y[i], y[i] - max.y), 0.0f);
+			float dz = std::max(std::max(min.z - z[i], z[i] - max.z), 0.0f);
+			mask |= (dx * dx + dy * dy + dz * dz <= radius[i] * radius[i]) << i;
+		}
+		return mask;
+#endif
+	}
+
+	void LightGrid::Spheres::Clear()
+	{
+		X.clear();
+		Y.clear();
+		Z.clear();
+		Radius.clear();
+	}
+
+	void LightGrid::Spheres::Add(float x, float y, float z, float radius)
+	{
+		X.push_back(x);
+		Y.push_back(y);
+		Z.push_back(z);
+		Radius.push_back(radius);
+	}
+
+	void LightGrid::Spheres::Pad()
+	{
+		while (X.size() % 4)
+			Add(0.0f, 0.0f, s_PaddingDepth, 0.0f);
+	}
+
+	float LightGrid::GetSliceDepth(uint32_t slice) const
+	{
+		return m_Near * std::pow(m_Far / m_Near, (float)slice / Slices);
+	}
+
+	glm::vec2 LightGrid::GetSliceScaleBias() const
+	{
+		// Inverse of GetSliceDepth: slice = Slices * log(depth / near) / log(far / near)
+		float scale = Slices / std::log(m_Far / m_Near);
+		return {scale, -std::log(m_Near) * scale};
+	}
+
+	void LightGrid::SetProjection(const glm::mat4 &projection, float nearClip, float farClip)
+	{
+		if (projection == m_Projection && nearClip == m_Near && farClip == m_Far)
+			return;
+
+		JN_PROFILE_FUNCTION();
+		m_Projection = projection;
+		m_Near = nearClip;
+		m_Far = farClip;
+
+		// A perspective projection maps view x at depth d to ndc (P00 * x - P20 * d) / d, and likewise for y
+		auto toViewX = [&](float ndc, float depth)
+		{ return (ndc + projection[2][0]) * depth / projection[0][0]; };
+		auto toViewY = [&](float ndc, float depth)
+		{ return (ndc + projection[2][1]) * depth / projection[1][1]; };
+
+		m_ClusterMin.resize(ClusterCount);
+		m_ClusterMax.resize(ClusterCount);
+		for (uint32_t slice = 0; slice < Slices; slice++)
+		{
+			float nearDepth = GetSliceDepth(slice);
+			float farDepth = GetSliceDepth(slice + 1);
+			for (uint32_t y = 0; y < TilesY; y++)
+			{
+				float bottom = -1.0f + 2.0f * y / TilesY;
+				float top = -1.0f + 2.0f * (y + 1) / TilesY;
+				for (uint32_t x = 0; x < TilesX; x++)
+				{
+					float left = -1.0f + 2.0f * x / TilesX;
+					float right = -1.0f + 2.0f * (x + 1) / TilesX;
+
+					// The tile widens with depth, so its bounds are spanned by the corners at both ends
+					uint32_t index = x + y * TilesX + slice * TilesX * TilesY;
+					glm::vec3 &min = m_ClusterMin[index];
+					glm::vec3 &max = m_ClusterMax[index];
+					min.x = std::min(toViewX(left, nearDepth), toViewX(left, farDepth));
+					max.x = std::max(toViewX(right, nearDepth), toViewX(right, farDepth));
+					min.y = std::min(toViewY(bottom, nearDepth), toViewY(bottom, farDepth));
+					max.y = std::max(toViewY(top, nearDepth), toViewY(top, farDepth));
+					// The camera looks down -z
+					min.z = -farDepth;
+					max.z = -nearDepth;
+				}
+			}
+		}
+	}
+
+	void LightGrid::Build(const std::vector<PointLight> &lights, const glm::mat4 &view)
+	{
+		JN_PROFILE_FUNCTION();
+		JN_ASSERT(m_Near > 0.0f && m_Far > m_Near, "LIGHT_GRID_ERROR: SetProjection must be called before Build!");
+
+		m_Lights.Clear();
+		for (const PointLight &light : lights)
+		{
+			glm::vec3 position = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+			m_Lights.Add(position.x, position.y, position.z, light.Radius);
+		}
+		m_Lights.Pad();
+
+		m_Clusters.resize(ClusterCount);
+		m_Scratch.resize(Slices);
+		ThreadPool::Get().ParallelFor(Slices, [this](uint32_t slice)
+									  { BinSlice(slice); });
+
+		// Concatenate the slices' lists in slice order and make the offsets global
+		m_LightIndices.clear();
+		for (uint32_t slice = 0; slice < Slices; slice++)
+		{
+			uint32_t base = (uint32_t)m_LightIndices.size();
+			Cluster *clusters = &m_Clusters[slice * TilesX * TilesY];
+			for (uint32_t i = 0; i < TilesX * TilesY; i++)
+				clusters[i].Offset += base;
+
+			auto &indices = m_Scratch[slice].LightIndices;
+			m_LightIndices.insert(m_LightIndices.end(), indices.begin(), indices.end());
+		}
+	}
+
+	void LightGrid::BinSlice(uint32_t slice)
+	{
+		JN_PROFILE_FUNCTION();
+		SliceScratch &scratch = m_Scratch[slice];
+		scratch.Candidates.Clear();
+		scratch.CandidateLights.clear();
+		scratch.LightIndices.clear();
+
+		// Narrow the lights down to the ones reaching the slice's depth range, then test those per tile
+		float minZ = -GetSliceDepth(slice + 1);
+		float maxZ = -GetSliceDepth(slice);
+		const Spheres &lights = m_Lights;
+		for (uint32_t i = 0; i < lights.GetCount(); i += 4)
+		{
+			int mask = DepthOverlapMask4(&lights.Z[i], &lights.Radius[i], minZ, maxZ);
+			for (; mask; mask &= mask - 1)
+			{
+				uint32_t light = i + LowestBit(mask);
+				scratch.Candidates.Add(lights.X[light], lights.Y[light], lights.Z[light], lights.Radius[light]);
+				scratch.CandidateLights.push_back(light);
+			}
+		}
+		scratch.Candidates.Pad();
+
+		const Spheres &candidates = scratch.Candidates;
+		uint32_t first = slice * TilesX * TilesY;
+		for (uint32_t index = first; index < first + TilesX * TilesY; index++)
+		{
+			Cluster &cluster = m_Clusters[index];
+			cluster.Offset = (uint32_t)scratch.LightIndices.size();
+			for (uint32_t i = 0; i < candidates.GetCount(); i += 4)
+			{
+				int mask = SphereBoxMask4(&candidates.X[i], &candidates.Y[i], &candidates.Z[i], &candidates.Radius[i], m_ClusterMin[index], m_ClusterMax[index]);
+				for (; mask; mask &= mask - 1)
+					scratch.LightIndices.push_back(scratch.CandidateLights[i + LowestBit(mask)]);
+			}
+			cluster.Count = (uint32_t)scratch.LightIndices.size() - cluster.Offset;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Janus
+{
+	struct PointLight;
+
+	// Clustered light culling. The view frustum is split into screen tiles and exponentially spaced depth
+	// slices, and every cluster gets the list of point lights whose sphere of influence reaches it, so
+	// shading only loops over the lights that can affect a pixel. Slices are binned in parallel on the
+	// thread pool, testing four lights at a time with SSE
+	class LightGrid
+	{
+	public:
+		static constexpr uint32_t TilesX = 16;
+		static constexpr uint32_t TilesY = 9;
+		static constexpr uint32_t Slices = 24;
+		static constexpr uint32_t ClusterCount = TilesX * TilesY * Slices;
+
+		// std430 mirror of an r_LightGrid entry. The cluster's lights are LightIndices[Offset, Offset + Count)
+		struct Cluster
+		{
+			uint32_t Offset;
+			uint32_t Count;
+		};
+
+		// Recomputes the view space bounds of the clusters when the projection has changed
+		void SetProjection(const glm::mat4 &projection, float nearClip, float farClip);
+		// Lights are indexed in the order given
+		void Build(const std::vector<PointLight> &lights, const glm::mat4 &view);
+
+		// Indexed by x + y * TilesX + slice * TilesX * TilesY, with tile 0 at the bottom left of the screen
+		const std::vector<Cluster> &GetClusters() const { return m_Clusters; }
+		const std::vector<uint32_t> &GetLightIndices() const { return m_LightIndices; }
+		// The slice of a view depth is log(depth) * x + y
+		glm::vec2 GetSliceScaleBias() const;
+
+	private:
+		float GetSliceDepth(uint32_t slice) const;
+		void BinSlice(uint32_t slice);
+
+	private:
+		// View space spheres as arrays of four
+		struct Spheres
+		{
+			std::vector<float> X, Y, Z, Radius;
+
+			void Clear();
+			void Add(float x, float y, float z, float radius);
+			// Pads to a multiple of four with spheres that reach no cluster
+			void Pad();
+			uint32_t GetCount() const { return (uint32_t)X.size(); }
+		};
+
+		// Written by one slice job only
+		struct SliceScratch
+		{
+			Spheres Candidates;
+			std::vector<uint32_t> CandidateLights;
+			std::vector<uint32_t> LightIndices;
+		};
+
+		glm::mat4 m_Projection = glm::mat4(0.0f);
+		float m_Near = 0.0f, m_Far = 0.0f;
+		// View space bounds of every cluster, in cluster order
+		std::vector<glm::vec3> m_ClusterMin, m_ClusterMax;
+		Spheres m_Lights;
+		std::vector<SliceScratch> m_Scratch;
+
+		std::vector<Cluster> m_Clusters;
+		std::vector<uint32_t> m_LightIndices;
+	};
+}
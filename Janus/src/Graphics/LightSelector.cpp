@@ -0,0 +1,157 @@
+#include "jnpch.h"
+#include "Graphics/LightSelector.h"
+
+#include "Core/ThreadPool.h"
+#include "Scene/Scene.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define JN_LIGHT_SELECTOR_SSE 1
+	#include <xmmintrin.h>
+#else
+	#define JN_LIGHT_SELECTOR_SSE 0
+#endif
+
+namespace Janus
+{
+	static_assert(LightSelector::MaxLights == 8, "Selections are packed into a uvec4 of 16 bit indices");
+
+	// Boxes rated by one job
+	static constexpr uint32_t s_BoxesPerChunk = 64;
+
+	// Influence of four lights on a box: the light's attenuation at the nearest point of the box, as
+	// janus_pbr.glsl computes it, scaled by its brightest radiance channel and intensity
+	static void Influence4(const float *x, const float *y, const float *z, const float *inverseRadius2, const float *falloff, const float *weight,
+						   const glm::vec3 &min, const glm::vec3 &max, float *influence)
+	{
+#if JN_LIGHT_SELECTOR_SSE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		auto axisDistance = [&zero](const float *position, float min, float max)
+		{
+			__m128 p = _mm_loadu_ps(position);
+			__m128 d = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(min), p), _mm_sub_ps(p, _mm_set1_ps(max))), zero);
+			return _mm_mul_ps(d, d);
+		};
+
+		__m128 distance2 = _mm_add_ps(_mm_add_ps(axisDistance(x, min.x, max.x), axisDistance(y, min.y, max.y)), axisDistance(z, min.z, max.z));
+		__m128 attenuation = _mm_sub_ps(one, _mm_mul_ps(distance2, _mm_loadu_ps(inverseRadius2)));
+		attenuation = _mm_min_ps(_mm_max_ps(attenuation, zero), one);
+		// attenuation * mix(attenuation, 1, falloff)
+		__m128 f = _mm_loadu_ps(falloff);
+		__m128 mixed = _mm_add_ps(attenuation, _mm_mul_ps(_mm_sub_ps(one, attenuation), f));
+		_mm_storeu_ps(influence, _mm_mul_ps(_mm_mul_ps(attenuation, mixed), _mm_loadu_ps(weight)));
+#else
+		for (int i = 0; i < 4; i++)
+		{
+			float dx = std::max(std::max(min.x - x[i], x[i] - max.x), 0.0f);
+			float dy = std::max(std::max(min.y - y[i], y[i] - max.y), 0.0f);
+			float dz = std::max(std::max(min.z - z[i], z[i] - max.z), 0.0f);
+			float attenuation = std::min(std::max(1.0f - (dx * dx + dy * dy + dz * dz) * inverseRadius2[i], 0.0f), 1.0f);
+			influence[i] = attenuation * (attenuation + (1.0f - attenuation) * falloff[i]) * weight[i];
+		}
+#endif
+	}
+
+	void LightSelector::Lights::Clear()
+	{
+		X.clear();
+		Y.clear();
+		Z.clear();
+		InverseRadius2.clear();
+		Falloff.clear();
+		Weight.clear();
+	}
+
+	void LightSelector::Lights::Add(const glm::vec3 &position, float radius, float falloff, float weight)
+	{
+		X.push_back(position.x);
+		Y.push_back(position.y);
+		Z.push_back(position.z);
+		// A light without a radius reaches nothing, which a zero weight expresses without dividing by zero
+		InverseRadius2.push_back(radius > 0.0f ? 1.0f / (radius * radius) : 0.0f);
+		Falloff.push_back(falloff);
+		Weight.push_back(radius > 0.0f ? weight : 0.0f);
+	}
+
+	void LightSelector::SetLights(const std::vector<PointLight> &lights)
+	{
+		JN_PROFILE_FUNCTION();
+		m_Lights.Clear();
+		uint32_t count = std::min((uint32_t)lights.size(), NoLight);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const PointLight &light = lights[i];
+			float radiance = std::max(std::max(light.Radiance.x, light.Radiance.y), light.Radiance.z);
+			m_Lights.Add(light.Position, light.Radius, light.Falloff, radiance * light.Intensity);
+		}
+		while (m_Lights.GetCount() % 4)
+			m_Lights.Add(glm::vec3(0.0f), 0.0f, 0.0f, 0.0f);
+	}
+
+	void LightSelector::Select(const std::vector<AABB> &bounds, std::vector<glm::uvec4> &selections) const
+	{
+		JN_PROFILE_FUNCTION();
+		uint32_t count = (uint32_t)bounds.size();
+		selections.resize(count);
+		uint32_t chunkCount = (count + s_BoxesPerChunk - 1) / s_BoxesPerChunk;
+		if (chunkCount <= 1)
+		{
+			SelectChunk(bounds.data(), selections.data(), count);
+			return;
+		}
+
+		ThreadPool::Get().ParallelFor(chunkCount, [&](uint32_t chunk)
+									  {
+										  uint32_t first = chunk * s_BoxesPerChunk;
+										  SelectChunk(&bounds[first], &selections[first], std::min(s_BoxesPerChunk, count - first));
+									  });
+	}
+
+	void LightSelector::SelectChunk(const AABB *bounds, glm::uvec4 *selections, uint32_t count) const
+	{
+		const Lights &lights = m_Lights;
+		for (uint32_t box = 0; box < count; box++)
+		{
+			// Best lights so far, sorted by descending influence. A light has to beat the last one to get in,
+			// and lights without influence never do
+			float bestInfluence[MaxLights];
+			uint32_t bestLights[MaxLights];
+			uint32_t bestCount = 0;
+			float threshold = 0.0f;
+
+			const glm::vec3 &min = bounds[box].Min;
+			const glm::vec3 &max = bounds[box].Max;
+			for (uint32_t i = 0; i < lights.GetCount(); i += 4)
+			{
+				float influence[4];
+				Influence4(&lights.X[i], &lights.Y[i], &lights.Z[i], &lights.InverseRadius2[i], &lights.Falloff[i], &lights.Weight[i], min, max, influence);
+				for (uint32_t j = 0; j < 4; j++)
+				{
+					if (influence[j] <= threshold)
+						continue;
+
+					uint32_t slot = std::min(bestCount, MaxLights - 1);
+					for (; slot > 0 && bestInfluence[slot - 1] < influence[j]; slot--)
+					{
+						bestInfluence[slot] = bestInfluence[slot - 1];
+						bestLights[slot] = bestLights[slot - 1];
+					}
+					bestInfluence[slot] = influence[j];
+					bestLights[slot] = i + j;
+					bestCount = std::min(bestCount + 1, MaxLights);
+					if (bestCount == MaxLights)
+						threshold = bestInfluence[MaxLights - 1];
+				}
+			}
+
+			uint32_t packed[MaxLights / 2];
+			for (uint32_t slot = 0; slot < MaxLights; slot += 2)
+			{
+				uint32_t low = slot < bestCount ? bestLights[slot] : NoLight;
+				uint32_t high = slot + 1 < bestCount ? bestLights[slot + 1] : NoLight;
+				packed[slot / 2] = low | high << 16;
+			}
+			selections[box] = glm::uvec4(packed[0], packed[1], packed[2], packed[3]);
+		}
+	}
+}
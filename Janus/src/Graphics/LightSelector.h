@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Math/AABB.h"
+
+namespace Janus
+{
+	struct PointLight;
+
+	// Per-draw light selection for forward rendering. Every draw gets the few point lights that contribute the
+	// most to it, rated by the light's attenuation at the nearest point of the draw's world bounds, so the
+	// shader loops over a fixed number of lights instead of every light in the scene. Draws are rated in
+	// parallel chunks on the thread pool, four lights at a time with SSE
+	class LightSelector
+	{
+	public:
+		static constexpr uint32_t MaxLights = 8;
+		// Index of an empty slot. Lights from this index up are never selected
+		static constexpr uint32_t NoLight = 0xffff;
+
+		// Lights are indexed in the order given
+		void SetLights(const std::vector<PointLight> &lights);
+
+		// Writes the selection for every box, most influential light first. The MaxLights indices are
+		// packed two per component, the first in the low 16 bits, and unused slots hold NoLight
+		void Select(const std::vector<AABB> &bounds, std::vector<glm::uvec4> &selections) const;
+
+	private:
+		void SelectChunk(const AABB *bounds, glm::uvec4 *selections, uint32_t count) const;
+
+	private:
+		// World space lights as arrays of four, padded with lights that have no influence
+		struct Lights
+		{
+			std::vector<float> X, Y, Z, InverseRadius2, Falloff, Weight;
+
+			void Clear();
+			void Add(const glm::vec3 &position, float radius, float falloff, float weight);
+			uint32_t GetCount() const { return (uint32_t)X.size(); }
+		};
+
+		Lights m_Lights;
+	};
+}
@@ -0,0 +1,48 @@
+#include "jnpch.h"
+#include "Graphics/LodSelector.h"
+
+#include "Graphics/Mesh.h"
+
+namespace Janus
+{
+	void LodSelector::SetProjection(const glm::mat4 &projection, uint32_t viewportHeight)
+	{
+		// View space looks down -z, so depth d sits at z = -d
+		m_DepthToW = {-projection[2][3], projection[3][3]};
+		m_PixelScale = projection[1][1] * viewportHeight * 0.5f;
+	}
+
+	void LodSelector::NextFrame()
+	{
+		std::swap(m_Previous, m_Current);
+		m_Current.clear();
+	}
+
+	uint32_t LodSelector::Select(uint64_t key, const void *owner, const Submesh &submesh, float depth, float radius, float maxPixelError)
+	{
+		if (submesh.LodCount <= 1 || maxPixelError <= 0.0f)
+			return 0;
+
+		// Measured at the near side of the sphere; cameras inside it get full detail
+		float w = m_DepthToW.x * (depth - radius) + m_DepthToW.y;
+		uint32_t lod = 0;
+		if (w > 0.0f)
+		{
+			auto previous = m_Previous.find(key);
+			uint32_t previousLod = previous != m_Previous.end() && previous->second.Owner == owner ? previous->second.Lod : Submesh::MaxLods;
+			float radiusPixels = radius * m_PixelScale / w;
+			for (uint32_t level = submesh.LodCount - 1; level > 0; level--)
+			{
+				float allowedError = level > previousLod ? maxPixelError * Hysteresis : maxPixelError;
+				if (submesh.GetLod(level).Error * radiusPixels <= allowedError)
+				{
+					lod = level;
+					break;
+				}
+			}
+		}
+
+		m_Current[key] = {owner, lod};
+		return lod;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+namespace Janus
+{
+	class Submesh;
+
+	// Per-draw level of detail selection. A level's error is relative to the submesh's bounding radius, so
+	// scaling it by the projected radius of the draw's bounding sphere gives the error in pixels, and the
+	// coarsest level within the allowed error is drawn. A draw only moves to a coarser level once it is well
+	// within the error, so draws near a threshold do not flicker between levels from frame to frame
+	class LodSelector
+	{
+	public:
+		// Share of the allowed error a coarser level than last frame's has to be within
+		static constexpr float Hysteresis = 0.75f;
+
+		void SetProjection(const glm::mat4 &projection, uint32_t viewportHeight);
+
+		// Starts a frame. Draws selected in the previous frame are remembered, others are forgotten
+		void NextFrame();
+
+		// key identifies the draw from frame to frame and owner the mesh it draws, so a key reused for another
+		// mesh starts afresh. depth is the view space depth of the bounding sphere's centre
+		uint32_t Select(uint64_t key, const void *owner, const Submesh &submesh, float depth, float radius, float maxPixelError);
+
+	private:
+		struct Selection
+		{
+			const void *Owner;
+			uint32_t Lod;
+		};
+
+		// Clip w of a view space depth is DepthToW.x * depth + DepthToW.y; pixels per unit at clip w = 1
+		glm::vec2 m_DepthToW{1.0f, 0.0f};
+		float m_PixelScale = 1.0f;
+		std::unordered_map<uint64_t, Selection> m_Previous, m_Current;
+	};
+}
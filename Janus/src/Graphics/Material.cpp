@@ -1,10 +1,237 @@
 #include "jnpch.h"
 
+#include <mutex>
+
 #include "Graphics/Material.h"
 #include "Graphics/Light.h"
+#include "Graphics/Renderer.h"
 
 namespace Janus
 {
+	// Neighbouring dirty block members closer than this are uploaded as one range
+	static constexpr uint32_t s_UniformRangeMergeGap = 16;
+
+	// Gives every material owned uniform block of the shader its storage and uniform buffer. The storage
+	// starts out as a copy of source when one is given
+	static void AllocateUniformBlocks(const Ref<Shader> &shader, std::vector<MaterialUniformBlock> &blocks, const std::vector<MaterialUniformBlock> *source)
+	{
+		const auto &declarations = shader->GetUniformBlocks();
+		blocks.resize(declarations.size());
+		for (size_t i = 0; i < declarations.size(); i++)
+		{
+			const auto &declaration = declarations[i];
+			if (Shader::IsRendererUniformBlock(*declaration))
+				continue;
+
+			auto &block = blocks[i];
+			block.Storage.Allocate(declaration->GetSize());
+			if (source)
+				memcpy(block.Storage.Data, (*source)[i].Storage.Data, declaration->GetSize());
+			else
+				block.Storage.ZeroInitialize();
+			block.GPUBuffer = Ref<UniformBuffer>::Create(declaration->GetSize(), declaration->GetRegister());
+		}
+	}
+
+	// Mask of the uniforms that are not in a block. The shader numbers them before any block member
+	static ShaderUniformMask GetLooseUniformMask(const Ref<Shader> &shader)
+	{
+		uint32_t count = 0;
+		if (shader->HasVSMaterialUniformBuffer())
+			count += (uint32_t)shader->GetVSMaterialUniformBuffer().GetUniformDeclarations().size();
+		if (shader->HasPSMaterialUniformBuffer())
+			count += (uint32_t)shader->GetPSMaterialUniformBuffer().GetUniformDeclarations().size();
+
+		ShaderUniformMask mask;
+		for (uint32_t i = 0; i < count; i++)
+			mask.set(i);
+		return mask;
+	}
+
+	// Uploads the dirty uniforms and clears the mask. Dirty block members go straight to the block's buffer,
+	// one range per run of neighbouring members. Loose uniforms are staged for the render thread, which
+	// sends them to the program the next time the material is bound
+	static void FlushDirtyUniforms(const Ref<Shader> &shader, ShaderUniformMask &dirty, Buffer vsStorage, Buffer psStorage,
+								   std::vector<MaterialUniformBlock> &blocks, const Ref<MaterialUniformUploads> &uploads)
+	{
+		if (dirty.none())
+			return;
+
+		JN_PROFILE_FUNCTION();
+		const auto &declarations = shader->GetUniformBlocks();
+		for (size_t i = 0; i < declarations.size(); i++)
+		{
+			auto &block = blocks[i];
+			if (!block.GPUBuffer)
+				continue;
+
+			uint32_t rangeBegin = 0, rangeEnd = 0;
+			for (ShaderUniformDeclaration *uniform : declarations[i]->GetUniformDeclarations())
+			{
+				if (!dirty.test(uniform->GetMaterialIndex()))
+					continue;
+
+				uint32_t begin = uniform->GetOffset();
+				if (rangeEnd > rangeBegin && begin - rangeEnd >= s_UniformRangeMergeGap)
+				{
+					block.GPUBuffer->SetData(block.Storage.Data + rangeBegin, rangeEnd - rangeBegin, rangeBegin);
+					rangeEnd = rangeBegin;
+				}
+				if (rangeEnd == rangeBegin)
+					rangeBegin = begin;
+				rangeEnd = begin + uniform->GetSize();
+			}
+			if (rangeEnd > rangeBegin)
+				block.GPUBuffer->SetData(block.Storage.Data + rangeBegin, rangeEnd - rangeBegin, rangeBegin);
+		}
+
+		ShaderUniformMask looseDirty = dirty & GetLooseUniformMask(shader);
+		if (uploads && looseDirty.any())
+		{
+			Buffer vsSnapshot = vsStorage ? Buffer::Copy(vsStorage.Data, vsStorage.Size) : Buffer();
+			Buffer psSnapshot = psStorage ? Buffer::Copy(psStorage.Data, psStorage.Size) : Buffer();
+			Ref<MaterialUniformUploads> target = uploads;
+			Renderer::Submit([target, vsSnapshot, psSnapshot, looseDirty]() mutable
+							 {
+								 target->VSStorage.Release();
+								 target->PSStorage.Release();
+								 target->VSStorage = vsSnapshot;
+								 target->PSStorage = psSnapshot;
+								 target->Dirty |= looseDirty;
+							 });
+		}
+		dirty.reset();
+	}
+
+	// Sends the staged loose uniforms to the program: nothing if it still holds this material's values, only
+	// the changed ones if it held them before they changed, everything otherwise
+	static void BindLooseUniforms(const Ref<Shader> &shader, const Ref<MaterialUniformUploads> &uploads)
+	{
+		if (!uploads)
+			return;
+
+		Ref<Shader> program = shader;
+		Ref<MaterialUniformUploads> source = uploads;
+		Renderer::Submit([program, source]() mutable
+						 {
+							 // Generations are handed out on the render thread only
+							 static uint64_t s_Generation = 0;
+
+							 bool holdsValues = source->Generation != 0 && program->GetMaterialGeneration() == source->Generation;
+							 if (holdsValues && source->Dirty.none())
+								 return;
+
+							 program->UploadMaterialUniforms(source->VSStorage, source->PSStorage, holdsValues ? source->Dirty : ShaderUniformMask().set());
+							 source->Dirty.reset();
+							 if (!holdsValues)
+							 {
+								 source->Generation = ++s_Generation;
+								 program->SetMaterialGeneration(source->Generation);
+							 }
+						 });
+	}
+
+	static void BindUniformBlocks(const std::vector<MaterialUniformBlock> &blocks)
+	{
+		for (auto &block : blocks)
+		{
+			if (block.GPUBuffer)
+				block.GPUBuffer->Bind();
+		}
+	}
+
+	static void ReleaseUniformBlocks(std::vector<MaterialUniformBlock> &blocks)
+	{
+		for (auto &block : blocks)
+			block.Storage.Release();
+	}
+
+	// Every uniform starts out dirty so the first bind uploads all of them
+	static ShaderUniformMask GetAllUniformsMask(const Ref<Shader> &shader)
+	{
+		ShaderUniformMask mask;
+		for (uint32_t i = 0; i < shader->GetMaterialUniformCount(); i++)
+			mask.set(i);
+		return mask;
+	}
+
+	// A keyword is enabled while its texture is set and its toggle is non zero, so the variant leaves out
+	// the texture fetches and branches the material would never take
+	template <typename HasTextureFn, typename GetToggleFn>
+	static uint32_t GetKeywordMask(const Ref<Shader> &shader, HasTextureFn hasTexture, GetToggleFn getToggle)
+	{
+		uint32_t mask = 0;
+		const auto &keywords = shader->GetKeywords();
+		for (uint32_t i = 0; i < keywords.size(); i++)
+		{
+			const ShaderKeyword &keyword = keywords[i];
+			if (!keyword.Texture && !keyword.Toggle)
+				continue;
+			if (keyword.Texture && !hasTexture(keyword.Texture->GetRegister()))
+				continue;
+			if (keyword.Toggle && getToggle(keyword.Toggle) == 0.0f)
+				continue;
+			mask |= 1u << i;
+		}
+		return mask;
+	}
+
+	// Copies the values of the uniforms selected by mask (previous indices) that the current layout still
+	// declares with the same type and count. Returns the uniforms carried over, in current indices
+	template <typename PreviousTargetFn, typename CurrentTargetFn>
+	static ShaderUniformMask RemapUniforms(const Shader &previous, const Ref<Shader> &current, const ShaderUniformMask &mask,
+										   PreviousTargetFn previousTarget, CurrentTargetFn currentTarget)
+	{
+		ShaderUniformMask carried;
+		for (auto &[id, previousDecl] : previous.GetMaterialUniforms())
+		{
+			if (!mask.test(previousDecl->GetMaterialIndex()))
+				continue;
+
+			ShaderUniformDeclaration *decl = current->FindMaterialUniform(id);
+			if (!decl || decl->GetType() != previousDecl->GetType() || decl->GetCount() != previousDecl->GetCount())
+				continue;
+			if (decl->GetType() == ShaderUniformDeclaration::Type::STRUCT && decl->GetSize() != previousDecl->GetSize())
+				continue;
+
+			Buffer &source = previousTarget(previousDecl);
+			Buffer &destination = currentTarget(decl);
+			// Array strides differ between loose and std140 uniforms, so only single values move between them
+			uint32_t size = std::min(decl->GetSize(), previousDecl->GetSize());
+			memcpy(destination.Data + decl->GetOffset(), source.Data + previousDecl->GetOffset(), size);
+			carried.set(decl->GetMaterialIndex());
+		}
+		return carried;
+	}
+
+	// Moves every texture to the register the current layout gives a resource of the same name
+	static std::vector<Ref<Texture>> RemapTextures(const Shader &previous, const Ref<Shader> &current, const std::vector<Ref<Texture>> &textures)
+	{
+		std::vector<Ref<Texture>> result;
+		for (ShaderResourceDeclaration *previousResource : previous.GetResources())
+		{
+			uint32_t previousSlot = previousResource->GetRegister();
+			if (previousSlot >= textures.size() || !textures[previousSlot])
+				continue;
+
+			for (ShaderResourceDeclaration *resource : current->GetResources())
+			{
+				if (resource->GetName() != previousResource->GetName())
+					continue;
+
+				if (result.size() <= resource->GetRegister())
+					result.resize((size_t)resource->GetRegister() + 1);
+				result[resource->GetRegister()] = textures[previousSlot];
+				break;
+			}
+		}
+		return result;
+	}
+
+	// Lets a reloaded shader find the materials built on it. Materials are often released on the render
+	// thread, so the set is guarded by a mutex
+	static std::unordered_set<Material *> s_Materials;
+	static std::mutex s_MaterialsMutex;
 
 	Ref<Material> Material::Create(const Ref<Shader> &shader, const std::string& name)
 	{
@@ -16,6 +243,63 @@ namespace Janus
 		AllocateStorage();
 		m_MaterialFlags |= (uint32_t)MaterialFlag::DepthTest;
 		m_MaterialFlags |= (uint32_t)MaterialFlag::Blend;
+		std::lock_guard<std::mutex> lock(s_MaterialsMutex);
+		s_Materials.insert(this);
+	}
+
+	Material::~Material()
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_MaterialsMutex);
+			s_Materials.erase(this);
+		}
+		ReleaseUniformBlocks(m_UniformBlocks);
+	}
+
+	void Material::OnShaderReloaded(const Ref<Shader> &shader, const Shader &previous)
+	{
+		JN_PROFILE_FUNCTION();
+		// A material being destroyed waits here before releasing anything RemapStorage touches
+		std::lock_guard<std::mutex> lock(s_MaterialsMutex);
+		for (Material *material : s_Materials)
+		{
+			if (material->m_Shader.Raw() == shader.Raw())
+				material->RemapStorage(previous);
+		}
+	}
+
+	void Material::RemapStorage(const Shader &previous)
+	{
+		Buffer previousVS = m_VSUniformStorageBuffer;
+		Buffer previousPS = m_PSUniformStorageBuffer;
+		std::vector<MaterialUniformBlock> previousBlocks = std::move(m_UniformBlocks);
+		m_VSUniformStorageBuffer = Buffer();
+		m_PSUniformStorageBuffer = Buffer();
+		m_UniformBlocks.clear();
+		m_UniformUploads = nullptr;
+
+		// Everything starts out dirty again, so the carried values reach the new program on the next bind
+		AllocateStorage();
+		RemapUniforms(
+			previous, m_Shader, ShaderUniformMask().set(),
+			[&](ShaderUniformDeclaration *decl) -> Buffer &
+			{
+				if (decl->GetBlockIndex() != -1)
+					return previousBlocks[decl->GetBlockIndex()].Storage;
+				return decl->GetDomain() == ShaderDomain::Vertex ? previousVS : previousPS;
+			},
+			[this](ShaderUniformDeclaration *decl) -> Buffer &
+			{ return GetUniformBufferTarget(decl); });
+		m_Textures = RemapTextures(previous, m_Shader, m_Textures);
+		m_Variant = nullptr;
+		m_VariantDirty = true;
+
+		for (auto mi : m_MaterialInstances)
+			mi->OnShaderReloaded(previous);
+
+		previousVS.Release();
+		previousPS.Release();
+		ReleaseUniformBlocks(previousBlocks);
 	}
 
 	void Material::AllocateStorage()
@@ -33,30 +317,11 @@ namespace Janus
 			m_PSUniformStorageBuffer.Allocate(psBuffer.GetSize());
 			m_PSUniformStorageBuffer.ZeroInitialize();
 		}
-	}
-
-	ShaderUniformDeclaration *Material::FindUniformDeclaration(const std::string &name)
-	{
-		if (m_VSUniformStorageBuffer)
-		{
-			auto &declarations = m_Shader->GetVSMaterialUniformBuffer().GetUniformDeclarations();
-			for (ShaderUniformDeclaration *uniform : declarations)
-			{
-				if (uniform->GetName() == name)
-					return uniform;
-			}
-		}
 
-		if (m_PSUniformStorageBuffer)
-		{
-			auto &declarations = m_Shader->GetPSMaterialUniformBuffer().GetUniformDeclarations();
-			for (ShaderUniformDeclaration *uniform : declarations)
-			{
-				if (uniform->GetName() == name)
-					return uniform;
-			}
-		}
-		return nullptr;
+		AllocateUniformBlocks(m_Shader, m_UniformBlocks, nullptr);
+		if (m_VSUniformStorageBuffer || m_PSUniformStorageBuffer)
+			m_UniformUploads = Ref<MaterialUniformUploads>::Create();
+		m_DirtyUniforms = GetAllUniformsMask(m_Shader);
 	}
 
 	ShaderResourceDeclaration *Material::FindResourceDeclaration(const std::string &name)
@@ -72,6 +337,9 @@ namespace Janus
 
 	Buffer &Material::GetUniformBufferTarget(ShaderUniformDeclaration *uniformDeclaration)
 	{
+		if (uniformDeclaration->GetBlockIndex() != -1)
+			return m_UniformBlocks[uniformDeclaration->GetBlockIndex()].Storage;
+
 		switch (uniformDeclaration->GetDomain())
 		{
 		case ShaderDomain::Vertex:
@@ -86,16 +354,47 @@ namespace Janus
 
 	void Material::Bind()
 	{
-		m_Shader->Bind();
+		FlushUniforms();
+		// Uniforms stay staged; the recompiled program gets all of them on its first real bind
+		const Ref<Shader> &shader = GetVariant();
+		if (!shader->IsReady() || shader->HasCompileErrors())
+		{
+			Renderer::GetFallbackShader()->Bind();
+			return;
+		}
+		shader->Bind();
+		BindLooseUniforms(shader, m_UniformUploads);
+		BindUniformBlocks(m_UniformBlocks);
+		BindTextures();
+	}
 
-		if (m_VSUniformStorageBuffer)
-			m_Shader->SetVSMaterialUniformBuffer(m_VSUniformStorageBuffer);
+	void Material::FlushUniforms()
+	{
+		FlushDirtyUniforms(m_Shader, m_DirtyUniforms, m_VSUniformStorageBuffer, m_PSUniformStorageBuffer, m_UniformBlocks, m_UniformUploads);
+	}
 
-		if (m_PSUniformStorageBuffer)
-			m_Shader->SetPSMaterialUniformBuffer(m_PSUniformStorageBuffer);
+	const Ref<Shader> &Material::GetVariant()
+	{
+		if (m_VariantDirty)
+		{
+			uint32_t mask = GetKeywordMask(
+				m_Shader,
+				[this](uint32_t slot)
+				{ return slot < m_Textures.size() && m_Textures[slot]; },
+				[this](ShaderUniformDeclaration *toggle)
+				{ return GetUniformBufferTarget(toggle).Read<float>(toggle->GetOffset()); });
+			if (!m_Variant || m_Variant->GetKeywordMask() != mask)
+				m_Variant = m_Shader->GetVariant(mask);
+			m_VariantDirty = false;
+		}
+		return m_Variant;
+	}
 
-		
-		BindTextures();
+	void Material::OnTexturesChanged()
+	{
+		m_VariantDirty = true;
+		for (auto mi : m_MaterialInstances)
+			mi->m_VariantDirty = true;
 	}
 
 	void Material::BindTextures()
@@ -135,6 +434,7 @@ namespace Janus
 	MaterialInstance::~MaterialInstance()
 	{
 		m_Material->m_MaterialInstances.erase(this);
+		ReleaseUniformBlocks(m_UniformBlocks);
 	}
 
 	void MaterialInstance::AllocateStorage()
@@ -152,20 +452,62 @@ namespace Janus
 			m_PSUniformStorageBuffer.Allocate(psBuffer.GetSize());
 			memcpy(m_PSUniformStorageBuffer.Data, m_Material->m_PSUniformStorageBuffer.Data, psBuffer.GetSize());
 		}
+
+		AllocateUniformBlocks(m_Material->m_Shader, m_UniformBlocks, &m_Material->m_UniformBlocks);
+		if (m_VSUniformStorageBuffer || m_PSUniformStorageBuffer)
+			m_UniformUploads = Ref<MaterialUniformUploads>::Create();
+		m_DirtyUniforms = GetAllUniformsMask(m_Material->m_Shader);
+	}
+
+	void MaterialInstance::OnShaderReloaded(const Shader &previous)
+	{
+		const Ref<Shader> &shader = m_Material->m_Shader;
+		Buffer previousVS = m_VSUniformStorageBuffer;
+		Buffer previousPS = m_PSUniformStorageBuffer;
+		std::vector<MaterialUniformBlock> previousBlocks = std::move(m_UniformBlocks);
+		m_VSUniformStorageBuffer = Buffer();
+		m_PSUniformStorageBuffer = Buffer();
+		m_UniformBlocks.clear();
+		m_UniformUploads = nullptr;
+
+		// Storage starts as a copy of the remapped material; only the overrides are carried over on top
+		AllocateStorage();
+		m_OverriddenUniforms = RemapUniforms(
+			previous, shader, m_OverriddenUniforms,
+			[&](ShaderUniformDeclaration *decl) -> Buffer &
+			{
+				if (decl->GetBlockIndex() != -1)
+					return previousBlocks[decl->GetBlockIndex()].Storage;
+				return decl->GetDomain() == ShaderDomain::Vertex ? previousVS : previousPS;
+			},
+			[this](ShaderUniformDeclaration *decl) -> Buffer &
+			{ return GetUniformBufferTarget(decl); });
+		m_Textures = RemapTextures(previous, shader, m_Textures);
+		m_Variant = nullptr;
+		m_VariantDirty = true;
+
+		previousVS.Release();
+		previousPS.Release();
+		ReleaseUniformBlocks(previousBlocks);
 	}
 
 	void MaterialInstance::OnMaterialValueUpdated(ShaderUniformDeclaration *decl)
 	{
-		if (m_OverriddenValues.find(decl->GetName()) == m_OverriddenValues.end())
+		if (!m_OverriddenUniforms.test(decl->GetMaterialIndex()))
 		{
 			auto &buffer = GetUniformBufferTarget(decl);
 			auto &materialBuffer = m_Material->GetUniformBufferTarget(decl);
 			buffer.Write(materialBuffer.Data + decl->GetOffset(), decl->GetSize(), decl->GetOffset());
+			m_DirtyUniforms.set(decl->GetMaterialIndex());
+			m_VariantDirty = true;
 		}
 	}
 
 	Buffer &MaterialInstance::GetUniformBufferTarget(ShaderUniformDeclaration *uniformDeclaration)
 	{
+		if (uniformDeclaration->GetBlockIndex() != -1)
+			return m_UniformBlocks[uniformDeclaration->GetBlockIndex()].Storage;
+
 		switch (uniformDeclaration->GetDomain())
 		{
 		case ShaderDomain::Vertex:
@@ -192,14 +534,16 @@ namespace Janus
 
 	void MaterialInstance::Bind()
 	{
-		m_Material->m_Shader->Bind();
-
-		if (m_VSUniformStorageBuffer)
-			m_Material->m_Shader->SetVSMaterialUniformBuffer(m_VSUniformStorageBuffer);
-
-		if (m_PSUniformStorageBuffer)
-			m_Material->m_Shader->SetPSMaterialUniformBuffer(m_PSUniformStorageBuffer);
-
+		FlushUniforms();
+		const Ref<Shader> &shader = GetVariant();
+		if (!shader->IsReady() || shader->HasCompileErrors())
+		{
+			Renderer::GetFallbackShader()->Bind();
+			return;
+		}
+		shader->Bind();
+		BindLooseUniforms(shader, m_UniformUploads);
+		BindUniformBlocks(m_UniformBlocks);
 		m_Material->BindTextures();
 		for (size_t i = 0; i < m_Textures.size(); i++)
 		{
@@ -208,4 +552,27 @@ namespace Janus
 				texture->Bind(i);
 		}
 	}
+
+	const Ref<Shader> &MaterialInstance::GetVariant()
+	{
+		if (m_VariantDirty)
+		{
+			const auto &materialTextures = m_Material->m_Textures;
+			uint32_t mask = GetKeywordMask(
+				m_Material->m_Shader,
+				[&](uint32_t slot)
+				{ return (slot < m_Textures.size() && m_Textures[slot]) || (slot < materialTextures.size() && materialTextures[slot]); },
+				[this](ShaderUniformDeclaration *toggle)
+				{ return GetUniformBufferTarget(toggle).Read<float>(toggle->GetOffset()); });
+			if (!m_Variant || m_Variant->GetKeywordMask() != mask)
+				m_Variant = m_Material->m_Shader->GetVariant(mask);
+			m_VariantDirty = false;
+		}
+		return m_Variant;
+	}
+
+	void MaterialInstance::FlushUniforms()
+	{
+		FlushDirtyUniforms(m_Material->m_Shader, m_DirtyUniforms, m_VSUniformStorageBuffer, m_PSUniformStorageBuffer, m_UniformBlocks, m_UniformUploads);
+	}
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "Graphics/Texture.h"
 #include "Graphics/Shader.h"
 #include "Graphics/Light.h"
+#include "Graphics/UniformBuffer.h"
 
 namespace Janus
 {
@@ -16,7 +17,33 @@ namespace Janus
 		None = BIT(0),
 		DepthTest = BIT(1),
 		Blend = BIT(2),
-		TwoSided = BIT(3)
+		TwoSided = BIT(3),
+		Transparent = BIT(4)
+	};
+
+	// CPU copy of a material owned uniform block. Changed members are uploaded to its uniform buffer
+	struct MaterialUniformBlock
+	{
+		Buffer Storage;
+		Ref<UniformBuffer> GPUBuffer;
+	};
+
+	// Render thread copy of a material's loose uniforms. The program keeps the values of whichever material
+	// uploaded last, so the copy lets a material refill it after another material has used the shader
+	struct MaterialUniformUploads : public RefCounted
+	{
+		Buffer VSStorage;
+		Buffer PSStorage;
+		// Uniforms changed since this material last uploaded
+		ShaderUniformMask Dirty;
+		// Matches Shader::GetMaterialGeneration() while the program holds these values
+		uint64_t Generation = 0;
+
+		~MaterialUniformUploads()
+		{
+			VSStorage.Release();
+			PSStorage.Release();
+		}
 	};
 
 	class Material : public RefCounted
@@ -25,7 +52,14 @@ namespace Janus
 
 	public:
 		Material(const Ref<Shader> &shader, const std::string& name);
+		~Material();
 		void Bind();
+		// Uploads the uniforms changed since the last flush. Bind flushes as well; calling this up front
+		// keeps parallel recording threads from writing the dirty mask
+		void FlushUniforms();
+		// The shader variant matching the keywords this material's textures and toggles enable. Call once
+		// on the recording thread before recording in parallel, as picking a new variant is not thread safe
+		const Ref<Shader> &GetVariant();
 
 		uint32_t GetFlags() const { return m_MaterialFlags; }
 		const std::string &GetName() const { return m_Name; }
@@ -43,32 +77,49 @@ namespace Janus
 			Set(name, (const Ref<Texture>&)texture);
 		}
 
+		// Name overloads hash the name on every call; hot paths should keep a static constexpr UniformID
 		template <typename T>
 		void Set(const std::string &name, const T &value)
 		{
-			auto decl = FindUniformDeclaration(name);
+			Set(UniformID(name), value);
+		}
+
+		template <typename T>
+		void Set(UniformID id, const T &value)
+		{
+			auto decl = FindUniformDeclaration(id);
 			JN_ASSERT(decl, "MATERIAL_ERROR: Could not find uniform");
 			auto &buffer = GetUniformBufferTarget(decl);
+			if (memcmp(buffer.Data + decl->GetOffset(), &value, decl->GetSize()) == 0)
+				return;
+
 			buffer.Write((byte *)&value, decl->GetSize(), decl->GetOffset());
+			m_DirtyUniforms.set(decl->GetMaterialIndex());
+			m_VariantDirty = true;
 
 			for (auto mi : m_MaterialInstances)
 				mi->OnMaterialValueUpdated(decl);
 		}
 
 		template <typename T>
-		void Set(const std::string &name, const std::vector<T>& array)
+		void Set(UniformID id, const std::vector<T>& array)
 		{
 			if(array.size() <= 0)
 				return;
 
-			auto decl = FindUniformDeclaration(name);
+			auto decl = FindUniformDeclaration(id);
 			JN_ASSERT(decl, "MATERIAL_ERROR: Could not find uniform");
 			auto &buffer = GetUniformBufferTarget(decl);
 			uint32_t unitSize = sizeof(T);
 			uint32_t declUnitSize = decl->GetSize() / decl->GetCount();
 			JN_ASSERT(unitSize == declUnitSize, "MATERIAL_ERROR: Mismatch uniform datatype");
 			uint32_t size = unitSize * array.size();
+			if (memcmp(buffer.Data + decl->GetOffset(), array.data(), size) == 0)
+				return;
+
 			buffer.Write((byte *)array.data(), size, decl->GetOffset());
+			m_DirtyUniforms.set(decl->GetMaterialIndex());
+			m_VariantDirty = true;
 
 			for (auto mi : m_MaterialInstances)
 				mi->OnMaterialValueUpdated(decl);
@@ -81,12 +132,19 @@ namespace Janus
 			if (m_Textures.size() <= slot)
 				m_Textures.resize((size_t)slot + 1);
 			m_Textures[slot] = texture;
+			OnTexturesChanged();
 		}
 
 		template <typename T>
 		T &Get(const std::string &name)
 		{
-			auto decl = FindUniformDeclaration(name);
+			return Get<T>(UniformID(name));
+		}
+
+		template <typename T>
+		T &Get(UniformID id)
+		{
+			auto decl = FindUniformDeclaration(id);
 			JN_ASSERT(decl, "MATERIAL_ERROR: Could not find uniform!");
 			auto &buffer = GetUniformBufferTarget(decl);
 			return buffer.Read<T>(decl->GetOffset());
@@ -119,18 +177,30 @@ namespace Janus
 
 	public:
 		static Ref<Material> Create(const Ref<Shader> &shader, const std::string &name);
+		// Main thread only, with the render thread idle. Reallocates the storage of every material using the
+		// reloaded shader for its new layout, carrying over the values and textures it still declares.
+		// previous holds the layout from before the reload
+		static void OnShaderReloaded(const Ref<Shader> &shader, const Shader &previous);
 
 	private:
 		void AllocateStorage();
+		void RemapStorage(const Shader &previous);
 		void BindTextures();
-		ShaderUniformDeclaration *FindUniformDeclaration(const std::string &name);
+		void OnTexturesChanged();
+		ShaderUniformDeclaration *FindUniformDeclaration(UniformID id) { return m_Shader->FindMaterialUniform(id); }
 		Buffer &GetUniformBufferTarget(ShaderUniformDeclaration *uniformDeclaration);
 
 		std::vector<Ref<Texture>> m_Textures;
 		std::unordered_set<MaterialInstance *> m_MaterialInstances;
 		Ref<Shader> m_Shader;
+		Ref<Shader> m_Variant;
+		bool m_VariantDirty = true;
 		Buffer m_VSUniformStorageBuffer;
 		Buffer m_PSUniformStorageBuffer;
+		// Indexed like Shader::GetUniformBlocks(); renderer owned blocks are left empty
+		std::vector<MaterialUniformBlock> m_UniformBlocks;
+		Ref<MaterialUniformUploads> m_UniformUploads;
+		ShaderUniformMask m_DirtyUniforms;
 		std::string m_Name;
 		uint32_t m_MaterialFlags;
 	};
@@ -146,15 +216,26 @@ namespace Janus
 		template <typename T>
 		void Set(const std::string &name, const T &value)
 		{
-			auto decl = m_Material->FindUniformDeclaration(name);
+			Set(UniformID(name), value);
+		}
+
+		template <typename T>
+		void Set(UniformID id, const T &value)
+		{
+			auto decl = m_Material->FindUniformDeclaration(id);
 			if (!decl)
 			{
 				JN_ASSERT(decl, "MATERIAL_ERROR: Could not find uniform!");
 				return;
 			}
+			m_OverriddenUniforms.set(decl->GetMaterialIndex());
 			auto &buffer = GetUniformBufferTarget(decl);
+			if (memcmp(buffer.Data + decl->GetOffset(), &value, decl->GetSize()) == 0)
+				return;
+
 			buffer.Write((byte *)&value, decl->GetSize(), decl->GetOffset());
-			m_OverriddenValues.insert(name);
+			m_DirtyUniforms.set(decl->GetMaterialIndex());
+			m_VariantDirty = true;
 		}
 
 		void Set(const std::string &name, const Ref<Texture> &texture)
@@ -169,12 +250,19 @@ namespace Janus
 			if (m_Textures.size() <= slot)
 				m_Textures.resize((size_t)slot + 1);
 			m_Textures[slot] = texture;
+			m_VariantDirty = true;
 		}
 
 		template <typename T>
 		T &Get(const std::string &name)
 		{
-			auto decl = m_Material->FindUniformDeclaration(name);
+			return Get<T>(UniformID(name));
+		}
+
+		template <typename T>
+		T &Get(UniformID id)
+		{
+			auto decl = m_Material->FindUniformDeclaration(id);
 			JN_ASSERT(decl, "MATERIAL_ERROR: Could not find uniform!");
 			auto &buffer = GetUniformBufferTarget(decl);
 			return buffer.Read<T>(decl->GetOffset());
@@ -205,6 +293,9 @@ namespace Janus
 		}
 
 		void Bind();
+		void FlushUniforms();
+		// See Material::GetVariant. Textures the instance does not set come from its material
+		const Ref<Shader> &GetVariant();
 
 		uint32_t GetFlags() const { return m_Material->m_MaterialFlags; }
 		bool GetFlag(MaterialFlag flag) const { return (uint32_t)flag & m_Material->m_MaterialFlags; }
@@ -219,7 +310,8 @@ namespace Janus
 
 	private:
 		void AllocateStorage();
-		void OnShaderReloaded();
+		// Called by the material after it has remapped its own storage
+		void OnShaderReloaded(const Shader &previous);
 		Buffer &GetUniformBufferTarget(ShaderUniformDeclaration *uniformDeclaration);
 		void OnMaterialValueUpdated(ShaderUniformDeclaration *decl);
 
@@ -229,9 +321,14 @@ namespace Janus
 
 		Buffer m_VSUniformStorageBuffer;
 		Buffer m_PSUniformStorageBuffer;
+		std::vector<MaterialUniformBlock> m_UniformBlocks;
+		Ref<MaterialUniformUploads> m_UniformUploads;
+		ShaderUniformMask m_DirtyUniforms;
 		std::vector<Ref<Texture>> m_Textures;
+		Ref<Shader> m_Variant;
+		bool m_VariantDirty = true;
 
-		// TODO: This is temporary; come up with a proper system to track overrides
-		std::unordered_set<std::string> m_OverriddenValues;
+		// Uniforms set on the instance itself, which no longer follow the material
+		ShaderUniformMask m_OverriddenUniforms;
 	};
 }
\ No newline at end of file
@@ -21,9 +21,14 @@
 
 #include "Graphics/Renderer.h"
 #include "Graphics/Mesh.h"
+#include "Graphics/MeshFile.h"
+#include "Graphics/GltfImporter.h"
+#include "Graphics/MeshOptimizer.h"
 
 namespace Janus
 {
+    static MeshVertexFormat s_VertexFormat = MeshVertexFormat::Full;
+
     glm::mat4 Mat4FromAssimpMat4(const aiMatrix4x4 &matrix)
     {
         glm::mat4 result;
@@ -55,30 +60,92 @@ namespace Janus
         aiProcess_GenUVCoords |          // Convert UVs if required
         aiProcess_ValidateDataStructure; // Validation
 
-    Mesh::Mesh(const std::string &filename)
-        : m_FilePath(filename)
+    static void TraverseNodes(aiNode *node, std::vector<Submesh> &submeshes, const glm::mat4 &parentTransform = glm::mat4(1.0f))
     {
-        m_Importer = std::make_unique<Assimp::Importer>();
+        glm::mat4 transform = parentTransform * Mat4FromAssimpMat4(node->mTransformation);
+        for (uint32_t i = 0; i < node->mNumMeshes; i++)
+        {
+            uint32_t mesh = node->mMeshes[i];
+            submeshes[mesh].Transform = transform;
+        }
 
-        const aiScene *scene = m_Importer->ReadFile(filename, s_MeshImportFlags);
-        if (!scene || !scene->HasMeshes())
+        for (uint32_t i = 0; i < node->mNumChildren; i++)
+            TraverseNodes(node->mChildren[i], submeshes, transform);
+    }
+
+    static std::string GetTexturePath(const std::string &filename, const std::string &texture)
+    {
+        // TODO: Temp - this should be handled by Hazel's filesystem
+        std::filesystem::path path = filename;
+        auto parentPath = path.parent_path();
+        parentPath /= texture;
+        return parentPath.string();
+    }
+
+    static MeshMaterialDescription ImportMaterial(const std::string &filename, aiMaterial *aiMaterial)
+    {
+        MeshMaterialDescription material;
+        material.Name = aiMaterial->GetName().data;
+
+        aiColor3D aiColor;
+        aiMaterial->Get(AI_MATKEY_COLOR_DIFFUSE, aiColor);
+        material.AlbedoColor = {aiColor.r, aiColor.g, aiColor.b};
+
+        float shininess, metalness;
+        if (aiMaterial->Get(AI_MATKEY_SHININESS, shininess) != aiReturn_SUCCESS)
+            shininess = 80.0f; // Default value
+
+        if (aiMaterial->Get(AI_MATKEY_REFLECTIVITY, metalness) != aiReturn_SUCCESS)
+            metalness = 0.0f;
+
+        material.Roughness = 1.0f - glm::sqrt(shininess / 100.0f);
+        material.Metalness = metalness;
+
+        if (aiMaterial->Get(AI_MATKEY_OPACITY, material.Opacity) != aiReturn_SUCCESS)
+            material.Opacity = 1.0f;
+        material.Transparent = material.Opacity < 1.0f;
+
+        aiString aiTexPath;
+        if (aiMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &aiTexPath) == AI_SUCCESS)
+            material.AlbedoMap = GetTexturePath(filename, aiTexPath.data);
+        if (aiMaterial->GetTexture(aiTextureType_NORMALS, 0, &aiTexPath) == AI_SUCCESS)
+            material.NormalMap = GetTexturePath(filename, aiTexPath.data);
+        if (aiMaterial->GetTexture(aiTextureType_SHININESS, 0, &aiTexPath) == AI_SUCCESS)
+            material.RoughnessMap = GetTexturePath(filename, aiTexPath.data);
+
+        for (uint32_t i = 0; i < aiMaterial->mNumProperties; i++)
         {
-            JN_ASSERT(false, "MESH_ERROR: Scene has no meshes!");
+            auto prop = aiMaterial->mProperties[i];
+            if (prop->mType == aiPTI_String && std::string(prop->mKey.data) == "$raw.ReflectionFactor|file")
+            {
+                uint32_t strLength = *(uint32_t *)prop->mData;
+                material.MetalnessMap = GetTexturePath(filename, std::string(prop->mData + 4, strLength));
+                break;
+            }
         }
+        return material;
+    }
 
-        m_MeshShader = Renderer::GetShaderLibrary()->Get("janus_pbr");
+    static bool ImportMesh(const std::string &filename, ImportedMesh &imported)
+    {
+        JN_PROFILE_FUNCTION();
+        Assimp::Importer importer;
+        const aiScene *scene = importer.ReadFile(filename, s_MeshImportFlags);
+        if (!scene || !scene->HasMeshes())
+            return false;
 
-        m_InverseTransform = glm::inverse(Mat4FromAssimpMat4(scene->mRootNode->mTransformation));
+        MeshContents &contents = imported.Contents;
+        contents.InverseTransform = glm::inverse(Mat4FromAssimpMat4(scene->mRootNode->mTransformation));
 
         uint32_t vertexCount = 0;
         uint32_t indexCount = 0;
 
-        m_Submeshes.reserve(scene->mNumMeshes);
+        contents.Submeshes.reserve(scene->mNumMeshes);
         for (size_t m = 0; m < scene->mNumMeshes; m++)
         {
             aiMesh *mesh = scene->mMeshes[m];
 
-            Submesh &submesh = m_Submeshes.emplace_back();
+            Submesh &submesh = contents.Submeshes.emplace_back();
             submesh.BaseVertex = vertexCount;
             submesh.BaseIndex = indexCount;
             submesh.MaterialIndex = mesh->mMaterialIndex;
@@ -90,22 +157,17 @@ namespace Janus
             assert(mesh->HasPositions());
             assert(mesh->HasNormals());
 
-            //auto& aabb = submesh.BoundingBox;
-            //aabb.Min = { FLT_MAX, FLT_MAX, FLT_MAX };
-            //aabb.Max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            auto &aabb = submesh.BoundingBox;
+            aabb = AABB::Empty();
 
             for (size_t i = 0; i < mesh->mNumVertices; i++)
             {
-                Vertex vertex;
+                // Zeroed so attributes the source lacks cook to the same bytes every time
+                Vertex vertex = {};
                 vertex.Position = {mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z};
                 vertex.Normal = {mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z};
 
-                //aabb.Min.x = glm::min(vertex.Position.x, aabb.Min.x);
-                //aabb.Min.y = glm::min(vertex.Position.y, aabb.Min.y);
-                //aabb.Min.z = glm::min(vertex.Position.z, aabb.Min.z);
-                //aabb.Max.x = glm::max(vertex.Position.x, aabb.Max.x);
-                //aabb.Max.y = glm::max(vertex.Position.y, aabb.Max.y);
-                //aabb.Max.z = glm::max(vertex.Position.z, aabb.Max.z);
+                aabb.Expand(vertex.Position);
 
                 if (mesh->HasTangentsAndBitangents())
                 {
@@ -116,242 +178,246 @@ namespace Janus
                 if (mesh->HasTextureCoords(0))
                     vertex.Texcoord = {mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y};
 
-                m_Vertices.push_back(vertex);
+                imported.Vertices.push_back(vertex);
             }
 
             // Indices
             for (size_t i = 0; i < mesh->mNumFaces; i++)
             {
                 assert(mesh->mFaces[i].mNumIndices == 3);
-                m_Indices.push_back({mesh->mFaces[i].mIndices[0], mesh->mFaces[i].mIndices[1], mesh->mFaces[i].mIndices[2]});
+                imported.Indices.push_back({mesh->mFaces[i].mIndices[0], mesh->mFaces[i].mIndices[1], mesh->mFaces[i].mIndices[2]});
             }
-            m_Submeshes.push_back(submesh);
         }
 
-        TraverseNodes(scene->mRootNode);
+        TraverseNodes(scene->mRootNode, contents.Submeshes);
+
+        contents.BoundingBox = AABB::Empty();
+        for (auto &submesh : contents.Submeshes)
+        {
+            if (!submesh.BoundingBox.IsValid())
+                submesh.BoundingBox = AABB();
+            contents.BoundingBox.Expand(submesh.BoundingBox.Transform(submesh.Transform));
+        }
+        if (!contents.BoundingBox.IsValid())
+            contents.BoundingBox = AABB();
 
-        // Materials
         if (scene->HasMaterials())
         {
-            m_Textures.resize(scene->mNumMaterials);
-            m_Materials.resize(scene->mNumMaterials);
+            contents.Materials.reserve(scene->mNumMaterials);
             for (uint32_t i = 0; i < scene->mNumMaterials; i++)
-            {
-                auto aiMaterial = scene->mMaterials[i];
-                auto aiMaterialName = aiMaterial->GetName();
+                contents.Materials.push_back(ImportMaterial(filename, scene->mMaterials[i]));
+        }
 
-                auto mi = Material::Create(m_MeshShader, aiMaterialName.data);
-                mi->SetFlag(MaterialFlag::TwoSided, true);
-                m_Materials[i] = mi;
+        contents.Vertices = imported.Vertices.data();
+        contents.VertexCount = (uint32_t)imported.Vertices.size();
+        contents.Indices = imported.Indices.data();
+        contents.IndexCount = (uint32_t)imported.Indices.size() * 3;
+        return true;
+    }
 
-                aiString aiTexPath;
-                uint32_t textureCount = aiMaterial->GetTextureCount(aiTextureType_DIFFUSE);
+    Mesh::Mesh(const std::string &filename)
+        : m_FilePath(filename)
+    {
+        JN_PROFILE_FUNCTION();
+        m_MeshShader = Renderer::GetShaderLibrary()->Get("janus_pbr");
+        m_GeometryArena = Renderer::GetGeometryArena();
+
+        // Cooked geometry is uploaded straight from the mapping, which the upload keeps open until it has run
+        bool isCooked = MeshFile::IsCookedPath(filename);
+        std::string cookedPath = isCooked ? filename : MeshFile::GetCookedPath(filename, s_VertexFormat);
+        Ref<MappedFile> cookedFile;
+        MeshContents cooked;
+        if (MeshFile::Read(cookedPath, isCooked ? std::string() : filename, s_VertexFormat, cookedFile, cooked))
+        {
+            Build(cooked);
+            m_GeometryAllocation = m_GeometryArena->Allocate(cookedFile, cooked.Vertices, cooked.VertexCount, cooked.Indices, cooked.IndexCount, cooked.Format);
+            return;
+        }
 
-                aiColor3D aiColor;
-                aiMaterial->Get(AI_MATKEY_COLOR_DIFFUSE, aiColor);
+        if (isCooked)
+        {
+            JN_ASSERT(false, "MESH_ERROR: Could not load cooked mesh!");
+            return;
+        }
 
-                float shininess, metalness;
-                if (aiMaterial->Get(AI_MATKEY_SHININESS, shininess) != aiReturn_SUCCESS)
-                    shininess = 80.0f; // Default value
+        ImportedMesh imported;
+        bool isImported = false;
+        if (GltfImporter::IsGltfPath(filename))
+        {
+            isImported = GltfImporter::Import(filename, imported);
+            if (!isImported)
+                JN_CORE_WARN("MESH_MSG: Importing {0} through Assimp", filename);
+        }
+        if (!isImported && !ImportMesh(filename, imported))
+        {
+            JN_ASSERT(false, "MESH_ERROR: Scene has no meshes!");
+            return;
+        }
 
-                if (aiMaterial->Get(AI_MATKEY_REFLECTIVITY, metalness) != aiReturn_SUCCESS)
-                    metalness = 0.0f;
+        MeshOptimizer::Statistics before, after;
+        MeshOptimizer::Optimize(imported, before, after);
+        JN_CORE_INFO("MESH_MSG: Optimized {0}: {1} -> {2} vertices, ACMR {3:.3f} -> {4:.3f}, ATVR {5:.3f} -> {6:.3f}",
+                     filename, before.VertexCount, after.VertexCount, before.ACMR, after.ACMR, before.ATVR, after.ATVR);
+        uint32_t lodTriangles[Submesh::MaxLods] = {};
+        for (const Submesh &submesh : imported.Contents.Submeshes)
+        {
+            for (uint32_t lod = 0; lod < submesh.LodCount; lod++)
+                lodTriangles[lod] += submesh.GetLod(lod).IndexCount / 3;
+        }
+        JN_CORE_INFO("MESH_MSG: Level of detail triangles of {0}: {1}, {2}, {3}, {4}", filename, lodTriangles[0], lodTriangles[1], lodTriangles[2], lodTriangles[3]);
+        if (s_VertexFormat == MeshVertexFormat::Compact)
+            MeshOptimizer::Compress(imported);
+
+        const MeshContents &contents = imported.Contents;
+        if (MeshFile::Write(cookedPath, filename, contents))
+            JN_CORE_INFO("MESH_MSG: Cooked {0} to {1}", filename, cookedPath);
+        Build(contents);
+        m_GeometryAllocation = m_GeometryArena->Allocate(contents.Vertices, contents.VertexCount, contents.Indices, contents.IndexCount, contents.Format);
+    }
 
-                float roughness = 1.0f - glm::sqrt(shininess / 100.0f);
-                bool hasAlbedoMap = aiMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &aiTexPath) == AI_SUCCESS;
-                if (hasAlbedoMap)
-                {
+    Mesh::~Mesh()
+    {
+        if (m_GeometryAllocation.IsValid())
+            m_GeometryArena->Free(m_GeometryAllocation);
+    }
 
-                    std::filesystem::path path = filename;
-                    auto parentPath = path.parent_path();
-                    parentPath /= std::string(aiTexPath.data);
-                    std::string texturePath = parentPath.string();
-                    auto texture = Ref<Texture2D>::Create(texturePath);
-                    if (texture->Loaded())
-                    {
-                        m_Textures[i] = texture;
-                        mi->Set("u_AlbedoTexture", m_Textures[i]);
-                        mi->Set("u_AlbedoTexToggle", 1.0f);
-                    }
-                    else
-                    {
-                        mi->Set("u_AlbedoColor", glm::vec3{aiColor.r, aiColor.g, aiColor.b});
-                    }
-                }
-                else
+    void Mesh::Build(const MeshContents &contents)
+    {
+        m_Submeshes = contents.Submeshes;
+        m_BoundingBox = contents.BoundingBox;
+        m_InverseTransform = contents.InverseTransform;
+        CreateMaterials(contents.Materials);
+    }
+
+    void Mesh::CreateMaterials(const std::vector<MeshMaterialDescription> &materials)
+    {
+        m_Textures.resize(materials.size());
+        m_Materials.resize(materials.size());
+        for (uint32_t i = 0; i < materials.size(); i++)
+        {
+            const MeshMaterialDescription &material = materials[i];
+            auto mi = Material::Create(m_MeshShader, material.Name);
+            mi->SetFlag(MaterialFlag::TwoSided, true);
+            mi->SetFlag(MaterialFlag::Transparent, material.Transparent);
+            if (material.Transparent)
+                mi->Set("u_Transparency", 1.0f - material.Opacity);
+            m_Materials[i] = mi;
+
+            bool hasAlbedoTexture = false;
+            if (!material.AlbedoMap.empty())
+            {
+                auto texture = Ref<Texture2D>::Create(material.AlbedoMap);
+                if (texture->Loaded())
                 {
-                    mi->Set("u_AlbedoColor", glm::vec3{aiColor.r, aiColor.g, aiColor.b});
+                    m_Textures[i] = texture;
+                    mi->Set("u_AlbedoTexture", m_Textures[i]);
+                    mi->Set("u_AlbedoTexToggle", 1.0f);
+                    hasAlbedoTexture = true;
                 }
+            }
+            if (!hasAlbedoTexture)
+                mi->Set("u_AlbedoColor", material.AlbedoColor);
 
-                mi->Set("u_NormalTexToggle", 0.0f);
-                if (aiMaterial->GetTexture(aiTextureType_NORMALS, 0, &aiTexPath) == AI_SUCCESS)
+            mi->Set("u_NormalTexToggle", 0.0f);
+            if (!material.NormalMap.empty())
+            {
+                auto texture = Ref<Texture2D>::Create(material.NormalMap);
+                if (texture->Loaded())
                 {
-                    // TODO: Temp - this should be handled by Hazel's filesystem
-                    std::filesystem::path path = filename;
-                    auto parentPath = path.parent_path();
-                    parentPath /= std::string(aiTexPath.data);
-                    std::string texturePath = parentPath.string();
-                    auto texture = Ref<Texture2D>::Create(texturePath);
-                    if (texture->Loaded())
-                    {
-                        mi->Set("u_NormalTexture", texture);
-                        mi->Set("u_NormalTexToggle", 1.0f);
-                    }
-                    else
-                    {
-                        JN_CORE_ERROR("MESH_IMPORT_MSG: Could not load texture: {0}", texturePath);
-                    }
+                    mi->Set("u_NormalTexture", texture);
+                    mi->Set("u_NormalTexToggle", 1.0f);
                 }
                 else
                 {
-                    JN_CORE_WARN("MESH_IMPORT_MSG: No normal map");
+                    JN_CORE_ERROR("MESH_IMPORT_MSG: Could not load texture: {0}", material.NormalMap);
                 }
+            }
+            else
+            {
+                JN_CORE_WARN("MESH_IMPORT_MSG: No normal map");
+            }
 
-                if (aiMaterial->GetTexture(aiTextureType_SHININESS, 0, &aiTexPath) == AI_SUCCESS)
+            if (!material.RoughnessMap.empty())
+            {
+                auto texture = Ref<Texture2D>::Create(material.RoughnessMap);
+                if (texture->Loaded())
                 {
-                    std::filesystem::path path = filename;
-                    auto parentPath = path.parent_path();
-                    parentPath /= std::string(aiTexPath.data);
-                    std::string texturePath = parentPath.string();
-                    auto texture = Ref<Texture2D>::Create(texturePath);
-                    if (texture->Loaded())
-                    {
-                        mi->Set("u_RoughnessTexture", texture);
-                        mi->Set("u_RoughnessTexToggle", 1.0f);
-                    }
-                    else
-                    {
-                        JN_CORE_ERROR("MESH_IMPORT_MSG: Could not load texture: {0}", texturePath);
-                    }
-                } else {
-                    mi->Set("u_RoughnessTexToggle", 0.0f);
-                    mi->Set("u_Roughness", roughness);
+                    mi->Set("u_RoughnessTexture", texture);
+                    mi->Set("u_RoughnessTexToggle", 1.0f);
                 }
-                bool metalnessTextureFound = false;
-                for (uint32_t i = 0; i < aiMaterial->mNumProperties; i++)
+                else
                 {
-                    auto prop = aiMaterial->mProperties[i];
-#if 0
-					switch (prop->mSemantic)
-					{
-					case aiTextureType_NONE:
-						JN_CORE_TRACE("  Semantic = aiTextureType_NONE");
-						break;
-					case aiTextureType_DIFFUSE:
-						JN_CORE_TRACE("  Semantic = aiTextureType_DIFFUSE");
-						break;
-					case aiTextureType_SPECULAR:
-						JN_CORE_TRACE("  Semantic = aiTextureType_SPECULAR");
-						break;
-					case aiTextureType_AMBIENT:
-						JN_CORE_TRACE("  Semantic = aiTextureType_AMBIENT");
-						break;
-					case aiTextureType_EMISSIVE:
-						JN_CORE_TRACE("  Semantic = aiTextureType_EMISSIVE");
-						break;
-					case aiTextureType_HEIGHT:
-						JN_CORE_TRACE("  Semantic = aiTextureType_HEIGHT");
-						break;
-					case aiTextureType_NORMALS:
-						JN_CORE_TRACE("  Semantic = aiTextureType_NORMALS");
-						break;
-					case aiTextureType_SHININESS:
-						JN_CORE_TRACE("  Semantic = aiTextureType_SHININESS");
-						break;
-					case aiTextureType_OPACITY:
-						JN_CORE_TRACE("  Semantic = aiTextureType_OPACITY");
-						break;
-					case aiTextureType_DISPLACEMENT:
-						JN_CORE_TRACE("  Semantic = aiTextureType_DISPLACEMENT");
-						break;
-					case aiTextureType_LIGHTMAP:
-						JN_CORE_TRACE("  Semantic = aiTextureType_LIGHTMAP");
-						break;
-					case aiTextureType_REFLECTION:
-						JN_CORE_TRACE("  Semantic = aiTextureType_REFLECTION");
-						break;
-					case aiTextureType_UNKNOWN:
-						JN_CORE_TRACE("  Semantic = aiTextureType_UNKNOWN");
-						break;
-					}
-#endif
-                    //std::cout << "Material Property: " << std::endl;
-                    //std::cout << "Name = " << prop->mKey.data << std::endl << std::endl;
-                    if (prop->mType == aiPTI_String)
-                    {
-                        uint32_t strLength = *(uint32_t *)prop->mData;
-                        std::string str(prop->mData + 4, strLength);
-
-                        std::string key = prop->mKey.data;
-                        if (key == "$raw.ReflectionFactor|file")
-                        {
-                            metalnessTextureFound = true;
-                            std::filesystem::path path = filename;
-                            auto parentPath = path.parent_path();
-                            parentPath /= str;
-                            std::string texturePath = parentPath.string();
-                            auto texture = Ref<Texture2D>::Create(texturePath);
-                            if (texture->Loaded())
-                            {
-                                mi->Set("u_MetalnessTexture", texture);
-                                mi->Set("u_MetalnessTexToggle", 1.0f);
-                            }
-                            else
-                            {
-                                JN_CORE_ERROR("Could not load texture: {0}", texturePath);
-                                mi->Set("u_Metalness", metalness);
-                                mi->Set("u_MetalnessTexToggle", 0.0f);
-                            }
-                            break;
-                        }
-                    }
+                    JN_CORE_ERROR("MESH_IMPORT_MSG: Could not load texture: {0}", material.RoughnessMap);
                 }
+            }
+            else
+            {
+                mi->Set("u_RoughnessTexToggle", 0.0f);
+                mi->Set("u_Roughness", material.Roughness);
+            }
 
-                if (!metalnessTextureFound)
+            bool hasMetalnessTexture = false;
+            if (!material.MetalnessMap.empty())
+            {
+                auto texture = Ref<Texture2D>::Create(material.MetalnessMap);
+                if (texture->Loaded())
+                {
+                    mi->Set("u_MetalnessTexture", texture);
+                    mi->Set("u_MetalnessTexToggle", 1.0f);
+                    hasMetalnessTexture = true;
+                }
+                else
                 {
-                    JN_CORE_WARN("MESH_IMPORT_MSG: No metalness map");
-                    mi->Set("u_Metalness", metalness);
-                    mi->Set("u_MetalnessTexToggle", 0.0f);
+                    JN_CORE_ERROR("Could not load texture: {0}", material.MetalnessMap);
                 }
             }
+            else
+            {
+                JN_CORE_WARN("MESH_IMPORT_MSG: No metalness map");
+            }
+            if (!hasMetalnessTexture)
+            {
+                mi->Set("u_Metalness", material.Metalness);
+                mi->Set("u_MetalnessTexToggle", 0.0f);
+            }
         }
+    }
 
-        m_VertexBuffer = Ref<VertexBuffer>::Create(m_Vertices.data(), static_cast<uint32_t>(m_Vertices.size() * sizeof(Vertex)));
+    void Mesh::SetVertexFormat(MeshVertexFormat format)
+    {
+        JN_ASSERT(!Renderer::GetGeometryArena(), "MESH_ERROR: The vertex format must be set before the renderer is initialised!");
+        s_VertexFormat = format;
+    }
 
-        BufferLayout vertexLayout = {
+    MeshVertexFormat Mesh::GetVertexFormat()
+    {
+        return s_VertexFormat;
+    }
+
+    const BufferLayout &Mesh::GetVertexLayout()
+    {
+        static const BufferLayout layout = {
             {ShaderDataType::Float3, "a_Position"},
             {ShaderDataType::Float3, "a_Normal"},
             {ShaderDataType::Float3, "a_Tangent"},
             {ShaderDataType::Float3, "a_Binormal"},
             {ShaderDataType::Float2, "a_TexCoord"},
         };
-
-        m_VertexBuffer->SetLayout(vertexLayout);
-        m_IndexBuffer = Ref<IndexBuffer>::Create(m_Indices.data(), static_cast<uint32_t>(m_Indices.size() * sizeof(Index)));
-
-        PipelineSpecification pipelineSpecification;
-        pipelineSpecification.Layout = vertexLayout;
-        m_Pipeline = Ref<Pipeline>::Create(pipelineSpecification);
-
-        m_Scene = scene;
-    }
-
-    Mesh::~Mesh()
-    {
+        static const BufferLayout compactLayout = {
+            {ShaderDataType::UShort4, "a_Position", true},
+            {ShaderDataType::Short2, "a_Normal", true},
+            {ShaderDataType::Short2, "a_Tangent", true},
+            {ShaderDataType::Half2, "a_TexCoord"},
+        };
+        return s_VertexFormat == MeshVertexFormat::Compact ? compactLayout : layout;
     }
 
-    void Mesh::TraverseNodes(aiNode *node, const glm::mat4 &parentTransform, uint32_t level)
+    const BufferLayout &Mesh::GetInstanceLayout()
     {
-        glm::mat4 transform = parentTransform * Mat4FromAssimpMat4(node->mTransformation);
-        for (uint32_t i = 0; i < node->mNumMeshes; i++)
-        {
-            uint32_t mesh = node->mMeshes[i];
-            m_Submeshes[mesh].Transform = transform;
-        }
-
-        // JN_CORE_TRACE("{0} {1}", LevelToSpaces(level), node->mName.C_Str());
-
-        for (uint32_t i = 0; i < node->mNumChildren; i++)
-            TraverseNodes(node->mChildren[i], transform, level + 1);
+        static const BufferLayout layout = {
+            {ShaderDataType::Mat4, "a_InstanceTransform"},
+            {ShaderDataType::Int4, "a_InstanceLights"},
+        };
+        return layout;
     }
 }
\ No newline at end of file
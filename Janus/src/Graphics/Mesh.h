@@ -11,18 +11,9 @@
 #include "Graphics/Shader.h"
 #include "Graphics/Material.h"
 #include "Graphics/Pipeline.h"
+#include "Graphics/GeometryArena.h"
 #include "Graphics/ShaderLibrary.h"
-//#include "AABB.h"
-
-struct aiNode;
-struct aiAnimation;
-struct aiNodeAnim;
-struct aiScene;
-
-namespace Assimp
-{
-    class Importer;
-}
+#include "Math/AABB.h"
 
 namespace Janus
 {
@@ -35,8 +26,31 @@ namespace Janus
         glm::vec2 Texcoord;
     };
 
+    // Vertex attribute locations reserved in either format; per-instance attributes start after them
     static const int NumAttributes = 5;
 
+    // Vertex format of every mesh in the geometry arena. Compact vertices are 20 bytes against the 56 of
+    // Vertex, at the cost of a quantized position and a rebuilt bitangent
+    enum class MeshVertexFormat : uint8_t
+    {
+        Full = 0,
+        Compact
+    };
+
+    struct CompactVertex
+    {
+        // Position in the unit cube given by the submesh's PositionDecode, 16-bit normalized. w is set when
+        // the bitangent points against cross(normal, tangent)
+        uint16_t Position[4];
+        // Octahedral-encoded unit vectors, 16-bit signed normalized
+        int16_t Normal[2];
+        int16_t Tangent[2];
+        // Half floats
+        uint16_t Texcoord[2];
+    };
+
+    static_assert(sizeof(CompactVertex) == 20);
+
     struct Index
     {
         uint32_t V1, V2, V3;
@@ -44,20 +58,69 @@ namespace Janus
 
     static_assert(sizeof(Index) == 3 * sizeof(uint32_t));
 
+    // Per-instance vertex data, as Mesh::GetInstanceLayout describes it
+    struct MeshInstance
+    {
+        glm::mat4 Transform;
+        // Point lights selected for the instance, see LightSelector. All bits set when there are none
+        glm::uvec4 Lights;
+    };
+
+    static_assert(sizeof(MeshInstance) == sizeof(glm::mat4) + 4 * sizeof(uint32_t));
+
+    // A simplified version of a submesh, drawing the submesh's vertices with its own indices
+    struct SubmeshLod
+    {
+        uint32_t BaseIndex;
+        uint32_t IndexCount;
+        // Largest distance of the simplified surface from the original, relative to the bounding radius
+        float Error;
+    };
+
     class Submesh
     {
     public:
+        // Levels of detail of a submesh, including the full detail level 0
+        static constexpr uint32_t MaxLods = 4;
+
         uint32_t BaseVertex;
         uint32_t BaseIndex;
         uint32_t MaterialIndex;
         uint32_t IndexCount;
-        glm::mat4 Transform;
-        //AABB BoundingBox;
+        glm::mat4 Transform{1.0f};
+        // Bounds of the submesh vertices, before Transform is applied
+        AABB BoundingBox;
+        // Offset (xyz) and uniform scale (w) mapping compact vertex positions back to mesh space
+        glm::vec4 PositionDecode{0.0f, 0.0f, 0.0f, 1.0f};
+        // Number of levels including level 0. Lods holds levels 1 and up, each coarser than the last
+        uint32_t LodCount = 1;
+        SubmeshLod Lods[MaxLods - 1] = {};
+
+        SubmeshLod GetLod(uint32_t lod) const
+        {
+            return lod == 0 ? SubmeshLod{BaseIndex, IndexCount, 0.0f} : Lods[lod - 1];
+        }
+
+        // Transform with the position decode applied, for the vertex shader
+        glm::mat4 GetVertexTransform() const
+        {
+            glm::mat4 transform = Transform;
+            transform[3] = Transform * glm::vec4(glm::vec3(PositionDecode), 1.0f);
+            transform[0] *= PositionDecode.w;
+            transform[1] *= PositionDecode.w;
+            transform[2] *= PositionDecode.w;
+            return transform;
+        }
     };
 
+    struct MeshContents;
+    struct MeshMaterialDescription;
+
     class Mesh : public RefCounted
     {
     public:
+        // Loads the cooked form of the file if it is up to date, and imports and cooks the file otherwise.
+        // Cooked .jmesh files can also be loaded directly
         Mesh(const std::string &filename);
         ~Mesh();
 
@@ -65,26 +128,35 @@ namespace Janus
         void DumpVertexBuffer();
 
         Ref<Shader> GetMeshShader() { return m_MeshShader; }
-        const std::vector<Ref<Material>> GetMaterials() { return m_Materials; }
+        const std::vector<Ref<Material>> &GetMaterials() const { return m_Materials; }
         const std::vector<Ref<Texture>> &GetTextures() const { return m_Textures; }
         const std::string &GetFilePath() const { return m_FilePath; }
+        // Bounds of all submeshes in mesh space
+        const AABB &GetBoundingBox() const { return m_BoundingBox; }
+        // Vertex and index ranges of this mesh in the shared geometry arena. Submesh offsets are relative to them
+        const GeometryArena::Allocation &GetGeometryAllocation() const { return m_GeometryAllocation; }
+
+        // Selects the vertex format meshes are cooked and drawn in. Has to be set before the renderer is
+        // initialised, as the geometry arena is created for one format
+        static void SetVertexFormat(MeshVertexFormat format);
+        static MeshVertexFormat GetVertexFormat();
+        // Layout of Vertex or CompactVertex, shared by every mesh through the geometry arena
+        static const BufferLayout &GetVertexLayout();
+        // Per-instance attributes that follow the vertex attributes
+        static const BufferLayout &GetInstanceLayout();
         std::vector<Submesh> m_Submeshes;
 
     private:
-        void TraverseNodes(aiNode *node, const glm::mat4 &parentTransform = glm::mat4(1.0f), uint32_t level = 0);
+        void Build(const MeshContents &contents);
+        void CreateMaterials(const std::vector<MeshMaterialDescription> &materials);
 
     private:
-        std::unique_ptr<Assimp::Importer> m_Importer;
-
         glm::mat4 m_InverseTransform;
+        AABB m_BoundingBox;
 
-        Ref<Pipeline> m_Pipeline;
-        Ref<VertexBuffer> m_VertexBuffer;
-        Ref<IndexBuffer> m_IndexBuffer;
+        Ref<GeometryArena> m_GeometryArena;
+        GeometryArena::Allocation m_GeometryAllocation;
         Ref<Shader> m_MeshShader;
-        std::vector<Vertex> m_Vertices;
-        std::vector<Index> m_Indices;
-        const aiScene *m_Scene;
 
         // Materials
         std::vector<Ref<Texture>> m_Textures;
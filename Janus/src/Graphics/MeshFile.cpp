@@ -0,0 +1,338 @@
+#include "jnpch.h"
+#include "Graphics/MeshFile.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace Janus
+{
+	static const char *s_CookedDirectory = "cache/meshes";
+	static const char *s_CookedExtension = ".jmesh";
+	static constexpr uint32_t s_MeshFileMagic = 0x4a4d5348; // "JMSH"
+	static constexpr uint32_t s_MeshFileVersion = 5;
+	// Sections start at multiples of this, so the arrays can be read in place
+	static constexpr uint64_t s_SectionAlignment = 16;
+
+	// Offsets are in bytes from the start of the file
+	struct MeshFileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t VertexStride;
+		// Bytes per index, 2 or 4
+		uint32_t IndexSize;
+		uint32_t VertexFormat;
+		uint32_t Reserved;
+		uint64_t SourceSize;
+		int64_t SourceTime;
+
+		uint32_t VertexCount;
+		uint32_t IndexCount;
+		uint32_t SubmeshCount;
+		uint32_t MaterialCount;
+		uint64_t VertexOffset;
+		uint64_t IndexOffset;
+		uint64_t SubmeshOffset;
+		uint64_t MaterialOffset;
+		uint64_t StringOffset;
+		uint64_t StringSize;
+
+		glm::vec3 BoundsMin;
+		glm::vec3 BoundsMax;
+		glm::mat4 InverseTransform;
+	};
+
+	struct MeshFileSubmesh
+	{
+		uint32_t BaseVertex;
+		uint32_t BaseIndex;
+		uint32_t MaterialIndex;
+		uint32_t IndexCount;
+		glm::mat4 Transform;
+		glm::vec3 BoundsMin;
+		glm::vec3 BoundsMax;
+		glm::vec4 PositionDecode;
+		uint32_t LodCount;
+		SubmeshLod Lods[Submesh::MaxLods - 1];
+	};
+
+	// A range of the string section
+	struct MeshFileString
+	{
+		uint32_t Offset;
+		uint32_t Length;
+	};
+
+	struct MeshFileMaterial
+	{
+		glm::vec3 AlbedoColor;
+		float Roughness;
+		float Metalness;
+		float Opacity;
+		uint32_t Transparent;
+		MeshFileString Name;
+		MeshFileString AlbedoMap;
+		MeshFileString NormalMap;
+		MeshFileString RoughnessMap;
+		MeshFileString MetalnessMap;
+	};
+
+	static uint32_t GetVertexStride(MeshVertexFormat format)
+	{
+		return format == MeshVertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
+	}
+
+	static uint64_t AlignSection(uint64_t offset)
+	{
+		return (offset + s_SectionAlignment - 1) & ~(s_SectionAlignment - 1);
+	}
+
+	// Returns false if the source does not exist
+	static bool GetSourceStamp(const std::string &sourcePath, uint64_t &size, int64_t &time)
+	{
+		std::error_code error;
+		size = std::filesystem::file_size(sourcePath, error);
+		if (error)
+			return false;
+		time = (int64_t)std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+		return !error;
+	}
+
+	bool MeshFile::IsCookedPath(const std::string &path)
+	{
+		return std::filesystem::path(path).extension() == s_CookedExtension;
+	}
+
+	std::string MeshFile::GetCookedPath(const std::string &sourcePath, MeshVertexFormat format)
+	{
+		// The same file name can appear in several asset directories, so the name is suffixed with a hash
+		// of the full path
+		std::string normalizedPath = std::filesystem::absolute(sourcePath).lexically_normal().generic_string();
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : normalizedPath)
+		{
+			hash ^= (uint8_t)c;
+			hash *= 1099511628211ull;
+		}
+
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "-%016llx%s", (unsigned long long)hash, format == MeshVertexFormat::Compact ? "-c" : "");
+		std::string name = std::filesystem::path(sourcePath).stem().string() + suffix + s_CookedExtension;
+		return (std::filesystem::path(s_CookedDirectory) / name).string();
+	}
+
+	static bool ReadContents(const std::string &path, const std::string &sourcePath, MeshVertexFormat format, const MappedFile &file, MeshContents &contents)
+	{
+		const uint8_t *data = file.GetData();
+		uint64_t fileSize = file.GetSize();
+		MeshFileHeader header;
+		if (fileSize < sizeof(header))
+			return false;
+		memcpy(&header, data, sizeof(header));
+		if (header.Magic != s_MeshFileMagic || header.Version != s_MeshFileVersion)
+			return false;
+		if (header.VertexFormat != (uint32_t)format || header.VertexStride != GetVertexStride(format))
+		{
+			JN_CORE_INFO("MESH_MSG: {0} was cooked in another vertex format", path);
+			return false;
+		}
+
+		uint64_t sourceSize;
+		int64_t sourceTime;
+		if (!sourcePath.empty() && GetSourceStamp(sourcePath, sourceSize, sourceTime) && (sourceSize != header.SourceSize || sourceTime != header.SourceTime))
+		{
+			JN_CORE_INFO("MESH_MSG: {0} changed since it was cooked", sourcePath);
+			return false;
+		}
+
+		// Every section has to lie inside the file and be aligned for reading in place
+		auto isSection = [fileSize](uint64_t offset, uint64_t count, uint64_t stride)
+		{
+			return offset % s_SectionAlignment == 0 && offset <= fileSize && count <= (fileSize - offset) / stride;
+		};
+		bool validIndexSize = header.IndexSize == GetIndexSize(IndexFormat::UInt16) || header.IndexSize == GetIndexSize(IndexFormat::UInt32);
+		if (!header.VertexCount || !header.IndexCount || header.IndexCount % 3 != 0 || !validIndexSize ||
+			!isSection(header.VertexOffset, header.VertexCount, header.VertexStride) ||
+			!isSection(header.IndexOffset, header.IndexCount, header.IndexSize) ||
+			!isSection(header.SubmeshOffset, header.SubmeshCount, sizeof(MeshFileSubmesh)) ||
+			!isSection(header.MaterialOffset, header.MaterialCount, sizeof(MeshFileMaterial)) ||
+			!isSection(header.StringOffset, header.StringSize, 1))
+		{
+			JN_CORE_WARN("MESH_MSG: {0} is not a valid cooked mesh", path);
+			return false;
+		}
+
+		contents.Vertices = data + header.VertexOffset;
+		contents.VertexCount = header.VertexCount;
+		contents.VertexFormat = format;
+		contents.Indices = data + header.IndexOffset;
+		contents.IndexCount = header.IndexCount;
+		contents.Format = header.IndexSize == GetIndexSize(IndexFormat::UInt16) ? IndexFormat::UInt16 : IndexFormat::UInt32;
+		contents.BoundingBox = AABB(header.BoundsMin, header.BoundsMax);
+		contents.InverseTransform = header.InverseTransform;
+
+		const MeshFileSubmesh *submeshes = (const MeshFileSubmesh *)(data + header.SubmeshOffset);
+		contents.Submeshes.resize(header.SubmeshCount);
+		for (uint32_t i = 0; i < header.SubmeshCount; i++)
+		{
+			const MeshFileSubmesh &source = submeshes[i];
+			bool validLods = source.LodCount >= 1 && source.LodCount <= Submesh::MaxLods;
+			for (uint32_t lod = 1; validLods && lod < source.LodCount; lod++)
+				validLods = (uint64_t)source.Lods[lod - 1].BaseIndex + source.Lods[lod - 1].IndexCount <= header.IndexCount;
+			if ((uint64_t)source.BaseVertex >= header.VertexCount || (uint64_t)source.BaseIndex + source.IndexCount > header.IndexCount ||
+				source.MaterialIndex >= header.MaterialCount || !validLods)
+			{
+				JN_CORE_WARN("MESH_MSG: {0} is not a valid cooked mesh", path);
+				return false;
+			}
+
+			Submesh &submesh = contents.Submeshes[i];
+			submesh.BaseVertex = source.BaseVertex;
+			submesh.BaseIndex = source.BaseIndex;
+			submesh.MaterialIndex = source.MaterialIndex;
+			submesh.IndexCount = source.IndexCount;
+			submesh.Transform = source.Transform;
+			submesh.BoundingBox = AABB(source.BoundsMin, source.BoundsMax);
+			submesh.PositionDecode = source.PositionDecode;
+			submesh.LodCount = source.LodCount;
+			std::copy(source.Lods, source.Lods + Submesh::MaxLods - 1, submesh.Lods);
+		}
+
+		const char *strings = (const char *)(data + header.StringOffset);
+		bool stringsValid = true;
+		auto readString = [&](const MeshFileString &string)
+		{
+			if ((uint64_t)string.Offset + string.Length > header.StringSize)
+			{
+				stringsValid = false;
+				return std::string();
+			}
+			return std::string(strings + string.Offset, string.Length);
+		};
+
+		const MeshFileMaterial *materials = (const MeshFileMaterial *)(data + header.MaterialOffset);
+		contents.Materials.resize(header.MaterialCount);
+		for (uint32_t i = 0; i < header.MaterialCount; i++)
+		{
+			const MeshFileMaterial &source = materials[i];
+			MeshMaterialDescription &material = contents.Materials[i];
+			material.Name = readString(source.Name);
+			material.AlbedoColor = source.AlbedoColor;
+			material.Roughness = source.Roughness;
+			material.Metalness = source.Metalness;
+			material.Opacity = source.Opacity;
+			material.Transparent = source.Transparent != 0;
+			material.AlbedoMap = readString(source.AlbedoMap);
+			material.NormalMap = readString(source.NormalMap);
+			material.RoughnessMap = readString(source.RoughnessMap);
+			material.MetalnessMap = readString(source.MetalnessMap);
+		}
+		if (!stringsValid)
+		{
+			JN_CORE_WARN("MESH_MSG: {0} is not a valid cooked mesh", path);
+			return false;
+		}
+		return true;
+	}
+
+	bool MeshFile::Read(const std::string &path, const std::string &sourcePath, MeshVertexFormat format, Ref<MappedFile> &file, MeshContents &contents)
+	{
+		JN_PROFILE_FUNCTION();
+		file = Ref<MappedFile>::Create();
+		if (file->Open(path) && ReadContents(path, sourcePath, format, *file, contents))
+			return true;
+
+		// Unmap right away, the file is about to be cooked again
+		file = nullptr;
+		contents = {};
+		return false;
+	}
+
+	bool MeshFile::Write(const std::string &path, const std::string &sourcePath, const MeshContents &contents)
+	{
+		JN_PROFILE_FUNCTION();
+		MeshFileHeader header = {};
+		header.Magic = s_MeshFileMagic;
+		header.Version = s_MeshFileVersion;
+		header.VertexStride = GetVertexStride(contents.VertexFormat);
+		header.VertexFormat = (uint32_t)contents.VertexFormat;
+		header.IndexSize = GetIndexSize(contents.Format);
+		GetSourceStamp(sourcePath, header.SourceSize, header.SourceTime);
+
+		std::string strings;
+		auto addString = [&strings](const std::string &string)
+		{
+			MeshFileString range = {(uint32_t)strings.size(), (uint32_t)string.size()};
+			strings += string;
+			return range;
+		};
+
+		std::vector<MeshFileSubmesh> submeshes;
+		submeshes.reserve(contents.Submeshes.size());
+		for (const Submesh &submesh : contents.Submeshes)
+		{
+			submeshes.push_back({submesh.BaseVertex, submesh.BaseIndex, submesh.MaterialIndex, submesh.IndexCount, submesh.Transform, submesh.BoundingBox.Min, submesh.BoundingBox.Max, submesh.PositionDecode, submesh.LodCount});
+			std::copy(submesh.Lods, submesh.Lods + Submesh::MaxLods - 1, submeshes.back().Lods);
+		}
+
+		std::vector<MeshFileMaterial> materials;
+		materials.reserve(contents.Materials.size());
+		for (const MeshMaterialDescription &material : contents.Materials)
+		{
+			materials.push_back({material.AlbedoColor, material.Roughness, material.Metalness, material.Opacity, material.Transparent, addString(material.Name),
+								 addString(material.AlbedoMap), addString(material.NormalMap), addString(material.RoughnessMap), addString(material.MetalnessMap)});
+		}
+
+		header.VertexCount = contents.VertexCount;
+		header.IndexCount = contents.IndexCount;
+		header.SubmeshCount = (uint32_t)submeshes.size();
+		header.MaterialCount = (uint32_t)materials.size();
+		header.VertexOffset = AlignSection(sizeof(header));
+		header.IndexOffset = AlignSection(header.VertexOffset + (uint64_t)contents.VertexCount * header.VertexStride);
+		header.SubmeshOffset = AlignSection(header.IndexOffset + (uint64_t)contents.IndexCount * header.IndexSize);
+		header.MaterialOffset = AlignSection(header.SubmeshOffset + submeshes.size() * sizeof(MeshFileSubmesh));
+		header.StringOffset = AlignSection(header.MaterialOffset + materials.size() * sizeof(MeshFileMaterial));
+		header.StringSize = strings.size();
+		header.BoundsMin = contents.BoundingBox.Min;
+		header.BoundsMax = contents.BoundingBox.Max;
+		header.InverseTransform = contents.InverseTransform;
+
+		std::error_code error;
+		std::filesystem::path filePath = path;
+		if (filePath.has_parent_path())
+			std::filesystem::create_directories(filePath.parent_path(), error);
+		// Write under a temporary name so a crash never leaves a truncated mesh behind
+		std::filesystem::path temporaryPath = filePath;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!out)
+			{
+				JN_CORE_WARN("MESH_MSG: Could not write {0}", temporaryPath.string());
+				return false;
+			}
+
+			uint64_t written = 0;
+			auto writeSection = [&out, &written](uint64_t offset, const void *data, uint64_t size)
+			{
+				static const char padding[s_SectionAlignment] = {};
+				out.write(padding, (std::streamsize)(offset - written));
+				out.write((const char *)data, (std::streamsize)size);
+				written = offset + size;
+			};
+			writeSection(0, &header, sizeof(header));
+			writeSection(header.VertexOffset, contents.Vertices, (uint64_t)contents.VertexCount * header.VertexStride);
+			writeSection(header.IndexOffset, contents.Indices, (uint64_t)contents.IndexCount * header.IndexSize);
+			writeSection(header.SubmeshOffset, submeshes.data(), submeshes.size() * sizeof(MeshFileSubmesh));
+			writeSection(header.MaterialOffset, materials.data(), materials.size() * sizeof(MeshFileMaterial));
+			writeSection(header.StringOffset, strings.data(), strings.size());
+			if (!out)
+			{
+				JN_CORE_WARN("MESH_MSG: Could not write {0}", temporaryPath.string());
+				return false;
+			}
+		}
+		std::filesystem::rename(temporaryPath, filePath, error);
+		return !error;
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Core/MappedFile.h"
+#include "Graphics/Mesh.h"
+
+namespace Janus
+{
+	// A mesh material as imported: its parameters and the paths of the textures it samples, so the material
+	// can be rebuilt without the source file. Empty paths mean the material has no such texture
+	struct MeshMaterialDescription
+	{
+		std::string Name;
+		glm::vec3 AlbedoColor = glm::vec3(1.0f);
+		float Roughness = 1.0f;
+		float Metalness = 0.0f;
+		// Transparent materials are blended with this opacity and drawn back to front after opaque ones
+		float Opacity = 1.0f;
+		bool Transparent = false;
+		std::string AlbedoMap;
+		std::string NormalMap;
+		std::string RoughnessMap;
+		std::string MetalnessMap;
+	};
+
+	// Everything a Mesh is built from. Vertices and indices are not owned; they point into an importer's
+	// arrays or straight into a mapped cooked file
+	struct MeshContents
+	{
+		// VertexCount vertices, Vertex or CompactVertex depending on VertexFormat
+		const void *Vertices = nullptr;
+		uint32_t VertexCount = 0;
+		MeshVertexFormat VertexFormat = MeshVertexFormat::Full;
+		// IndexCount indices of Format, three per triangle
+		const void *Indices = nullptr;
+		uint32_t IndexCount = 0;
+		IndexFormat Format = IndexFormat::UInt32;
+		std::vector<Submesh> Submeshes;
+		std::vector<MeshMaterialDescription> Materials;
+		// Bounds of all submeshes in mesh space
+		AABB BoundingBox;
+		glm::mat4 InverseTransform{1.0f};
+	};
+
+	// Geometry produced by an importer. Contents points into the arrays, which live until the mesh has been
+	// cooked and uploaded. Importers fill Vertices and Indices; CompactVertices and ShortIndices hold them
+	// once they are packed
+	struct ImportedMesh
+	{
+		std::vector<Vertex> Vertices;
+		std::vector<Index> Indices;
+		std::vector<CompactVertex> CompactVertices;
+		std::vector<uint16_t> ShortIndices;
+		MeshContents Contents;
+	};
+
+	// Cooked meshes (.jmesh). The final vertex and index arrays are stored exactly as they are uploaded,
+	// followed by the submesh table and material descriptions, so loading maps the file and reads the
+	// geometry in place without any parsing. Cooked files of imported assets live in cache/meshes and
+	// record the size and modification time of their source, so editing the source cooks it again.
+	// Each vertex format is cooked to its own file
+	class MeshFile
+	{
+	public:
+		static bool IsCookedPath(const std::string &path);
+		// Where the cooked form of a source asset is kept
+		static std::string GetCookedPath(const std::string &sourcePath, MeshVertexFormat format);
+
+		// Maps the file and points contents at it. Returns false if the file is missing, malformed, from
+		// another version, in another vertex format or older than sourcePath. A source that does not exist,
+		// or an empty sourcePath, is not checked, so cooked files can be shipped without their sources
+		static bool Read(const std::string &path, const std::string &sourcePath, MeshVertexFormat format, Ref<MappedFile> &file, MeshContents &contents);
+		static bool Write(const std::string &path, const std::string &sourcePath, const MeshContents &contents);
+	};
+}
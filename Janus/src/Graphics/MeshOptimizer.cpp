@@ -0,0 +1,629 @@
+#include "jnpch.h"
+#include "Graphics/MeshOptimizer.h"
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "Core/ThreadPool.h"
+#include "Graphics/MeshFile.h"
+#include "Graphics/MeshSimplifier.h"
+
+namespace Janus
+{
+	// LRU cache simulated while ordering triangles, and the smaller FIFO cache that results are measured with
+	static constexpr uint32_t s_CacheSize = 32;
+	static constexpr uint32_t s_AnalysisCacheSize = 16;
+	// Vertex scoring constants from Forsyth, "Linear-Speed Vertex Cache Optimisation"
+	static constexpr float s_CacheDecayPower = 1.5f;
+	static constexpr float s_LastTriangleScore = 0.75f;
+	static constexpr float s_ValenceBoostScale = 2.0f;
+	static constexpr float s_ValenceBoostPower = 0.5f;
+	// Overdraw ordering is dropped if it costs more vertex cache misses than this factor
+	static constexpr float s_OverdrawThreshold = 1.05f;
+	static constexpr uint32_t s_InvalidIndex = 0xffffffff;
+
+	// Target index count, as a share of the full detail, and largest error, relative to the bounding radius,
+	// of every generated level of detail
+	struct LodTarget
+	{
+		float IndexRatio;
+		float MaxError;
+	};
+	static constexpr LodTarget s_LodTargets[Submesh::MaxLods - 1] = {{0.5f, 0.01f}, {0.25f, 0.02f}, {0.125f, 0.05f}};
+	// A level is only kept if it draws at most this share of the previous level's triangles
+	static constexpr float s_MinLodReduction = 0.8f;
+	// Smaller index ranges are drawn at full detail only
+	static constexpr uint32_t s_MinLodTriangles = 64;
+
+	// A simplified version of one of a range's index ranges
+	struct RangeLod
+	{
+		uint32_t IndexRange;
+		float Error;
+		std::vector<uint32_t> Indices;
+		// Offset in the mesh's index array, once appended
+		uint32_t BaseIndex = 0;
+	};
+
+	// A range of vertices together with the index ranges of the submeshes drawing from it
+	struct GeometryRange
+	{
+		uint32_t BaseVertex = 0;
+		uint32_t VertexCount = 0;
+		// Offset and count in the mesh's index array
+		std::vector<std::pair<uint32_t, uint32_t>> IndexRanges;
+		// Levels of detail of the index ranges, each range's coarser levels after its finer ones
+		std::vector<RangeLod> Lods;
+
+		std::vector<Vertex> OptimizedVertices;
+		uint32_t MissesBefore = 0;
+		uint32_t VerticesBefore = 0;
+		uint32_t MissesAfter = 0;
+		uint32_t VerticesAfter = 0;
+	};
+
+	// Vertices loaded by a FIFO cache drawing the triangles. A vertex is cached while fewer than the cache
+	// size of other vertices have been loaded since it was
+	static uint32_t CountCacheMisses(const uint32_t *indices, uint32_t indexCount, std::vector<uint32_t> &timestamps)
+	{
+		std::fill(timestamps.begin(), timestamps.end(), 0);
+		uint32_t time = s_AnalysisCacheSize + 1;
+		uint32_t misses = 0;
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			uint32_t vertex = indices[i];
+			if (time - timestamps[vertex] > s_AnalysisCacheSize)
+			{
+				timestamps[vertex] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	// Cache misses summed over the index ranges, each drawn with an empty cache, and the number of distinct
+	// vertices they reference
+	static void AnalyzeRange(const uint32_t *indices, const GeometryRange &range, uint32_t vertexCount, uint32_t &misses, uint32_t &referenced)
+	{
+		std::vector<uint32_t> timestamps(vertexCount);
+		std::vector<uint8_t> used(vertexCount, 0);
+		misses = 0;
+		for (auto [baseIndex, indexCount] : range.IndexRanges)
+		{
+			misses += CountCacheMisses(indices + baseIndex, indexCount, timestamps);
+			for (uint32_t i = 0; i < indexCount; i++)
+				used[indices[baseIndex + i]] = 1;
+		}
+		referenced = (uint32_t)std::count(used.begin(), used.end(), 1);
+	}
+
+	static uint64_t HashVertex(const Vertex &vertex)
+	{
+		uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+		memcpy(words, &vertex, sizeof(words));
+		uint64_t hash = 14695981039346656037ull;
+		for (uint32_t word : words)
+		{
+			hash ^= word;
+			hash *= 1099511628211ull;
+		}
+		return hash ^ (hash >> 32);
+	}
+
+	// Maps every vertex to the first one with identical bytes. Importers zero the attributes a source lacks,
+	// so equal vertices compare equal
+	static void WeldVertices(const Vertex *vertices, uint32_t vertexCount, std::vector<uint32_t> &remap, std::vector<Vertex> &welded)
+	{
+		uint32_t tableSize = 1;
+		while (tableSize < vertexCount * 2)
+			tableSize *= 2;
+		std::vector<uint32_t> table(tableSize, s_InvalidIndex);
+
+		remap.resize(vertexCount);
+		welded.clear();
+		welded.reserve(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			uint32_t slot = (uint32_t)HashVertex(vertices[i]) & (tableSize - 1);
+			while (table[slot] != s_InvalidIndex && memcmp(&welded[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+				slot = (slot + 1) & (tableSize - 1);
+
+			if (table[slot] == s_InvalidIndex)
+			{
+				table[slot] = (uint32_t)welded.size();
+				welded.push_back(vertices[i]);
+			}
+			remap[i] = table[slot];
+		}
+	}
+
+	static float GetVertexScore(int32_t cachePosition, uint32_t liveTriangles)
+	{
+		if (liveTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// The last triangle's vertices are scored flat, so its neighbours are not favoured by edge order
+			if (cachePosition < 3)
+				score = s_LastTriangleScore;
+			else
+				score = std::pow(1.0f - (float)(cachePosition - 3) / (s_CacheSize - 3), s_CacheDecayPower);
+		}
+		// Vertices with few triangles left are finished off before they leave the cache
+		return score + s_ValenceBoostScale * std::pow((float)liveTriangles, -s_ValenceBoostPower);
+	}
+
+	// Greedily emits the triangle whose vertices score highest, after Forsyth. Only the triangles of vertices
+	// in the simulated cache are rescored after each step, so the cost is linear in the triangle count
+	static void OptimizeVertexCache(uint32_t *indices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		uint32_t triangleCount = indexCount / 3;
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (uint32_t i = 0; i < indexCount; i++)
+			liveTriangles[indices[i]]++;
+
+		// Triangles using each vertex; the live ones are kept at the front of every list
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (uint32_t v = 0; v < vertexCount; v++)
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+		std::vector<uint32_t> adjacency(indexCount);
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (uint32_t i = 0; i < indexCount; i++)
+				adjacency[fill[indices[i]]++] = i / 3;
+		}
+
+		std::vector<int32_t> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+			vertexScores[v] = GetVertexScore(-1, liveTriangles[v]);
+
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		std::vector<uint32_t> output;
+		output.reserve(indexCount);
+
+		// Room for a whole triangle past the end, to evict from
+		uint32_t cache[s_CacheSize + 3];
+		uint32_t cacheCount = 0;
+		uint32_t bestTriangle = s_InvalidIndex;
+		uint32_t nextTriangle = 0;
+		for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			if (bestTriangle == s_InvalidIndex)
+			{
+				// Nothing in the cache has triangles left, so carry on in the original order
+				while (emitted[nextTriangle])
+					nextTriangle++;
+				bestTriangle = nextTriangle;
+			}
+
+			const uint32_t *triangle = &indices[bestTriangle * 3];
+			emitted[bestTriangle] = 1;
+			output.insert(output.end(), triangle, triangle + 3);
+
+			// The triangle's vertices move to the front of the cache and lose it from their live lists
+			uint32_t newCache[s_CacheSize + 3];
+			uint32_t newCacheCount = 0;
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t vertex = triangle[k];
+				if (std::find(newCache, newCache + newCacheCount, vertex) == newCache + newCacheCount)
+					newCache[newCacheCount++] = vertex;
+
+				uint32_t *live = &adjacency[adjacencyOffsets[vertex]];
+				uint32_t *last = live + liveTriangles[vertex] - 1;
+				std::swap(*std::find(live, last + 1, bestTriangle), *last);
+				liveTriangles[vertex]--;
+			}
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				uint32_t vertex = cache[i];
+				if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+					newCache[newCacheCount++] = vertex;
+			}
+
+			for (uint32_t i = 0; i < newCacheCount; i++)
+			{
+				uint32_t vertex = newCache[i];
+				cachePositions[vertex] = i < s_CacheSize ? (int32_t)i : -1;
+				vertexScores[vertex] = GetVertexScore(cachePositions[vertex], liveTriangles[vertex]);
+			}
+
+			// Only triangles touching the cache changed score, so the next triangle is picked among them
+			float bestScore = -1.0f;
+			bestTriangle = s_InvalidIndex;
+			for (uint32_t i = 0; i < newCacheCount; i++)
+			{
+				uint32_t vertex = newCache[i];
+				const uint32_t *live = &adjacency[adjacencyOffsets[vertex]];
+				for (uint32_t j = 0; j < liveTriangles[vertex]; j++)
+				{
+					uint32_t t = live[j];
+					float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = t;
+					}
+				}
+			}
+
+			cacheCount = std::min(newCacheCount, s_CacheSize);
+			memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+		}
+
+		memcpy(indices, output.data(), indexCount * sizeof(uint32_t));
+	}
+
+	// Splits the cache-ordered triangles into clusters wherever the cache starts cold, then draws the clusters
+	// facing away from the mesh centre first, so they occlude the rest. After Sander et al., "Fast Triangle
+	// Reordering for Vertex Locality and Reduced Overdraw". The new order is kept only if the vertex cache
+	// stays nearly as efficient
+	static void OptimizeOverdraw(uint32_t *indices, uint32_t indexCount, const Vertex *vertices, uint32_t vertexCount)
+	{
+		uint32_t triangleCount = indexCount / 3;
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		std::vector<uint32_t> clusterStarts;
+		uint32_t time = s_AnalysisCacheSize + 1;
+		uint32_t missesBefore = 0;
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			uint32_t misses = 0;
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t vertex = indices[t * 3 + k];
+				if (time - timestamps[vertex] > s_AnalysisCacheSize)
+				{
+					timestamps[vertex] = time++;
+					misses++;
+				}
+			}
+			if (t == 0 || misses == 3)
+				clusterStarts.push_back(t);
+			missesBefore += misses;
+		}
+		if (clusterStarts.size() < 2)
+			return;
+		clusterStarts.push_back(triangleCount);
+
+		uint32_t clusterCount = (uint32_t)clusterStarts.size() - 1;
+		std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+		std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+		std::vector<float> clusterAreas(clusterCount, 0.0f);
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		for (uint32_t c = 0; c < clusterCount; c++)
+		{
+			for (uint32_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+			{
+				const glm::vec3 &p0 = vertices[indices[t * 3]].Position;
+				const glm::vec3 &p1 = vertices[indices[t * 3 + 1]].Position;
+				const glm::vec3 &p2 = vertices[indices[t * 3 + 2]].Position;
+				// Twice the area, which cancels out in the weighted averages
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal);
+				clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+				clusterNormals[c] += normal;
+				clusterAreas[c] += area;
+			}
+			meshCentroid += clusterCentroids[c];
+			meshArea += clusterAreas[c];
+		}
+		if (meshArea <= 0.0f)
+			return;
+		meshCentroid /= meshArea;
+
+		std::vector<float> sortKeys(clusterCount, 0.0f);
+		for (uint32_t c = 0; c < clusterCount; c++)
+		{
+			float normalLength = glm::length(clusterNormals[c]);
+			if (clusterAreas[c] > 0.0f && normalLength > 0.0f)
+				sortKeys[c] = glm::dot(clusterCentroids[c] / clusterAreas[c] - meshCentroid, clusterNormals[c] / normalLength);
+		}
+
+		std::vector<uint32_t> clusterOrder(clusterCount);
+		for (uint32_t c = 0; c < clusterCount; c++)
+			clusterOrder[c] = c;
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](uint32_t a, uint32_t b)
+						 { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> reordered;
+		reordered.reserve(indexCount);
+		for (uint32_t c : clusterOrder)
+			reordered.insert(reordered.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+
+		uint32_t missesAfter = CountCacheMisses(reordered.data(), indexCount, timestamps);
+		if (missesAfter <= missesBefore * s_OverdrawThreshold)
+			memcpy(indices, reordered.data(), indexCount * sizeof(uint32_t));
+	}
+
+	// Renumbers vertices in the order the triangles first use them, so vertex fetch walks memory forwards.
+	// Vertices no triangle uses are dropped
+	static void OptimizeVertexFetch(uint32_t *indices, GeometryRange &range, const std::vector<Vertex> &vertices, std::vector<Vertex> &output)
+	{
+		std::vector<uint32_t> remap(vertices.size(), s_InvalidIndex);
+		output.clear();
+		output.reserve(vertices.size());
+		for (auto [baseIndex, indexCount] : range.IndexRanges)
+		{
+			for (uint32_t i = baseIndex; i < baseIndex + indexCount; i++)
+			{
+				uint32_t &newIndex = remap[indices[i]];
+				if (newIndex == s_InvalidIndex)
+				{
+					newIndex = (uint32_t)output.size();
+					output.push_back(vertices[indices[i]]);
+				}
+				indices[i] = newIndex;
+			}
+		}
+
+		// Levels of detail only use vertices of the full detail
+		for (RangeLod &lod : range.Lods)
+		{
+			for (uint32_t &index : lod.Indices)
+				index = remap[index];
+		}
+	}
+
+	// Simplifies a cache-ordered index range into progressively coarser levels. Each level is simplified from
+	// the full detail, so its error is measured against the original surface
+	static void GenerateLods(const uint32_t *indices, uint32_t indexCount, uint32_t indexRange, const std::vector<Vertex> &vertices, GeometryRange &range)
+	{
+		if (indexCount / 3 < s_MinLodTriangles)
+			return;
+
+		glm::vec3 min = vertices[indices[0]].Position, max = min;
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			min = glm::min(min, vertices[indices[i]].Position);
+			max = glm::max(max, vertices[indices[i]].Position);
+		}
+		float radius = glm::length(max - min) * 0.5f;
+		if (radius <= 0.0f)
+			return;
+
+		std::vector<uint32_t> simplified(indexCount);
+		uint32_t previousCount = indexCount;
+		for (const LodTarget &target : s_LodTargets)
+		{
+			float error;
+			uint32_t targetCount = (uint32_t)(indexCount * target.IndexRatio);
+			uint32_t count = MeshSimplifier::Simplify(simplified.data(), indices, indexCount, vertices.data(), (uint32_t)vertices.size(), targetCount, target.MaxError * radius, error);
+			if (!count || count > previousCount * s_MinLodReduction)
+				continue;
+
+			OptimizeVertexCache(simplified.data(), count, (uint32_t)vertices.size());
+			range.Lods.push_back({indexRange, error / radius, std::vector<uint32_t>(simplified.begin(), simplified.begin() + count)});
+			previousCount = count;
+		}
+	}
+
+	static void OptimizeRange(uint32_t *indices, const Vertex *vertices, GeometryRange &range)
+	{
+		AnalyzeRange(indices, range, range.VertexCount, range.MissesBefore, range.VerticesBefore);
+
+		std::vector<uint32_t> remap;
+		std::vector<Vertex> welded;
+		WeldVertices(vertices + range.BaseVertex, range.VertexCount, remap, welded);
+		for (uint32_t k = 0; k < range.IndexRanges.size(); k++)
+		{
+			auto [baseIndex, indexCount] = range.IndexRanges[k];
+			uint32_t *rangeIndices = indices + baseIndex;
+			for (uint32_t i = 0; i < indexCount; i++)
+				rangeIndices[i] = remap[rangeIndices[i]];
+
+			OptimizeVertexCache(rangeIndices, indexCount, (uint32_t)welded.size());
+			OptimizeOverdraw(rangeIndices, indexCount, welded.data(), (uint32_t)welded.size());
+			GenerateLods(rangeIndices, indexCount, k, welded, range);
+		}
+
+		OptimizeVertexFetch(indices, range, welded, range.OptimizedVertices);
+		AnalyzeRange(indices, range, (uint32_t)range.OptimizedVertices.size(), range.MissesAfter, range.VerticesAfter);
+	}
+
+	void MeshOptimizer::Optimize(ImportedMesh &mesh, Statistics &before, Statistics &after)
+	{
+		JN_PROFILE_FUNCTION();
+		MeshContents &contents = mesh.Contents;
+		if (mesh.Indices.empty() || contents.Submeshes.empty())
+			return;
+		uint32_t *indices = &mesh.Indices[0].V1;
+		uint32_t vertexCount = (uint32_t)mesh.Vertices.size();
+
+		// Submeshes index relative to their base vertex, and each base vertex starts a range running up to
+		// the next one. Instanced submeshes share their ranges
+		std::vector<uint32_t> baseVertices;
+		for (const Submesh &submesh : contents.Submeshes)
+			baseVertices.push_back(submesh.BaseVertex);
+		std::sort(baseVertices.begin(), baseVertices.end());
+		baseVertices.erase(std::unique(baseVertices.begin(), baseVertices.end()), baseVertices.end());
+
+		std::vector<GeometryRange> ranges(baseVertices.size());
+		for (uint32_t r = 0; r < ranges.size(); r++)
+		{
+			ranges[r].BaseVertex = baseVertices[r];
+			ranges[r].VertexCount = (r + 1 < ranges.size() ? baseVertices[r + 1] : vertexCount) - baseVertices[r];
+		}
+
+		std::vector<uint32_t> submeshRanges(contents.Submeshes.size());
+		std::vector<uint32_t> submeshIndexRanges(contents.Submeshes.size());
+		for (uint32_t s = 0; s < contents.Submeshes.size(); s++)
+		{
+			const Submesh &submesh = contents.Submeshes[s];
+			uint32_t r = (uint32_t)(std::lower_bound(baseVertices.begin(), baseVertices.end(), submesh.BaseVertex) - baseVertices.begin());
+			submeshRanges[s] = r;
+
+			std::pair<uint32_t, uint32_t> indexRange = {submesh.BaseIndex, submesh.IndexCount};
+			auto &indexRanges = ranges[r].IndexRanges;
+			auto existing = std::find(indexRanges.begin(), indexRanges.end(), indexRange);
+			submeshIndexRanges[s] = (uint32_t)(existing - indexRanges.begin());
+			if (existing != indexRanges.end())
+				continue;
+
+			// Leave geometry the importer got wrong as it is rather than reading out of bounds
+			for (uint32_t i = submesh.BaseIndex; i < submesh.BaseIndex + submesh.IndexCount; i++)
+			{
+				if (indices[i] >= ranges[r].VertexCount)
+				{
+					JN_CORE_WARN("MESH_MSG: Submesh {0} indexes outside its vertices, skipping optimization", s);
+					return;
+				}
+			}
+			indexRanges.push_back(indexRange);
+		}
+
+		ThreadPool::Get().ParallelFor((uint32_t)ranges.size(), [&](uint32_t r)
+									  { OptimizeRange(indices, mesh.Vertices.data(), ranges[r]); });
+
+		// Pack the optimised ranges back to back
+		std::vector<Vertex> vertices;
+		uint32_t missesBefore = 0, verticesBefore = 0, missesAfter = 0, verticesAfter = 0;
+		uint32_t largestRange = 0;
+		for (GeometryRange &range : ranges)
+		{
+			range.BaseVertex = (uint32_t)vertices.size();
+			vertices.insert(vertices.end(), range.OptimizedVertices.begin(), range.OptimizedVertices.end());
+			largestRange = std::max(largestRange, (uint32_t)range.OptimizedVertices.size());
+
+			missesBefore += range.MissesBefore;
+			verticesBefore += range.VerticesBefore;
+			missesAfter += range.MissesAfter;
+			verticesAfter += range.VerticesAfter;
+		}
+		for (uint32_t s = 0; s < contents.Submeshes.size(); s++)
+			contents.Submeshes[s].BaseVertex = ranges[submeshRanges[s]].BaseVertex;
+
+		float triangleCount = (float)mesh.Indices.size();
+		before = {vertexCount, missesBefore / triangleCount, verticesBefore ? (float)missesBefore / verticesBefore : 0.0f};
+		after = {(uint32_t)vertices.size(), missesAfter / triangleCount, verticesAfter ? (float)missesAfter / verticesAfter : 0.0f};
+
+		mesh.Vertices = std::move(vertices);
+		contents.Vertices = mesh.Vertices.data();
+		contents.VertexCount = (uint32_t)mesh.Vertices.size();
+
+		// Levels of detail go after the full detail indices
+		for (GeometryRange &range : ranges)
+		{
+			for (RangeLod &lod : range.Lods)
+			{
+				lod.BaseIndex = (uint32_t)mesh.Indices.size() * 3;
+				for (uint32_t i = 0; i < lod.Indices.size(); i += 3)
+					mesh.Indices.push_back({lod.Indices[i], lod.Indices[i + 1], lod.Indices[i + 2]});
+			}
+		}
+		indices = &mesh.Indices[0].V1;
+		for (uint32_t s = 0; s < contents.Submeshes.size(); s++)
+		{
+			Submesh &submesh = contents.Submeshes[s];
+			submesh.LodCount = 1;
+			for (const RangeLod &lod : ranges[submeshRanges[s]].Lods)
+			{
+				if (lod.IndexRange == submeshIndexRanges[s])
+					submesh.Lods[submesh.LodCount++ - 1] = {lod.BaseIndex, (uint32_t)lod.Indices.size(), lod.Error};
+			}
+		}
+
+		uint32_t indexCount = (uint32_t)mesh.Indices.size() * 3;
+		if (largestRange <= 0x10000)
+		{
+			mesh.ShortIndices.assign(indices, indices + indexCount);
+			contents.Indices = mesh.ShortIndices.data();
+			contents.Format = IndexFormat::UInt16;
+		}
+		else
+		{
+			contents.Indices = indices;
+			contents.Format = IndexFormat::UInt32;
+		}
+		contents.IndexCount = indexCount;
+	}
+
+	// Octahedral mapping of a unit vector to [-1, 1]^2, stored as 16-bit signed normalized
+	static void EncodeOctahedral(glm::vec3 v, int16_t *encoded)
+	{
+		v /= std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+		glm::vec2 e(v.x, v.y);
+		if (v.z < 0.0f)
+		{
+			e = glm::vec2(1.0f - std::abs(v.y), 1.0f - std::abs(v.x));
+			e.x = v.x >= 0.0f ? e.x : -e.x;
+			e.y = v.y >= 0.0f ? e.y : -e.y;
+		}
+		encoded[0] = (int16_t)std::round(glm::clamp(e.x, -1.0f, 1.0f) * 32767.0f);
+		encoded[1] = (int16_t)std::round(glm::clamp(e.y, -1.0f, 1.0f) * 32767.0f);
+	}
+
+	static CompactVertex CompressVertex(const Vertex &vertex, const glm::vec4 &positionDecode)
+	{
+		CompactVertex compact;
+		glm::vec3 position = glm::clamp((vertex.Position - glm::vec3(positionDecode)) / positionDecode.w, 0.0f, 1.0f);
+		for (int i = 0; i < 3; i++)
+			compact.Position[i] = (uint16_t)std::round(position[i] * 65535.0f);
+
+		// Degenerate frames get an arbitrary one rather than NaNs
+		glm::vec3 normal = glm::length(vertex.Normal) > 0.0f ? glm::normalize(vertex.Normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+		glm::vec3 tangent = vertex.Tangent - normal * glm::dot(normal, vertex.Tangent);
+		if (glm::length(tangent) < 1e-6f)
+			tangent = std::abs(normal.x) < 0.9f ? glm::cross(normal, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(normal, glm::vec3(0.0f, 1.0f, 0.0f));
+		tangent = glm::normalize(tangent);
+		compact.Position[3] = glm::dot(glm::cross(normal, tangent), vertex.Binormal) < 0.0f ? 0xffff : 0;
+		EncodeOctahedral(normal, compact.Normal);
+		EncodeOctahedral(tangent, compact.Tangent);
+
+		compact.Texcoord[0] = glm::packHalf1x16(vertex.Texcoord.x);
+		compact.Texcoord[1] = glm::packHalf1x16(vertex.Texcoord.y);
+		return compact;
+	}
+
+	void MeshOptimizer::Compress(ImportedMesh &mesh)
+	{
+		JN_PROFILE_FUNCTION();
+		MeshContents &contents = mesh.Contents;
+		uint32_t vertexCount = (uint32_t)mesh.Vertices.size();
+
+		std::vector<uint32_t> baseVertices = {0};
+		for (const Submesh &submesh : contents.Submeshes)
+			baseVertices.push_back(submesh.BaseVertex);
+		std::sort(baseVertices.begin(), baseVertices.end());
+		baseVertices.erase(std::unique(baseVertices.begin(), baseVertices.end()), baseVertices.end());
+
+		// Positions are quantized against the bounds of each vertex range, with one scale for all axes so
+		// the decode folds into the instance transform without skewing normals
+		std::vector<glm::vec4> decodes(baseVertices.size(), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		mesh.CompactVertices.resize(vertexCount);
+		ThreadPool::Get().ParallelFor((uint32_t)baseVertices.size(), [&](uint32_t r)
+									  {
+										  uint32_t first = std::min(baseVertices[r], vertexCount);
+										  uint32_t last = r + 1 < baseVertices.size() ? std::min(baseVertices[r + 1], vertexCount) : vertexCount;
+										  if (first == last)
+											  return;
+
+										  glm::vec3 min = mesh.Vertices[first].Position, max = min;
+										  for (uint32_t v = first; v < last; v++)
+										  {
+											  min = glm::min(min, mesh.Vertices[v].Position);
+											  max = glm::max(max, mesh.Vertices[v].Position);
+										  }
+										  glm::vec3 extent = max - min;
+										  float scale = std::max(std::max(extent.x, extent.y), extent.z);
+										  decodes[r] = glm::vec4(min, scale > 0.0f ? scale : 1.0f);
+
+										  for (uint32_t v = first; v < last; v++)
+											  mesh.CompactVertices[v] = CompressVertex(mesh.Vertices[v], decodes[r]);
+									  });
+
+		for (Submesh &submesh : contents.Submeshes)
+		{
+			uint32_t r = (uint32_t)(std::lower_bound(baseVertices.begin(), baseVertices.end(), submesh.BaseVertex) - baseVertices.begin());
+			submesh.PositionDecode = decodes[r];
+		}
+
+		contents.Vertices = mesh.CompactVertices.data();
+		contents.VertexCount = vertexCount;
+		contents.VertexFormat = MeshVertexFormat::Compact;
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Janus
+{
+	struct ImportedMesh;
+
+	// Import-time geometry optimisation, run before a mesh is cooked. Identical vertices are welded,
+	// triangles are ordered for the post-transform vertex cache and then by cluster to reduce overdraw,
+	// simplified levels of detail are generated, vertices are renumbered in the order they are first drawn,
+	// and indices are narrowed to 16 bits when every submesh addresses fewer than 65536 vertices
+	class MeshOptimizer
+	{
+	public:
+		// Vertex cache efficiency, measured with a FIFO cache like the ones in current hardware
+		struct Statistics
+		{
+			uint32_t VertexCount = 0;
+			// Average cache miss ratio: vertex shader invocations per triangle, 3 at worst and about 0.5 at best
+			float ACMR = 0.0f;
+			// Average transformed vertex ratio: vertex shader invocations per vertex, 1 at best
+			float ATVR = 0.0f;
+		};
+
+		// Rewrites the vertices, indices and contents of mesh in place; submeshes keep drawing the same
+		// triangles at level 0 and gain the levels of detail, whose indices follow the others. Statistics are
+		// measured on the full detail geometry as imported and as optimised
+		static void Optimize(ImportedMesh &mesh, Statistics &before, Statistics &after);
+
+		// Packs the vertices into CompactVertices and points the contents at them. Positions are quantized
+		// against the bounds of each vertex range, which the submeshes' PositionDecode maps back
+		static void Compress(ImportedMesh &mesh);
+	};
+}
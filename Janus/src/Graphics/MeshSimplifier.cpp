@@ -0,0 +1,401 @@
+#include "jnpch.h"
+#include "Graphics/MeshSimplifier.h"
+
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "Graphics/Mesh.h"
+
+namespace Janus
+{
+	static constexpr uint32_t s_InvalidIndex = 0xffffffff;
+	// Weight of the planes holding open borders in place, per squared border edge length
+	static constexpr float s_BorderWeight = 10.0f;
+	// A collapse is rejected if it turns any remaining triangle by more than this, as a cosine
+	static constexpr float s_MinNormalCosine = 0.25f;
+	// Each pass takes collapses up to this factor of the error of the one that would meet the target alone
+	static constexpr float s_PassErrorScale = 1.5f;
+	static constexpr uint32_t s_MaxPasses = 100;
+
+	enum class VertexKind : uint8_t
+	{
+		// Interior vertex, collapses onto any neighbour
+		Manifold = 0,
+		// On an open border, collapses only onto its neighbours along the border
+		Border,
+		// On a texture seam, a non-manifold edge or where borders meet; never collapsed
+		Locked
+	};
+
+	// Weighted sum of squared distances to a set of planes, as the upper half of a symmetric 4x4 matrix
+	struct Quadric
+	{
+		float A00 = 0.0f, A11 = 0.0f, A22 = 0.0f, A01 = 0.0f, A02 = 0.0f, A12 = 0.0f;
+		float B0 = 0.0f, B1 = 0.0f, B2 = 0.0f;
+		float C = 0.0f;
+		float Weight = 0.0f;
+
+		void AddPlane(const glm::vec3 &normal, float distance, float weight)
+		{
+			A00 += weight * normal.x * normal.x;
+			A11 += weight * normal.y * normal.y;
+			A22 += weight * normal.z * normal.z;
+			A01 += weight * normal.x * normal.y;
+			A02 += weight * normal.x * normal.z;
+			A12 += weight * normal.y * normal.z;
+			B0 += weight * normal.x * distance;
+			B1 += weight * normal.y * distance;
+			B2 += weight * normal.z * distance;
+			C += weight * distance * distance;
+			Weight += weight;
+		}
+
+		void Add(const Quadric &other)
+		{
+			A00 += other.A00;
+			A11 += other.A11;
+			A22 += other.A22;
+			A01 += other.A01;
+			A02 += other.A02;
+			A12 += other.A12;
+			B0 += other.B0;
+			B1 += other.B1;
+			B2 += other.B2;
+			C += other.C;
+			Weight += other.Weight;
+		}
+
+		// Mean squared distance of p from the planes
+		float GetError(const glm::vec3 &p) const
+		{
+			float rx = A00 * p.x + A01 * p.y + A02 * p.z;
+			float ry = A01 * p.x + A11 * p.y + A12 * p.z;
+			float rz = A02 * p.x + A12 * p.y + A22 * p.z;
+			float error = p.x * rx + p.y * ry + p.z * rz + 2.0f * (B0 * p.x + B1 * p.y + B2 * p.z) + C;
+			return Weight > 0.0f ? std::abs(error) / Weight : 0.0f;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t From;
+		uint32_t To;
+		float Error;
+	};
+
+	// Maps every vertex to the first one at the same position, so texture seams can be told apart from borders
+	static void BuildPositionRemap(const std::vector<glm::vec3> &positions, std::vector<uint32_t> &remap)
+	{
+		uint32_t vertexCount = (uint32_t)positions.size();
+		uint32_t tableSize = 1;
+		while (tableSize < vertexCount * 2)
+			tableSize *= 2;
+		std::vector<uint32_t> table(tableSize, s_InvalidIndex);
+
+		remap.resize(vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			uint32_t words[3];
+			memcpy(words, &positions[i], sizeof(words));
+			uint32_t hash = (words[0] * 73856093u) ^ (words[1] * 19349663u) ^ (words[2] * 83492791u);
+			uint32_t slot = hash & (tableSize - 1);
+			while (table[slot] != s_InvalidIndex && positions[table[slot]] != positions[i])
+				slot = (slot + 1) & (tableSize - 1);
+
+			if (table[slot] == s_InvalidIndex)
+				table[slot] = i;
+			remap[i] = table[slot];
+		}
+	}
+
+	// Classifies every vertex from the directed edges between positions. An edge without a reverse is on an
+	// open border; loop and loopBack link each border position to the next and previous one along it
+	static void ClassifyVertices(const std::vector<uint32_t> &indices, const std::vector<uint32_t> &positionRemap, std::vector<VertexKind> &kinds,
+								 std::vector<uint32_t> &loop, std::vector<uint32_t> &loopBack)
+	{
+		uint32_t vertexCount = (uint32_t)positionRemap.size();
+		std::unordered_map<uint64_t, uint32_t> edges;
+		edges.reserve(indices.size());
+		auto edgeKey = [](uint32_t a, uint32_t b)
+		{ return (uint64_t)a << 32 | b; };
+		for (uint32_t i = 0; i < indices.size(); i += 3)
+		{
+			for (uint32_t k = 0; k < 3; k++)
+				edges[edgeKey(positionRemap[indices[i + k]], positionRemap[indices[i + (k + 1) % 3]])]++;
+		}
+
+		std::vector<uint32_t> wedgeCount(vertexCount, 0);
+		for (uint32_t v = 0; v < vertexCount; v++)
+			wedgeCount[positionRemap[v]]++;
+
+		std::vector<uint8_t> locked(vertexCount, 0);
+		loop.assign(vertexCount, s_InvalidIndex);
+		loopBack.assign(vertexCount, s_InvalidIndex);
+		for (auto [key, count] : edges)
+		{
+			uint32_t a = (uint32_t)(key >> 32), b = (uint32_t)key;
+			auto reverse = edges.find(edgeKey(b, a));
+			if (count > 1 || (reverse != edges.end() && reverse->second > 1))
+			{
+				locked[a] = locked[b] = 1;
+				continue;
+			}
+			if (reverse != edges.end())
+				continue;
+
+			// A position with two borders leaving it joins separate pieces of surface
+			if (loop[a] != s_InvalidIndex || loopBack[b] != s_InvalidIndex)
+				locked[a] = locked[b] = 1;
+			loop[a] = b;
+			loopBack[b] = a;
+		}
+
+		kinds.resize(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			uint32_t p = positionRemap[v];
+			if (locked[p] || wedgeCount[p] > 1)
+				kinds[v] = VertexKind::Locked;
+			else if (loop[p] != s_InvalidIndex || loopBack[p] != s_InvalidIndex)
+				kinds[v] = VertexKind::Border;
+			else
+				kinds[v] = VertexKind::Manifold;
+		}
+	}
+
+	static void BuildQuadrics(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &positionRemap,
+							  const std::vector<uint32_t> &loop, std::vector<Quadric> &quadrics)
+	{
+		quadrics.assign(positions.size(), Quadric());
+		for (uint32_t i = 0; i < indices.size(); i += 3)
+		{
+			const glm::vec3 &p0 = positions[indices[i]];
+			const glm::vec3 &p1 = positions[indices[i + 1]];
+			const glm::vec3 &p2 = positions[indices[i + 2]];
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(normal);
+			if (area <= 0.0f)
+				continue;
+			normal /= area;
+
+			Quadric plane;
+			plane.AddPlane(normal, -glm::dot(normal, p0), area * 0.5f);
+			for (uint32_t k = 0; k < 3; k++)
+				quadrics[indices[i + k]].Add(plane);
+
+			// Border edges add a plane through the edge, perpendicular to the triangle, so the border keeps its shape
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				uint32_t i0 = indices[i + k], i1 = indices[i + (k + 1) % 3];
+				if (loop[positionRemap[i0]] != positionRemap[i1])
+					continue;
+
+				glm::vec3 edge = positions[i1] - positions[i0];
+				float length = glm::length(edge);
+				if (length <= 0.0f)
+					continue;
+				glm::vec3 edgeNormal = glm::normalize(glm::cross(edge, normal));
+				Quadric border;
+				border.AddPlane(edgeNormal, -glm::dot(edgeNormal, positions[i0]), length * length * s_BorderWeight);
+				quadrics[i0].Add(border);
+				quadrics[i1].Add(border);
+			}
+		}
+	}
+
+	// Whether moving from onto to keeps every other triangle around from facing roughly the same way
+	static bool PreservesNormals(uint32_t from, uint32_t to, const std::vector<uint32_t> &indices, const std::vector<uint32_t> &adjacency,
+								 const std::vector<uint32_t> &adjacencyOffsets, const std::vector<glm::vec3> &positions)
+	{
+		for (uint32_t j = adjacencyOffsets[from]; j < adjacencyOffsets[from + 1]; j++)
+		{
+			const uint32_t *triangle = &indices[adjacency[j] * 3];
+			if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				continue;
+
+			glm::vec3 p[3], moved[3];
+			for (uint32_t k = 0; k < 3; k++)
+			{
+				p[k] = positions[triangle[k]];
+				moved[k] = triangle[k] == from ? positions[to] : p[k];
+			}
+			glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+			glm::vec3 movedNormal = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			if (glm::dot(normal, movedNormal) < s_MinNormalCosine * glm::length(normal) * glm::length(movedNormal))
+				return false;
+		}
+		return true;
+	}
+
+	uint32_t MeshSimplifier::Simplify(uint32_t *destination, const uint32_t *indices, uint32_t indexCount, const Vertex *vertices, uint32_t vertexCount,
+									  uint32_t targetIndexCount, float targetError, float &error)
+	{
+		JN_PROFILE_FUNCTION();
+		error = 0.0f;
+		std::vector<uint32_t> result(indices, indices + indexCount);
+
+		// Work in the unit cube, so the quadrics stay in a comfortable range for floats
+		glm::vec3 min(std::numeric_limits<float>::max()), max(-std::numeric_limits<float>::max());
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			min = glm::min(min, vertices[indices[i]].Position);
+			max = glm::max(max, vertices[indices[i]].Position);
+		}
+		glm::vec3 extent = max - min;
+		float scale = std::max(std::max(extent.x, extent.y), extent.z);
+		if (indexCount <= targetIndexCount || scale <= 0.0f)
+		{
+			memcpy(destination, indices, indexCount * sizeof(uint32_t));
+			return indexCount;
+		}
+
+		std::vector<glm::vec3> positions(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+			positions[v] = (vertices[v].Position - min) / scale;
+
+		std::vector<uint32_t> positionRemap, loop, loopBack;
+		std::vector<VertexKind> kinds;
+		std::vector<Quadric> quadrics;
+		BuildPositionRemap(positions, positionRemap);
+		ClassifyVertices(result, positionRemap, kinds, loop, loopBack);
+		BuildQuadrics(result, positions, positionRemap, loop, quadrics);
+
+		float errorLimit = (targetError / scale) * (targetError / scale);
+		float largestError = 0.0f;
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> collapseTargets(vertexCount);
+		std::vector<uint8_t> collapseLocked(vertexCount);
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1), adjacency;
+		for (uint32_t pass = 0; pass < s_MaxPasses && result.size() > targetIndexCount; pass++)
+		{
+			uint32_t triangleCount = (uint32_t)result.size() / 3;
+
+			// Triangles around every vertex, for the normal checks
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (uint32_t index : result)
+				adjacencyOffsets[index + 1]++;
+			for (uint32_t v = 0; v < vertexCount; v++)
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			adjacency.resize(result.size());
+			{
+				std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+				for (uint32_t i = 0; i < result.size(); i++)
+					adjacency[fill[result[i]]++] = i / 3;
+			}
+
+			// Every edge, seen from one of its triangles, collapsed in whichever allowed direction costs less
+			auto canCollapse = [&](uint32_t from, uint32_t to)
+			{
+				if (kinds[from] == VertexKind::Manifold)
+					return true;
+				uint32_t p0 = positionRemap[from], p1 = positionRemap[to];
+				return kinds[from] == VertexKind::Border && (loop[p0] == p1 || loopBack[p0] == p1);
+			};
+			collapses.clear();
+			for (uint32_t i = 0; i < result.size(); i += 3)
+			{
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					uint32_t i0 = result[i + k], i1 = result[i + (k + 1) % 3];
+					uint32_t p0 = positionRemap[i0], p1 = positionRemap[i1];
+					bool border = loop[p0] == p1;
+					if (p0 > p1 && !border)
+						continue;
+
+					Collapse collapse = {s_InvalidIndex, s_InvalidIndex, std::numeric_limits<float>::max()};
+					if (canCollapse(i0, i1))
+						collapse = {i0, i1, quadrics[i0].GetError(positions[i1])};
+					if (canCollapse(i1, i0))
+					{
+						float reverseError = quadrics[i1].GetError(positions[i0]);
+						if (reverseError < collapse.Error)
+							collapse = {i1, i0, reverseError};
+					}
+					if (collapse.From != s_InvalidIndex && collapse.Error <= errorLimit)
+						collapses.push_back(collapse);
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b)
+					  { return a.Error < b.Error; });
+
+			if (collapses.empty())
+				break;
+
+			// Take the cheapest collapses that do not share vertices until enough triangles are gone. An
+			// interior collapse removes two triangles and a border collapse one. Collapses that would be next to
+			// an earlier one are left for the next pass, so each pass stops a little past the error of the
+			// collapse that would reach the target on its own
+			for (uint32_t v = 0; v < vertexCount; v++)
+				collapseTargets[v] = v;
+			std::fill(collapseLocked.begin(), collapseLocked.end(), 0);
+			uint32_t trianglesToRemove = triangleCount - targetIndexCount / 3;
+			uint32_t collapseGoal = std::min((trianglesToRemove + 1) / 2, (uint32_t)collapses.size());
+			float passErrorLimit = std::max(collapses[collapseGoal - 1].Error * s_PassErrorScale, collapses[0].Error);
+			uint32_t trianglesRemoved = 0;
+			uint32_t collapseCount = 0;
+			for (const Collapse &collapse : collapses)
+			{
+				if (trianglesRemoved >= trianglesToRemove || (collapse.Error > passErrorLimit && collapseCount))
+					break;
+				if (collapseLocked[collapse.From] || collapseLocked[collapse.To])
+					continue;
+				if (!PreservesNormals(collapse.From, collapse.To, result, adjacency, adjacencyOffsets, positions))
+					continue;
+
+				// The normal checks assume every other vertex of these triangles stays where it is
+				collapseTargets[collapse.From] = collapse.To;
+				for (uint32_t j = adjacencyOffsets[collapse.From]; j < adjacencyOffsets[collapse.From + 1]; j++)
+				{
+					const uint32_t *triangle = &result[adjacency[j] * 3];
+					collapseLocked[triangle[0]] = collapseLocked[triangle[1]] = collapseLocked[triangle[2]] = 1;
+				}
+				quadrics[collapse.To].Add(quadrics[collapse.From]);
+				largestError = std::max(largestError, collapse.Error);
+				collapseCount++;
+
+				if (kinds[collapse.From] == VertexKind::Border)
+				{
+					// Unlink the collapsed position from its border
+					uint32_t p0 = positionRemap[collapse.From], p1 = positionRemap[collapse.To];
+					if (loop[p0] == p1)
+					{
+						if (loopBack[p0] != s_InvalidIndex)
+							loop[loopBack[p0]] = p1;
+						loopBack[p1] = loopBack[p0];
+					}
+					else
+					{
+						if (loop[p0] != s_InvalidIndex)
+							loopBack[loop[p0]] = p1;
+						loop[p1] = loop[p0];
+					}
+					trianglesRemoved += 1;
+				}
+				else
+				{
+					trianglesRemoved += 2;
+				}
+			}
+			if (!collapseCount)
+				break;
+
+			// Move the collapsed vertices and drop the triangles that lost their area
+			uint32_t kept = 0;
+			for (uint32_t i = 0; i < result.size(); i += 3)
+			{
+				uint32_t i0 = collapseTargets[result[i]], i1 = collapseTargets[result[i + 1]], i2 = collapseTargets[result[i + 2]];
+				uint32_t p0 = positionRemap[i0], p1 = positionRemap[i1], p2 = positionRemap[i2];
+				if (p0 == p1 || p1 == p2 || p2 == p0)
+					continue;
+				result[kept++] = i0;
+				result[kept++] = i1;
+				result[kept++] = i2;
+			}
+			result.resize(kept);
+		}
+
+		error = std::sqrt(largestError) * scale;
+		memcpy(destination, result.data(), result.size() * sizeof(uint32_t));
+		return (uint32_t)result.size();
+	}
+}
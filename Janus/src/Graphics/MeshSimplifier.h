@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Janus
+{
+	struct Vertex;
+
+	// Quadric error simplification for generating levels of detail at import time, after Garland and Heckbert,
+	// "Surface Simplification Using Quadric Error Metrics". Edges are collapsed onto one of their vertices, so
+	// the result indexes the original vertices and a level of detail only needs indices of its own. Open
+	// borders only collapse along themselves, and vertices on texture seams or non-manifold edges are kept
+	class MeshSimplifier
+	{
+	public:
+		// Simplifies the triangles in indices, which address vertexCount vertices, until no more than
+		// targetIndexCount indices are left or the next collapse would move the surface further than
+		// targetError. Writes the triangles left to destination, which has room for indexCount indices, and
+		// returns their index count. error receives the largest distance the surface moved. Distances are in
+		// the units of the vertex positions
+		static uint32_t Simplify(uint32_t *destination, const uint32_t *indices, uint32_t indexCount, const Vertex *vertices, uint32_t vertexCount,
+								 uint32_t targetIndexCount, float targetError, float &error);
+	};
+}
@@ -2,6 +2,7 @@
 #include <glad/glad.h>
 #include "OpenGLFramebuffer.h"
 #include "Graphics/Renderer.h"
+#include "Graphics/RenderStateCache.h"
 
 namespace Janus
 {
@@ -21,6 +22,8 @@ namespace Janus
 		static void BindTexture(bool multisampled, uint32_t id)
 		{
 			glBindTexture(TextureTarget(multisampled), id);
+			// Binds through the active texture unit
+			RenderStateCache::InvalidateTextureUnit(0);
 		}
 
 		static GLenum DataType(GLenum format)
@@ -133,6 +136,8 @@ namespace Janus
 								 glDeleteFramebuffers(1, &instance->m_RendererID);
 								 glDeleteTextures(instance->m_ColorAttachments.size(), instance->m_ColorAttachments.data());
 								 glDeleteTextures(1, &instance->m_DepthAttachment);
+								 RenderStateCache::OnTexturesDeleted(instance->m_ColorAttachments.size(), instance->m_ColorAttachments.data());
+								 RenderStateCache::OnTexturesDeleted(1, &instance->m_DepthAttachment);
 
 								 instance->m_ColorAttachments.clear();
 								 instance->m_DepthAttachment = 0;
@@ -223,6 +228,6 @@ namespace Janus
 	{
 		Ref<const OpenGLFramebuffer> instance = this;
 		Renderer::Submit([instance, attachmentIndex, slot]()
-						 { glBindTextureUnit(slot, instance->m_ColorAttachments[attachmentIndex]); });
+						 { RenderStateCache::BindTextureUnit(slot, instance->m_ColorAttachments[attachmentIndex]); });
 	}
 }
\ No newline at end of file
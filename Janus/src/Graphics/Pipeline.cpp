@@ -2,6 +2,7 @@
 #include "Pipeline.h"
 
 #include "Graphics/Renderer.h"
+#include "Graphics/RenderStateCache.h"
 
 #include <glad/glad.h>
 
@@ -22,12 +23,48 @@ namespace Janus {
 			case ShaderDataType::Int3:     return GL_INT;
 			case ShaderDataType::Int4:     return GL_INT;
 			case ShaderDataType::Bool:     return GL_BOOL;
+			case ShaderDataType::UShort4:  return GL_UNSIGNED_SHORT;
+			case ShaderDataType::Short2:   return GL_SHORT;
+			case ShaderDataType::Half2:    return GL_HALF_FLOAT;
 		}
 
 		JN_ASSERT(false, "PIPELINE_ERROR: Unknown ShaderDataType!");
 		return 0;
 	}
 
+	static constexpr GLuint s_VertexBinding = 0;
+	static constexpr GLuint s_InstanceBinding = 1;
+
+	// Records the attribute formats of a layout on one binding point, starting at attribIndex
+	static void RecordLayout(GLuint vertexArrayRendererID, const BufferLayout& layout, GLuint binding, uint32_t& attribIndex)
+	{
+		for (const auto& element : layout)
+		{
+			auto glBaseType = ShaderDataTypeToOpenGLBaseType(element.Type);
+
+			// Matrices occupy one attribute location per column
+			uint32_t locationCount = 1;
+			if (element.Type == ShaderDataType::Mat3)
+				locationCount = 3;
+			else if (element.Type == ShaderDataType::Mat4)
+				locationCount = 4;
+			uint32_t componentCount = element.GetComponentCount() / locationCount;
+			uint32_t columnSize = element.Size / locationCount;
+
+			for (uint32_t i = 0; i < locationCount; i++)
+			{
+				uint32_t offset = element.Offset + i * columnSize;
+				glEnableVertexArrayAttrib(vertexArrayRendererID, attribIndex);
+				if (glBaseType == GL_INT)
+					glVertexArrayAttribIFormat(vertexArrayRendererID, attribIndex, componentCount, glBaseType, offset);
+				else
+					glVertexArrayAttribFormat(vertexArrayRendererID, attribIndex, componentCount, glBaseType, element.Normalized ? GL_TRUE : GL_FALSE, offset);
+				glVertexArrayAttribBinding(vertexArrayRendererID, attribIndex, binding);
+				attribIndex++;
+			}
+		}
+	}
+
 	Pipeline::Pipeline(const PipelineSpecification& spec)
 		: m_Specification(spec)
 	{
@@ -40,6 +77,7 @@ namespace Janus {
 		Renderer::Submit([rendererID]()
 		{
 			glDeleteVertexArrays(1, &rendererID);
+			RenderStateCache::OnVertexArrayDeleted(rendererID);
 		});
 	}
 
@@ -53,46 +91,50 @@ namespace Janus {
 			auto& vertexArrayRendererID = instance->m_VertexArrayRendererID;
 
 			if (vertexArrayRendererID)
+			{
 				glDeleteVertexArrays(1, &vertexArrayRendererID);
+				RenderStateCache::OnVertexArrayDeleted(vertexArrayRendererID);
+			}
+
+			glCreateVertexArrays(1, &vertexArrayRendererID);
 
-			glGenVertexArrays(1, &vertexArrayRendererID);
-			glBindVertexArray(vertexArrayRendererID);
-			glBindVertexArray(0);
+			// The format is stored in the vertex array once; binding only has to attach a buffer
+			uint32_t attribIndex = 0;
+			RecordLayout(vertexArrayRendererID, instance->m_Specification.Layout, s_VertexBinding, attribIndex);
+			if (instance->m_Specification.InstanceLayout.GetElements().size())
+			{
+				attribIndex = std::max(attribIndex, instance->m_Specification.InstanceLocation);
+				RecordLayout(vertexArrayRendererID, instance->m_Specification.InstanceLayout, s_InstanceBinding, attribIndex);
+				glVertexArrayBindingDivisor(vertexArrayRendererID, s_InstanceBinding, 1);
+			}
 		});
 	}
 
-	void Pipeline::Bind()
+	void Pipeline::Bind(const Ref<VertexBuffer>& vertexBuffer)
 	{
 		Ref<Pipeline> instance = this;
-		Renderer::Submit([instance]()
+		Ref<VertexBuffer> buffer = vertexBuffer;
+		Renderer::Submit([instance, buffer]()
 		{
-			glBindVertexArray(instance->m_VertexArrayRendererID);
+			uint32_t vertexArrayRendererID = instance->m_VertexArrayRendererID;
+			RenderStateCache::BindVertexArray(vertexArrayRendererID);
+			glVertexArrayVertexBuffer(vertexArrayRendererID, s_VertexBinding, buffer->GetRendererID(), 0, instance->m_Specification.Layout.GetStride());
+		});
+	}
 
-			const auto& layout = instance->m_Specification.Layout;
-			uint32_t attribIndex = 0;
-			for (const auto& element : layout)
-			{
-				auto glBaseType = ShaderDataTypeToOpenGLBaseType(element.Type);
-				glEnableVertexAttribArray(attribIndex);
-				if (glBaseType == GL_INT)
-				{
-					glVertexAttribIPointer(attribIndex,
-						element.GetComponentCount(),
-						glBaseType,
-						layout.GetStride(),
-						(const void*)(intptr_t)element.Offset);
-				}
-				else
-				{
-					glVertexAttribPointer(attribIndex,
-						element.GetComponentCount(),
-						glBaseType,
-						element.Normalized ? GL_TRUE : GL_FALSE,
-						layout.GetStride(),
-						(const void*)(intptr_t)element.Offset);
-				}
-				attribIndex++;
-			}
+	void Pipeline::Bind(const Ref<VertexBuffer>& vertexBuffer, const Ref<VertexBuffer>& instanceBuffer)
+	{
+		JN_ASSERT(m_Specification.InstanceLayout.GetElements().size(), "PIPELINE_ERROR: Pipeline has no instance layout!");
+
+		Ref<Pipeline> instance = this;
+		Ref<VertexBuffer> buffer = vertexBuffer;
+		Ref<VertexBuffer> perInstanceBuffer = instanceBuffer;
+		Renderer::Submit([instance, buffer, perInstanceBuffer]()
+		{
+			uint32_t vertexArrayRendererID = instance->m_VertexArrayRendererID;
+			RenderStateCache::BindVertexArray(vertexArrayRendererID);
+			glVertexArrayVertexBuffer(vertexArrayRendererID, s_VertexBinding, buffer->GetRendererID(), 0, instance->m_Specification.Layout.GetStride());
+			glVertexArrayVertexBuffer(vertexArrayRendererID, s_InstanceBinding, perInstanceBuffer->GetRendererID(), 0, instance->m_Specification.InstanceLayout.GetStride());
 		});
 	}
 
@@ -9,6 +9,11 @@ namespace Janus {
 	{
 		Ref<Shader> Shader;
 		BufferLayout Layout;
+		// Optional per-instance attributes, read from a second buffer that advances once per instance.
+		// Their locations follow the vertex attributes, starting no lower than InstanceLocation so shaders
+		// can fix them while the vertex layout varies
+		BufferLayout InstanceLayout;
+		uint32_t InstanceLocation = 0;
 	};
 
 	class Pipeline : public RefCounted
@@ -20,9 +25,13 @@ namespace Janus {
 		PipelineSpecification& GetSpecification() { return m_Specification; }
 		const PipelineSpecification& GetSpecification() const { return m_Specification; }
 
+		// Creates the vertex array and records the vertex format described by the layout
 		void Invalidate();
 
-		void Bind();
+		// Binds the vertex array and attaches the vertex buffer to its single binding point
+		void Bind(const Ref<VertexBuffer>& vertexBuffer);
+		// Also attaches the instance buffer to the instance binding point
+		void Bind(const Ref<VertexBuffer>& vertexBuffer, const Ref<VertexBuffer>& instanceBuffer);
 	private:
 		PipelineSpecification m_Specification;
 		uint32_t m_VertexArrayRendererID = 0;
@@ -1,58 +1,102 @@
 #include "jnpch.h"
 #include "Graphics/RenderCommandQueue.h"
 
-#define JN_RENDER_TRACE(...) HZ_CORE_TRACE(__VA_ARGS__)
+#define JN_RENDER_TRACE(...) JN_CORE_TRACE(__VA_ARGS__)
 
 namespace Janus
 {
 
-	RenderCommandQueue::RenderCommandQueue()
+	// Pages are allocated with this alignment so payload alignment can be computed on offsets alone
+	static constexpr uint32_t s_PageAlignment = 64;
+
+	static uint32_t AlignUp(uint32_t value, uint32_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	RenderCommandQueue::RenderCommandQueue(uint32_t pageSize)
+		: m_PageSize(pageSize)
 	{
-		m_CommandBuffer = new uint8_t[10 * 1024 * 1024]; // 10mb buffer
-		m_CommandBufferPtr = m_CommandBuffer;
-		memset(m_CommandBuffer, 0, 10 * 1024 * 1024);
+		AllocatePage(0, m_PageSize);
 	}
 
 	RenderCommandQueue::~RenderCommandQueue()
 	{
-		delete[] m_CommandBuffer;
+		for (auto &page : m_Pages)
+			::operator delete[](page.Data, std::align_val_t(s_PageAlignment));
 	}
 
-	void *RenderCommandQueue::Allocate(RenderCommandFn fn, uint32_t size)
+	RenderCommandQueue::Page &RenderCommandQueue::AllocatePage(uint32_t index, uint32_t minCapacity)
 	{
-		// TODO: alignment
-		*(RenderCommandFn *)m_CommandBufferPtr = fn;
-		m_CommandBufferPtr += sizeof(RenderCommandFn);
+		Page &page = *m_Pages.emplace(m_Pages.begin() + index);
+		page.Capacity = std::max(m_PageSize, minCapacity);
+		// No clearing: every byte is written by Allocate before Execute reads it
+		page.Data = (uint8_t *)::operator new[](page.Capacity, std::align_val_t(s_PageAlignment));
+		return page;
+	}
 
-		*(uint32_t *)m_CommandBufferPtr = size;
-		m_CommandBufferPtr += sizeof(uint32_t);
+	void *RenderCommandQueue::Allocate(RenderCommandFn fn, uint32_t size, uint32_t alignment)
+	{
+		JN_ASSERT(alignment && (alignment & (alignment - 1)) == 0, "RENDER_COMMAND_QUEUE_ERROR: Alignment must be a power of two!");
+		JN_ASSERT(alignment <= s_PageAlignment, "RENDER_COMMAND_QUEUE_ERROR: Command alignment exceeds page alignment!");
+		alignment = std::max<uint32_t>(alignment, alignof(CommandHeader));
 
-		void *memory = m_CommandBufferPtr;
-		m_CommandBufferPtr += size;
+		Page *page = &m_Pages[m_CurrentPage];
+		uint32_t headerOffset = AlignUp(page->Used, alignof(CommandHeader));
+		uint32_t payloadOffset = AlignUp(headerOffset + sizeof(CommandHeader), alignment);
+		if (payloadOffset + size > page->Capacity)
+		{
+			// Move on to the next page, reusing one from a previous frame when it is large enough. A page that
+			// is too small stays behind the new one for the smaller commands of later frames
+			uint32_t requiredCapacity = AlignUp(sizeof(CommandHeader), alignment) + size;
+			m_CurrentPage++;
+			if (m_CurrentPage >= m_Pages.size() || m_Pages[m_CurrentPage].Capacity < requiredCapacity)
+			{
+				JN_RENDER_TRACE("RenderCommandQueue: growing to {0} pages", m_Pages.size() + 1);
+				AllocatePage(m_CurrentPage, requiredCapacity);
+			}
 
+			page = &m_Pages[m_CurrentPage];
+			page->Used = 0;
+			headerOffset = 0;
+			payloadOffset = AlignUp(sizeof(CommandHeader), alignment);
+		}
+
+		CommandHeader *header = (CommandHeader *)(page->Data + headerOffset);
+		header->Function = fn;
+		header->PayloadOffset = payloadOffset - headerOffset;
+		header->Stride = AlignUp(payloadOffset + size, alignof(CommandHeader)) - headerOffset;
+
+		m_FrameSize += (payloadOffset + size) - page->Used;
+		page->Used = payloadOffset + size;
 		m_CommandCount++;
-		return memory;
+		return page->Data + payloadOffset;
 	}
 
 	void RenderCommandQueue::Execute()
 	{
-		//HZ_RENDER_TRACE("RenderCommandQueue::Execute -- {0} commands, {1} bytes", m_CommandCount, (m_CommandBufferPtr - m_CommandBuffer));
-
-		byte *buffer = m_CommandBuffer;
-
-		for (uint32_t i = 0; i < m_CommandCount; i++)
+		for (uint32_t p = 0; p <= m_CurrentPage; p++)
 		{
-			RenderCommandFn function = *(RenderCommandFn *)buffer;
-			buffer += sizeof(RenderCommandFn);
-
-			uint32_t size = *(uint32_t *)buffer;
-			buffer += sizeof(uint32_t);
-			function(buffer);
-			buffer += size;
+			Page &page = m_Pages[p];
+			uint32_t offset = 0;
+			while (offset < page.Used)
+			{
+				CommandHeader *header = (CommandHeader *)(page.Data + offset);
+				header->Function(page.Data + offset + header->PayloadOffset);
+				offset += header->Stride;
+			}
+			page.Used = 0;
 		}
 
-		m_CommandBufferPtr = m_CommandBuffer;
+		m_LastFrameSize = m_FrameSize;
+		if (m_FrameSize > m_HighWaterMark)
+		{
+			m_HighWaterMark = m_FrameSize;
+			JN_RENDER_TRACE("RenderCommandQueue: new high-water mark of {0} bytes across {1} pages", m_HighWaterMark, m_CurrentPage + 1);
+		}
+		m_FrameSize = 0;
+		m_CurrentPage = 0;
 		m_CommandCount = 0;
 	}
 
-}
\ No newline at end of file
+}
@@ -2,23 +2,56 @@
 
 namespace Janus {
 
+	// Linear, paged command buffer. Each command is a function pointer followed by its payload (a lambda),
+	// aligned to the payload's alignment. Pages are chained when a frame outgrows the current page and are
+	// reused, without clearing, on the next frame.
 	class RenderCommandQueue
 	{
 	public:
 		typedef void(*RenderCommandFn)(void*);
 
-		RenderCommandQueue();
+		static constexpr uint32_t DefaultPageSize = 1024 * 1024; // 1mb
+
+		RenderCommandQueue(uint32_t pageSize = DefaultPageSize);
 		~RenderCommandQueue();
 
-		void* Allocate(RenderCommandFn func, uint32_t size);
+		void* Allocate(RenderCommandFn func, uint32_t size, uint32_t alignment = alignof(std::max_align_t));
 
 		void Execute();
+
+		uint32_t GetCommandCount() const { return m_CommandCount; }
+		// Bytes recorded in the last executed frame, and the largest frame seen so far
+		uint32_t GetLastFrameSize() const { return m_LastFrameSize; }
+		uint32_t GetHighWaterMark() const { return m_HighWaterMark; }
+		uint32_t GetPageCount() const { return (uint32_t)m_Pages.size(); }
+	private:
+		struct CommandHeader
+		{
+			RenderCommandFn Function;
+			uint32_t PayloadOffset; // From the start of the header
+			uint32_t Stride;		// From the start of the header to the next header
+		};
+
+		struct Page
+		{
+			uint8_t* Data = nullptr;
+			uint32_t Capacity = 0;
+			uint32_t Used = 0;
+		};
+
+		// Inserts a page at index, so pages after it are still reused in order
+		Page& AllocatePage(uint32_t index, uint32_t minCapacity);
+
 	private:
-		uint8_t* m_CommandBuffer;
-		uint8_t* m_CommandBufferPtr;
+		std::vector<Page> m_Pages;
+		uint32_t m_CurrentPage = 0;
+		uint32_t m_PageSize;
 		uint32_t m_CommandCount = 0;
+		uint32_t m_FrameSize = 0;
+		uint32_t m_LastFrameSize = 0;
+		uint32_t m_HighWaterMark = 0;
 	};
 
 
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,275 @@
+#include "jnpch.h"
+#include "Graphics/RenderStateCache.h"
+
+#include <atomic>
+
+namespace Janus
+{
+	static constexpr uint32_t s_Unknown = 0xffffffff;
+
+	struct RenderStateCacheData
+	{
+		// Capabilities are stored as 0/1, or s_Unknown when the GL state has not been observed this frame
+		uint32_t DepthTest = s_Unknown;
+		uint32_t CullFace = s_Unknown;
+		uint32_t Blend = s_Unknown;
+		uint32_t BlendSource = s_Unknown;
+		uint32_t BlendDestination = s_Unknown;
+
+		uint32_t Program = s_Unknown;
+		uint32_t VertexArray = s_Unknown;
+		uint32_t ArrayBuffer = s_Unknown;
+		// Element buffer binding is part of the vertex array state
+		uint32_t ElementArrayBuffer = s_Unknown;
+		uint32_t DrawIndirectBuffer = s_Unknown;
+		uint32_t TextureUnits[RenderStateCache::MaxTextureUnits];
+		uint32_t UniformBuffers[RenderStateCache::MaxUniformBufferBindings];
+		uint32_t StorageBuffers[RenderStateCache::MaxStorageBufferBindings];
+
+		RenderStateCache::Statistics Stats;
+		// Written by the render thread once per frame, read by anyone
+		std::atomic<uint32_t> LastFrameCalls{ 0 };
+		std::atomic<uint32_t> LastFrameFiltered{ 0 };
+
+		RenderStateCacheData()
+		{
+			for (auto &unit : TextureUnits)
+				unit = s_Unknown;
+			for (auto &binding : UniformBuffers)
+				binding = s_Unknown;
+			for (auto &binding : StorageBuffers)
+				binding = s_Unknown;
+		}
+	};
+
+	static RenderStateCacheData s_Data;
+
+	// Returns true when the caller has to issue the GL call
+	static bool Update(uint32_t &cached, uint32_t value)
+	{
+		if (cached == value)
+		{
+			s_Data.Stats.Filtered++;
+			return false;
+		}
+
+		cached = value;
+		s_Data.Stats.Calls++;
+		return true;
+	}
+
+	static void SetCapability(uint32_t &cached, GLenum capability, bool enabled)
+	{
+		if (!Update(cached, enabled ? 1 : 0))
+			return;
+
+		if (enabled)
+			glEnable(capability);
+		else
+			glDisable(capability);
+	}
+
+	void RenderStateCache::NewFrame()
+	{
+		s_Data.LastFrameCalls.store(s_Data.Stats.Calls, std::memory_order_relaxed);
+		s_Data.LastFrameFiltered.store(s_Data.Stats.Filtered, std::memory_order_relaxed);
+		s_Data.Stats = {};
+		Invalidate();
+	}
+
+	void RenderStateCache::Invalidate()
+	{
+		s_Data.DepthTest = s_Data.CullFace = s_Data.Blend = s_Unknown;
+		s_Data.BlendSource = s_Data.BlendDestination = s_Unknown;
+		s_Data.Program = s_Data.VertexArray = s_Unknown;
+		s_Data.ArrayBuffer = s_Data.ElementArrayBuffer = s_Data.DrawIndirectBuffer = s_Unknown;
+		for (auto &unit : s_Data.TextureUnits)
+			unit = s_Unknown;
+		for (auto &binding : s_Data.UniformBuffers)
+			binding = s_Unknown;
+		for (auto &binding : s_Data.StorageBuffers)
+			binding = s_Unknown;
+	}
+
+	void RenderStateCache::InvalidateTextureUnit(uint32_t slot)
+	{
+		if (slot < MaxTextureUnits)
+			s_Data.TextureUnits[slot] = s_Unknown;
+	}
+
+	void RenderStateCache::SetDepthTest(bool enabled)
+	{
+		SetCapability(s_Data.DepthTest, GL_DEPTH_TEST, enabled);
+	}
+
+	void RenderStateCache::SetCullFace(bool enabled)
+	{
+		SetCapability(s_Data.CullFace, GL_CULL_FACE, enabled);
+	}
+
+	void RenderStateCache::SetBlend(bool enabled)
+	{
+		SetCapability(s_Data.Blend, GL_BLEND, enabled);
+	}
+
+	void RenderStateCache::SetBlendFunc(GLenum source, GLenum destination)
+	{
+		if (s_Data.BlendSource == source && s_Data.BlendDestination == destination)
+		{
+			s_Data.Stats.Filtered++;
+			return;
+		}
+
+		s_Data.BlendSource = source;
+		s_Data.BlendDestination = destination;
+		s_Data.Stats.Calls++;
+		glBlendFunc(source, destination);
+	}
+
+	void RenderStateCache::UseProgram(uint32_t program)
+	{
+		if (Update(s_Data.Program, program))
+			glUseProgram(program);
+	}
+
+	void RenderStateCache::BindVertexArray(uint32_t vertexArray)
+	{
+		if (Update(s_Data.VertexArray, vertexArray))
+		{
+			glBindVertexArray(vertexArray);
+			s_Data.ElementArrayBuffer = s_Unknown;
+		}
+	}
+
+	void RenderStateCache::BindBuffer(GLenum target, uint32_t buffer)
+	{
+		uint32_t *cached = nullptr;
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER:
+			cached = &s_Data.ArrayBuffer;
+			break;
+		case GL_ELEMENT_ARRAY_BUFFER:
+			cached = &s_Data.ElementArrayBuffer;
+			break;
+		case GL_DRAW_INDIRECT_BUFFER:
+			cached = &s_Data.DrawIndirectBuffer;
+			break;
+		}
+
+		if (!cached)
+		{
+			s_Data.Stats.Calls++;
+			glBindBuffer(target, buffer);
+			return;
+		}
+
+		if (Update(*cached, buffer))
+			glBindBuffer(target, buffer);
+	}
+
+	void RenderStateCache::BindTextureUnit(uint32_t slot, uint32_t texture)
+	{
+		if (slot >= MaxTextureUnits)
+		{
+			s_Data.Stats.Calls++;
+			glBindTextureUnit(slot, texture);
+			return;
+		}
+
+		if (Update(s_Data.TextureUnits[slot], texture))
+			glBindTextureUnit(slot, texture);
+	}
+
+	void RenderStateCache::BindUniformBuffer(uint32_t binding, uint32_t buffer)
+	{
+		if (binding >= MaxUniformBufferBindings)
+		{
+			s_Data.Stats.Calls++;
+			glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+			return;
+		}
+
+		if (Update(s_Data.UniformBuffers[binding], buffer))
+			glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+	}
+
+	void RenderStateCache::BindUniformBufferRange(uint32_t binding, uint32_t buffer, uint32_t offset, uint32_t size)
+	{
+		s_Data.Stats.Calls++;
+		glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+		if (binding < MaxUniformBufferBindings)
+			s_Data.UniformBuffers[binding] = s_Unknown;
+	}
+
+	void RenderStateCache::BindStorageBuffer(uint32_t binding, uint32_t buffer)
+	{
+		if (binding >= MaxStorageBufferBindings)
+		{
+			s_Data.Stats.Calls++;
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+			return;
+		}
+
+		if (Update(s_Data.StorageBuffers[binding], buffer))
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+	}
+
+	void RenderStateCache::OnProgramDeleted(uint32_t program)
+	{
+		if (s_Data.Program == program)
+			s_Data.Program = s_Unknown;
+	}
+
+	void RenderStateCache::OnVertexArrayDeleted(uint32_t vertexArray)
+	{
+		if (s_Data.VertexArray == vertexArray)
+		{
+			s_Data.VertexArray = s_Unknown;
+			s_Data.ElementArrayBuffer = s_Unknown;
+		}
+	}
+
+	void RenderStateCache::OnBuffersDeleted(uint32_t count, const uint32_t *buffers)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (s_Data.ArrayBuffer == buffers[i])
+				s_Data.ArrayBuffer = s_Unknown;
+			if (s_Data.ElementArrayBuffer == buffers[i])
+				s_Data.ElementArrayBuffer = s_Unknown;
+			if (s_Data.DrawIndirectBuffer == buffers[i])
+				s_Data.DrawIndirectBuffer = s_Unknown;
+			for (auto &binding : s_Data.UniformBuffers)
+			{
+				if (binding == buffers[i])
+					binding = s_Unknown;
+			}
+			for (auto &binding : s_Data.StorageBuffers)
+			{
+				if (binding == buffers[i])
+					binding = s_Unknown;
+			}
+		}
+	}
+
+	void RenderStateCache::OnTexturesDeleted(uint32_t count, const uint32_t *textures)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			for (auto &unit : s_Data.TextureUnits)
+			{
+				if (unit == textures[i])
+					unit = s_Unknown;
+			}
+		}
+	}
+
+	RenderStateCache::Statistics RenderStateCache::GetLastFrameStatistics()
+	{
+		Statistics stats;
+		stats.Calls = s_Data.LastFrameCalls.load(std::memory_order_relaxed);
+		stats.Filtered = s_Data.LastFrameFiltered.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad/glad.h>
+
+namespace Janus
+{
+	// Render thread side shadow of the GL state touched by the renderer. Calls that would not change
+	// the current state are dropped before they reach the driver. State starts out unknown every frame,
+	// so code that changes GL state behind the cache's back only has to invalidate the parts it touched.
+	class RenderStateCache
+	{
+	public:
+		static constexpr uint32_t MaxTextureUnits = 32;
+		static constexpr uint32_t MaxUniformBufferBindings = 16;
+		static constexpr uint32_t MaxStorageBufferBindings = 8;
+
+		struct Statistics
+		{
+			uint32_t Calls = 0;	   // State calls forwarded to GL
+			uint32_t Filtered = 0; // Redundant state calls that were skipped
+		};
+
+		// Publishes the previous frame's statistics and forgets all cached state
+		static void NewFrame();
+		static void Invalidate();
+		static void InvalidateTextureUnit(uint32_t slot);
+
+		static void SetDepthTest(bool enabled);
+		static void SetCullFace(bool enabled);
+		static void SetBlend(bool enabled);
+		static void SetBlendFunc(GLenum source, GLenum destination);
+
+		static void UseProgram(uint32_t program);
+		static void BindVertexArray(uint32_t vertexArray);
+		static void BindBuffer(GLenum target, uint32_t buffer);
+		static void BindTextureUnit(uint32_t slot, uint32_t texture);
+		static void BindUniformBuffer(uint32_t binding, uint32_t buffer);
+		// Ranges change with nearly every call, so they are always forwarded
+		static void BindUniformBufferRange(uint32_t binding, uint32_t buffer, uint32_t offset, uint32_t size);
+		static void BindStorageBuffer(uint32_t binding, uint32_t buffer);
+
+		// Deleting a bound object unbinds it, and its name may be handed out again
+		static void OnProgramDeleted(uint32_t program);
+		static void OnVertexArrayDeleted(uint32_t vertexArray);
+		static void OnBuffersDeleted(uint32_t count, const uint32_t *buffers);
+		static void OnTexturesDeleted(uint32_t count, const uint32_t *textures);
+
+		// Safe to call from any thread
+		static Statistics GetLastFrameStatistics();
+	};
+}
@@ -0,0 +1,80 @@
+#include "jnpch.h"
+#include "Graphics/RenderThread.h"
+
+namespace Janus
+{
+	RenderThread::~RenderThread()
+	{
+		Terminate();
+	}
+
+	void RenderThread::Run(const std::function<void()> &onStart, const std::function<void()> &onFrame, const std::function<void()> &onStop)
+	{
+		JN_ASSERT(!m_Running, "RENDER_THREAD_ERROR: Render thread is already running!");
+		m_Running = true;
+		m_TerminateRequested = false;
+		m_State = State::Idle;
+		m_Thread = std::thread(&RenderThread::Loop, this, onStart, onFrame, onStop);
+	}
+
+	void RenderThread::Terminate()
+	{
+		if (!m_Running)
+			return;
+
+		BlockUntilIdle();
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_TerminateRequested = true;
+		}
+		m_Condition.notify_all();
+		m_Thread.join();
+		m_Running = false;
+	}
+
+	void RenderThread::Kick()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			JN_ASSERT(m_State == State::Idle, "RENDER_THREAD_ERROR: Kicked a frame while the previous one is still in flight!");
+			m_State = State::Kick;
+		}
+		m_Condition.notify_all();
+	}
+
+	void RenderThread::BlockUntilIdle()
+	{
+		if (!m_Running)
+			return;
+
+		JN_PROFILE_FUNCTION();
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this]()
+						 { return m_State == State::Idle; });
+	}
+
+	void RenderThread::Loop(std::function<void()> onStart, std::function<void()> onFrame, std::function<void()> onStop)
+	{
+		onStart();
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]()
+								 { return m_State == State::Kick || m_TerminateRequested; });
+				if (m_State != State::Kick && m_TerminateRequested)
+					break;
+				m_State = State::Busy;
+			}
+
+			onFrame();
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_State = State::Idle;
+			}
+			m_Condition.notify_all();
+		}
+		onStop();
+	}
+}
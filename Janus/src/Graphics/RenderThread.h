@@ -0,0 +1,45 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Janus
+{
+	// Executes recorded render command queues on a dedicated thread. The main thread records frame N+1
+	// while the render thread consumes frame N; Kick() and BlockUntilIdle() form the frame fence.
+	class RenderThread
+	{
+	public:
+		enum class State
+		{
+			Idle = 0,
+			Kick,
+			Busy
+		};
+
+		RenderThread() = default;
+		~RenderThread();
+
+		// onStart/onStop run on the render thread and are used to hand the graphics context over
+		void Run(const std::function<void()> &onStart, const std::function<void()> &onFrame, const std::function<void()> &onStop);
+		void Terminate();
+
+		void Kick();
+		void BlockUntilIdle();
+
+		bool IsRunning() const { return m_Running; }
+
+	private:
+		void Loop(std::function<void()> onStart, std::function<void()> onFrame, std::function<void()> onStop);
+
+	private:
+		std::thread m_Thread;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		State m_State = State::Idle;
+		bool m_Running = false;
+		bool m_TerminateRequested = false;
+	};
+}
@@ -1,29 +1,68 @@
 #include "jnpch.h"
 
+#include <atomic>
+
 #include "Core/Application.h"
+#include "Core/Window.h"
 
 #include "Graphics/Renderer.h"
+#include "Graphics/RenderThread.h"
+#include "Graphics/RenderStateCache.h"
 #include "Graphics/Camera.h"
 #include "Graphics/Mesh.h"
 #include "Graphics/SceneRenderer.h"
 #include "Graphics/RenderPass.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/ShaderReloader.h"
 
 namespace Janus
 {
+	// Slots of the r_Draw ring, each padded to the largest uniform buffer offset alignment
+	static constexpr uint32_t s_DrawUniformSlots = 1024;
 
 	struct RendererData
 	{
 		Ref<RenderPass> m_ActiveRenderPass;
-		RenderCommandQueue m_CommandQueue;
+		// Double buffered: the main thread records into m_CommandQueue[m_SubmitQueueIndex]
+		// while the render thread executes the other one
+		RenderCommandQueue m_CommandQueue[2];
+		uint32_t m_SubmitQueueIndex = 0;
+		// Command lists recorded for each frame queue, reused once that queue has executed
+		std::vector<std::unique_ptr<RenderCommandQueue>> m_CommandLists[2];
+		uint32_t m_CommandListCount[2] = { 0, 0 };
+		RenderThread m_RenderThread;
 		Ref<ShaderLibrary> m_ShaderLibrary;
+		Ref<Shader> m_FallbackShader;
 
 		Ref<TextureCube> BlackCubeTexture;
 		Ref<VertexBuffer> m_FullscreenQuadVertexBuffer;
 		Ref<IndexBuffer> m_FullscreenQuadIndexBuffer;
 		Ref<Pipeline> m_FullscreenQuadPipeline;
+		// Single identity transform for meshes drawn without instancing
+		Ref<VertexBuffer> m_IdentityInstanceBuffer;
+		Ref<GeometryArena> m_GeometryArena;
+		// r_Draw block: a ring with a slot per non-instanced draw, and a constant identity for instanced ones.
+		// Draws never rewrite a slot an earlier draw may still be reading; the ring is orphaned when it wraps
+		Ref<UniformBuffer> m_DrawUniformBuffer;
+		std::atomic<uint32_t> m_DrawUniformSlot{0};
+		Ref<UniformBuffer> m_IdentityDrawUniformBuffer;
 	};
 
 	static RendererData s_Data;
+	static thread_local bool s_IsRenderThread = false;
+	// Command list the calling thread is recording into, if any
+	static thread_local RenderCommandQueue *s_ActiveCommandList = nullptr;
+
+	static constexpr uint32_t s_CommandListPageSize = 64 * 1024;
+	static constexpr UniformID s_TransformID("u_Transform");
+	// Initial geometry arena size; it doubles whenever a mesh does not fit
+	static constexpr uint32_t s_ArenaVertexCapacity = 1024 * 1024;
+	static constexpr uint32_t s_ArenaIndexCapacity = 4 * 1024 * 1024;
+
+	static GLenum GetGLIndexType(IndexFormat format)
+	{
+		return format == IndexFormat::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
 
 	void Renderer::Init()
 	{
@@ -48,12 +87,26 @@ namespace Janus
 		glEnable(GL_MULTISAMPLE);
 		glEnable(GL_STENCIL_TEST);
 
+		s_Data.m_GeometryArena = Ref<GeometryArena>::Create(Mesh::GetVertexLayout(), Mesh::GetInstanceLayout(), NumAttributes, s_ArenaVertexCapacity, s_ArenaIndexCapacity);
+
+		// Mesh shaders decode whichever vertex format the arena holds
+		if (Mesh::GetVertexFormat() == MeshVertexFormat::Compact)
+			Shader::AddGlobalDefine("JN_COMPACT_VERTICES");
+		Shader::EnableParallelCompile();
 		s_Data.m_ShaderLibrary = Ref<ShaderLibrary>::Create();
+		// The fallback must be usable by the first frame, so it is the one shader we wait on. Every other
+		// compile is only started here and finishes in the background
+		Renderer::GetShaderLibrary()->Load("./assets/shaders/janus_fallback.glsl", "janus_fallback");
+		s_Data.m_FallbackShader = Renderer::GetShaderLibrary()->Get("janus_fallback");
+		Ref<Shader> fallbackShader = s_Data.m_FallbackShader;
+		Renderer::Submit([fallbackShader]()
+						 { fallbackShader->FinishCompile(); });
 		Renderer::GetShaderLibrary()->Load("./assets/shaders/janus_pbr.glsl", "janus_pbr");
 		Renderer::GetShaderLibrary()->Load("./assets/shaders/janus_grid.glsl", "janus_grid");
 		Renderer::GetShaderLibrary()->Load("./assets/shaders/janus_skybox.glsl", "janus_skybox");
 		//Renderer::GetShaderLibrary()->Load("./assets/shaders/janus_quad.glsl", "janus_quad");
 		SceneRenderer::Init();
+		ShaderReloader::Init("./assets/shaders");
 
 
 		uint32_t blackCubeTextureData[6] = { 0xff000000, 0xff000000, 0xff000000, 0xff000000, 0xff000000, 0xff000000 };
@@ -98,6 +151,13 @@ namespace Janus
 			0,
 		};
 		s_Data.m_FullscreenQuadIndexBuffer = Ref<IndexBuffer>::Create(indices, 6 * sizeof(uint32_t));
+
+		glm::mat4 identity(1.0f);
+		MeshInstance identityInstance = {identity, glm::uvec4(0xffffffff)};
+		s_Data.m_IdentityInstanceBuffer = Ref<VertexBuffer>::Create(&identityInstance, sizeof(MeshInstance));
+		s_Data.m_DrawUniformBuffer = Ref<UniformBuffer>::Create(s_DrawUniformSlots * UniformBuffer::MaxOffsetAlignment, UniformBuffer::DrawBinding);
+		s_Data.m_IdentityDrawUniformBuffer = Ref<UniformBuffer>::Create(sizeof(glm::mat4), UniformBuffer::DrawBinding);
+		s_Data.m_IdentityDrawUniformBuffer->SetData(&identity, sizeof(glm::mat4));
 	}
 
 	Ref<ShaderLibrary> Renderer::GetShaderLibrary()
@@ -105,6 +165,16 @@ namespace Janus
 		return s_Data.m_ShaderLibrary;
 	}
 
+	Ref<GeometryArena> Renderer::GetGeometryArena()
+	{
+		return s_Data.m_GeometryArena;
+	}
+
+	Ref<Shader> Renderer::GetFallbackShader()
+	{
+		return s_Data.m_FallbackShader;
+	}
+
 	void Renderer::Clear(float r, float g, float b, float a)
 	{
 		
@@ -124,9 +194,6 @@ namespace Janus
 		Renderer::Submit([=]()
 						 {
 							 JN_PROFILE_FUNCTION();
-							 if (!depthTest)
-								 glDisable(GL_DEPTH_TEST);
-
 							 GLenum glPrimitiveType = 0;
 							 switch (type)
 							 {
@@ -138,22 +205,115 @@ namespace Janus
 								 break;
 							 }
 
-							 if (faceCulling)
-								 glEnable(GL_CULL_FACE);
-							 else
-								 glDisable(GL_CULL_FACE);
+							 RenderStateCache::SetDepthTest(depthTest);
+							 RenderStateCache::SetCullFace(faceCulling);
 
 							 glDrawElements(glPrimitiveType, count, GL_UNSIGNED_INT, nullptr);
-
-							 if (!depthTest)
-								 glEnable(GL_DEPTH_TEST);
 						 });
 	}
 
 	void Renderer::WaitAndRender()
 	{
 		JN_PROFILE_FUNCTION();
-		s_Data.m_CommandQueue.Execute();
+		if (!s_Data.m_RenderThread.IsRunning())
+		{
+			// Commands submitted while the queue executes (e.g. from destructors) must not append to it
+			s_IsRenderThread = true;
+			RenderStateCache::NewFrame();
+			Shader::PollPendingCompiles();
+			s_Data.m_CommandQueue[s_Data.m_SubmitQueueIndex].Execute();
+			s_IsRenderThread = false;
+			s_Data.m_CommandListCount[s_Data.m_SubmitQueueIndex] = 0;
+			return;
+		}
+
+		s_Data.m_RenderThread.BlockUntilIdle();
+		s_Data.m_SubmitQueueIndex ^= 1;
+		// The queue we now record into has executed, and with it every command list it referenced
+		s_Data.m_CommandListCount[s_Data.m_SubmitQueueIndex] = 0;
+		s_Data.m_RenderThread.Kick();
+	}
+
+	void Renderer::WaitForRenderThread()
+	{
+		s_Data.m_RenderThread.BlockUntilIdle();
+	}
+
+	void Renderer::StartRenderThread(Window &window)
+	{
+		// Anything recorded during startup executes on the main thread before the context is handed over
+		WaitAndRender();
+		window.SetContextCurrent(false);
+
+		Window *windowPtr = &window;
+		s_Data.m_RenderThread.Run([windowPtr]()
+								  {
+									  s_IsRenderThread = true;
+									  windowPtr->SetContextCurrent(true);
+								  },
+								  []()
+								  {
+									  JN_PROFILE_SCOPE("Renderer::RenderThreadFrame");
+									  // The submit index only changes while this thread is idle
+									  RenderStateCache::NewFrame();
+									  Shader::PollPendingCompiles();
+									  s_Data.m_CommandQueue[s_Data.m_SubmitQueueIndex ^ 1].Execute();
+								  },
+								  [windowPtr]()
+								  {
+									  windowPtr->SetContextCurrent(false);
+									  s_IsRenderThread = false;
+								  });
+	}
+
+	void Renderer::StopRenderThread(Window &window)
+	{
+		if (!s_Data.m_RenderThread.IsRunning())
+			return;
+
+		// Flush the last recorded frame before shutting the thread down
+		WaitAndRender();
+		s_Data.m_RenderThread.Terminate();
+		window.SetContextCurrent(true);
+	}
+
+	bool Renderer::IsRenderThread()
+	{
+		return s_IsRenderThread;
+	}
+
+	RenderCommandQueue &Renderer::CreateCommandList()
+	{
+		JN_ASSERT(!s_ActiveCommandList && !IsRenderThread(), "RENDERER_ERROR: Command lists must be created on the main thread!");
+
+		auto &lists = s_Data.m_CommandLists[s_Data.m_SubmitQueueIndex];
+		uint32_t &count = s_Data.m_CommandListCount[s_Data.m_SubmitQueueIndex];
+		if (count == lists.size())
+			lists.push_back(std::make_unique<RenderCommandQueue>(s_CommandListPageSize));
+
+		RenderCommandQueue &commandList = *lists[count++];
+		JN_ASSERT(commandList.GetCommandCount() == 0, "RENDERER_ERROR: Command list from a previous frame was never submitted!");
+		return commandList;
+	}
+
+	void Renderer::BeginCommandList(RenderCommandQueue &commandList)
+	{
+		JN_ASSERT(!s_ActiveCommandList, "RENDERER_ERROR: A command list is already being recorded on this thread!");
+		s_ActiveCommandList = &commandList;
+	}
+
+	void Renderer::EndCommandList()
+	{
+		JN_ASSERT(s_ActiveCommandList, "RENDERER_ERROR: No command list is being recorded on this thread!");
+		s_ActiveCommandList = nullptr;
+	}
+
+	void Renderer::SubmitCommandList(RenderCommandQueue &commandList)
+	{
+		JN_ASSERT(!s_ActiveCommandList, "RENDERER_ERROR: Command lists must be submitted to the frame queue!");
+		RenderCommandQueue *list = &commandList;
+		Renderer::Submit([list]()
+						 { list->Execute(); });
 	}
 
 	void Renderer::BeginRenderPass(Ref<RenderPass> renderPass, bool clear)
@@ -188,48 +348,79 @@ namespace Janus
 		bool cullFace = true;
 		if (material)
 		{
+			// Quads don't carry the vertex inputs the fallback shader reads, so skip them until ready
+			auto shader = material->GetVariant();
+			if (!shader->IsReady() || shader->HasCompileErrors())
+				return;
+
 			material->Bind();
 			depthTest = material->GetFlag(MaterialFlag::DepthTest);
 			cullFace = !material->GetFlag(MaterialFlag::TwoSided);
 
-			auto shader = material->GetShader();
-			shader->SetMat4("u_Transform", transform);
+			shader->SetMat4(s_TransformID, transform);
 		}
 
-		s_Data.m_FullscreenQuadVertexBuffer->Bind();
-		s_Data.m_FullscreenQuadPipeline->Bind();
+		s_Data.m_FullscreenQuadPipeline->Bind(s_Data.m_FullscreenQuadVertexBuffer);
 		s_Data.m_FullscreenQuadIndexBuffer->Bind();
 		Renderer::DrawIndexed(6, PrimitiveType::Triangles, depthTest, cullFace);
 	}
 
 	void Renderer::SubmitMesh(Ref<Mesh> mesh, const glm::mat4 &transform, Ref<Material> overrideMaterial)
 	{
-		mesh->m_VertexBuffer->Bind();
-		mesh->m_Pipeline->Bind();
-		mesh->m_IndexBuffer->Bind();
+		for (uint32_t i = 0; i < mesh->m_Submeshes.size(); i++)
+			SubmitSubmesh(mesh, i, transform, overrideMaterial, i == 0);
+	}
 
-		auto &materials = mesh->GetMaterials();
-		for (Submesh &submesh : mesh->m_Submeshes)
-		{
-			auto material = overrideMaterial ? overrideMaterial : materials[submesh.MaterialIndex];
-			auto shader = material->GetShader();
+	void Renderer::SubmitSubmesh(Ref<Mesh> mesh, uint32_t submeshIndex, const glm::mat4 &transform, Ref<Material> overrideMaterial, bool bindMesh, bool bindMaterial)
+	{
+		if (bindMesh)
+			mesh->m_GeometryArena->Bind(s_Data.m_IdentityInstanceBuffer);
 
+		const Submesh &submesh = mesh->m_Submeshes[submeshIndex];
+		auto material = overrideMaterial ? overrideMaterial : mesh->m_Materials[submesh.MaterialIndex];
+		if (bindMaterial)
 			material->Bind();
-			shader->SetMat4("u_Transform", transform * submesh.Transform);
-			Renderer::Submit([submesh, material]()
-							 {
-								 JN_PROFILE_FUNCTION();
-								 if (material->GetFlag(MaterialFlag::DepthTest))
-									 glEnable(GL_DEPTH_TEST);
-								 else
-									 glDisable(GL_DEPTH_TEST);
-								 if (!material->GetFlag(MaterialFlag::TwoSided))
-									 glEnable(GL_CULL_FACE);
-								 else
-									 glDisable(GL_CULL_FACE);
-								 glDrawElementsBaseVertex(GL_TRIANGLES, submesh.IndexCount, GL_UNSIGNED_INT, (void *)(sizeof(uint32_t) * submesh.BaseIndex), submesh.BaseVertex);
-							 });
-		}
+		glm::mat4 submeshTransform = transform * submesh.GetVertexTransform();
+		uint32_t slot = s_Data.m_DrawUniformSlot.fetch_add(1, std::memory_order_relaxed) % s_DrawUniformSlots;
+		if (slot == 0)
+			s_Data.m_DrawUniformBuffer->Orphan();
+		uint32_t offset = slot * UniformBuffer::MaxOffsetAlignment;
+		s_Data.m_DrawUniformBuffer->SetData(&submeshTransform, sizeof(glm::mat4), offset);
+		s_Data.m_DrawUniformBuffer->BindRange(offset, sizeof(glm::mat4));
+
+		uint32_t indexCount = submesh.IndexCount;
+		uint32_t baseIndex = mesh->m_GeometryAllocation.BaseIndex + submesh.BaseIndex;
+		uint32_t baseVertex = mesh->m_GeometryAllocation.BaseVertex + submesh.BaseVertex;
+		IndexFormat indexFormat = mesh->m_GeometryAllocation.Format;
+		Renderer::Submit([indexCount, baseIndex, baseVertex, indexFormat, material]()
+						 {
+							 JN_PROFILE_FUNCTION();
+							 RenderStateCache::SetDepthTest(material->GetFlag(MaterialFlag::DepthTest));
+							 RenderStateCache::SetCullFace(!material->GetFlag(MaterialFlag::TwoSided));
+							 size_t offset = (size_t)GetIndexSize(indexFormat) * baseIndex;
+							 glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, GetGLIndexType(indexFormat), (void *)offset, baseVertex);
+						 });
+	}
+
+	void Renderer::BindGeometryArena(Ref<VertexBuffer> instanceBuffer)
+	{
+		s_Data.m_GeometryArena->Bind(instanceBuffer);
+	}
+
+	void Renderer::SubmitMultiDrawIndirect(Ref<Material> material, Ref<VertexBuffer> commandBuffer, uint32_t firstCommand, uint32_t commandCount, IndexFormat indexFormat)
+	{
+		material->Bind();
+		// The whole transform comes from the instance buffer
+		s_Data.m_IdentityDrawUniformBuffer->Bind();
+
+		Renderer::Submit([material, commandBuffer, firstCommand, commandCount, indexFormat]()
+						 {
+							 JN_PROFILE_FUNCTION();
+							 RenderStateCache::SetDepthTest(material->GetFlag(MaterialFlag::DepthTest));
+							 RenderStateCache::SetCullFace(!material->GetFlag(MaterialFlag::TwoSided));
+							 RenderStateCache::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer->GetRendererID());
+							 glMultiDrawElementsIndirect(GL_TRIANGLES, GetGLIndexType(indexFormat), (void *)(sizeof(DrawElementsIndirectCommand) * firstCommand), commandCount, 0);
+						 });
 	}
 
 	void Renderer::SubmitFullscreenQuad(Ref<Material> material)
@@ -238,13 +429,16 @@ namespace Janus
 		bool cullFace = true;
 		if (material)
 		{
+			auto shader = material->GetVariant();
+			if (!shader->IsReady() || shader->HasCompileErrors())
+				return;
+
 			material->Bind();
 			depthTest = material->GetFlag(MaterialFlag::DepthTest);
 			cullFace = !material->GetFlag(MaterialFlag::TwoSided);
 		}
 
-		s_Data.m_FullscreenQuadVertexBuffer->Bind();
-		s_Data.m_FullscreenQuadPipeline->Bind();
+		s_Data.m_FullscreenQuadPipeline->Bind(s_Data.m_FullscreenQuadVertexBuffer);
 		s_Data.m_FullscreenQuadIndexBuffer->Bind();
 
 		Renderer::DrawIndexed(6, PrimitiveType::Triangles, depthTest, cullFace);
@@ -252,7 +446,9 @@ namespace Janus
 
 	RenderCommandQueue &Renderer::GetRenderCommandQueue()
 	{
-		return s_Data.m_CommandQueue;
+		if (s_ActiveCommandList)
+			return *s_ActiveCommandList;
+		return s_Data.m_CommandQueue[s_Data.m_SubmitQueueIndex];
 	}
 
 	Ref<TextureCube> Renderer::GetBlackCubeTexture()
@@ -16,6 +16,7 @@
 
 namespace Janus
 {
+    class Window;
 
     enum class PrimitiveType
     {
@@ -37,6 +38,13 @@ namespace Janus
         template <typename FuncT>
         static void Submit(FuncT &&func)
         {
+            // Commands issued while executing a queue (e.g. GL object deletion in destructors) run immediately
+            if (IsRenderThread())
+            {
+                func();
+                return;
+            }
+
             auto renderCmd = [](void *ptr)
             {
                 auto pFunc = (FuncT *)ptr;
@@ -44,18 +52,45 @@ namespace Janus
                 //static_assert(std::is_trivially_destructible_v<FuncT>, "FuncT must be trivially destructible");
                 pFunc->~FuncT();
             };
-            auto storageBuffer = GetRenderCommandQueue().Allocate(renderCmd, sizeof(func));
+            auto storageBuffer = GetRenderCommandQueue().Allocate(renderCmd, sizeof(func), alignof(FuncT));
             new (storageBuffer) FuncT(std::forward<FuncT>(func));
         }
 
+        // Fences the previous frame, hands the recorded queue to the render thread and starts recording the next one
         static void WaitAndRender();
+        // Blocks until the render thread has finished executing the previous frame
+        static void WaitForRenderThread();
+        static void StartRenderThread(Window &window);
+        static void StopRenderThread(Window &window);
+        static bool IsRenderThread();
+
+        // Command lists let worker threads record commands in parallel. Lists are created on the main thread,
+        // recorded between Begin/EndCommandList on any thread and stitched into the frame queue, in the order
+        // they are submitted, by SubmitCommandList. Lists are recycled once their frame has executed.
+        static RenderCommandQueue &CreateCommandList();
+        static void BeginCommandList(RenderCommandQueue &commandList);
+        static void EndCommandList();
+        static void SubmitCommandList(RenderCommandQueue &commandList);
+
         static void BeginRenderPass(Ref<RenderPass> renderPass, bool clear = true);
         static void EndRenderPass();
         static void SubmitQuad(Ref<Material> material, const glm::mat4 &transform = glm::mat4(1.0f));
         static void SubmitMesh(Ref<Mesh> mesh, const glm::mat4 &transform, Ref<Material> overrideMaterial = nullptr);
+        // Draws a single submesh. Callers submitting sorted draws can skip binding the mesh buffers or the
+        // material when the previous draw already bound them
+        static void SubmitSubmesh(Ref<Mesh> mesh, uint32_t submeshIndex, const glm::mat4 &transform, Ref<Material> overrideMaterial = nullptr, bool bindMesh = true, bool bindMaterial = true);
+        // Binds the geometry arena that every mesh lives in, reading instance transforms from instanceBuffer
+        static void BindGeometryArena(Ref<VertexBuffer> instanceBuffer);
+        // Issues commandCount draws from the indirect command buffer with one call. Expects the geometry
+        // arena to be bound; every command reads its transforms from the instance buffer bound with it.
+        // All of the commands must draw indices of indexFormat
+        static void SubmitMultiDrawIndirect(Ref<Material> material, Ref<VertexBuffer> commandBuffer, uint32_t firstCommand, uint32_t commandCount, IndexFormat indexFormat = IndexFormat::UInt32);
         static void SubmitFullscreenQuad(Ref<Material> material);
         static Ref<TextureCube> GetBlackCubeTexture();
         static Ref<ShaderLibrary> GetShaderLibrary();
+        static Ref<GeometryArena> GetGeometryArena();
+        // Unlit shader that meshes are drawn with while their material's shader is still compiling
+        static Ref<Shader> GetFallbackShader();
 
     private:
         static RenderCommandQueue &GetRenderCommandQueue();
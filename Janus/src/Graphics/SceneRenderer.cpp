@@ -5,8 +5,115 @@
 
 #include "Graphics/SceneRenderer.h"
 #include "Graphics/Renderer.h"
+#include "Graphics/FrustumCuller.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/LightGrid.h"
+#include "Graphics/LightSelector.h"
+#include "Graphics/LodSelector.h"
+#include "Graphics/RenderStateCache.h"
+#include "Core/ThreadPool.h"
+#include "Core/RadixSort.h"
+
 namespace Janus
 {
+    // Draw lists smaller than this are recorded on the calling thread
+    static constexpr uint32_t s_DrawsPerCommandList = 64;
+    static constexpr uint32_t s_InitialInstanceCapacity = 1024;
+    // Shader storage binding points of the light lists in janus_lights.glsl
+    static constexpr uint32_t s_PointLightBinding = 0;
+    static constexpr uint32_t s_LightGridBinding = 1;
+    static constexpr uint32_t s_LightIndexBinding = 2;
+
+    static constexpr UniformID s_InverseViewProjectionID("u_InverseVP");
+    static constexpr UniformID s_SkyIntensityID("u_SkyIntensity");
+    static constexpr UniformID s_GridViewProjectionID("u_ViewProjection");
+
+    // std430 mirror of an r_PointLights entry in janus_lights.glsl
+    struct PointLightUniforms
+    {
+        glm::vec3 Position;
+        float Intensity;
+        glm::vec3 Radiance;
+        float Radius;
+        float Falloff;
+        float Padding[3];
+    };
+
+    // std140 mirror of the r_Frame uniform block in janus_frame.glsl
+    struct FrameUniforms
+    {
+        glm::mat4 ViewProjection;
+        glm::mat4 View;
+        glm::vec3 CameraPosition;
+        int32_t PointLightCount;
+        // xy: light grid tiles per pixel, zw: slice scale and bias applied to log(view depth)
+        glm::vec4 ClusterScale;
+        int32_t ClusterTilesX;
+        int32_t ClusterTilesY;
+        int32_t ClusterSlices;
+        // A LightCulling value
+        int32_t LightCullingMode;
+    };
+
+    static_assert(sizeof(PointLightUniforms) == 48, "PointLightUniforms must match the std430 layout");
+    static_assert(offsetof(FrameUniforms, ClusterScale) == 144, "FrameUniforms must match the std140 layout");
+    static_assert(sizeof(FrameUniforms) == 176, "FrameUniforms must match the std140 layout");
+
+    enum class RenderQueue : uint32_t
+    {
+        Opaque = 0,
+        Transparent = 1
+    };
+
+    // Draw sort key layout, most significant bits first. Opaque draws are grouped by state and then ordered
+    // front to back; transparent draws are ordered back to front before anything else.
+    //   Opaque:      pass(2) | queue(2) | shader(12) | material(16) | geometry(16) | depth(16)
+    //   Transparent: pass(2) | queue(2) | inverted depth(16) | shader(12) | material(16) | geometry(16)
+    // The geometry field names one level of detail of one submesh, so draws that can share an instanced command
+    // sort next to each other regardless of their depth.
+    static uint64_t MakeSortKey(uint32_t pass, RenderQueue queue, uint64_t shader, uint64_t material, uint64_t geometry, float depth)
+    {
+        // Non-negative floats order like their bit patterns, so the top bits make a depth key that needs no range
+        depth = std::max(depth, 0.0f);
+        uint32_t depthBits;
+        memcpy(&depthBits, &depth, sizeof(float));
+        uint64_t depthKey = depthBits >> 16;
+
+        uint64_t key = (uint64_t)(pass & 0x3) << 62 | (uint64_t)queue << 60;
+        if (queue == RenderQueue::Opaque)
+            key |= (shader & 0xfff) << 48 | (material & 0xffff) << 32 | (geometry & 0xffff) << 16 | depthKey;
+        else
+            key |= (~depthKey & 0xffff) << 44 | (shader & 0xfff) << 32 | (material & 0xffff) << 16 | (geometry & 0xffff);
+        return key;
+    }
+
+    // Hands out dense per-frame ids for the objects packed into sort keys
+    struct SortIDMap
+    {
+        std::unordered_map<const void *, uint32_t> IDs;
+
+        uint32_t Get(const void *object)
+        {
+            return IDs.try_emplace(object, (uint32_t)IDs.size()).first->second;
+        }
+    };
+
+    // Replaces the contents of a per-frame buffer. Respecifying the data store orphans the previous frame's
+    // contents instead of waiting for the GPU to finish reading them
+    static void UploadFrameData(const Ref<VertexBuffer> &buffer, const void *data, uint32_t size)
+    {
+        if (!size)
+            return;
+
+        Buffer frameData = Buffer::Copy((void *)data, size);
+        Ref<VertexBuffer> target = buffer;
+        Renderer::Submit([target, frameData]() mutable
+                         {
+                             glNamedBufferData(target->GetRendererID(), frameData.Size, frameData.Data, GL_DYNAMIC_DRAW);
+                             frameData.Release();
+                         });
+    }
+
     struct SceneRendererData
     {
         const Scene *ActiveScene = nullptr;
@@ -30,12 +137,64 @@ namespace Janus
             Ref<Mesh> Mesh;
             Ref<Material> Material;
             glm::mat4 Transform;
+            // Identifies the submitter from frame to frame, 0 if it has no identity
+            uint64_t ID;
+        };
+        // One item per submesh, sorted by key before submission
+        struct DrawItem
+        {
+            uint64_t SortKey;
+            uint32_t DrawCommandIndex;
+            uint32_t SubmeshIndex;
+            // Index of the submesh's world bounds in the culler
+            uint32_t BoundsIndex;
+            // Level of detail drawn, see Submesh::GetLod
+            uint32_t Lod;
+        };
+        // Consecutive indirect commands that share a material, drawn with one multi-draw call
+        struct DrawBatch
+        {
+            Ref<Material> Material;
+            uint32_t FirstCommand;
+            uint32_t CommandCount;
+            IndexFormat Format;
         };
         Ref<Material> GridMaterial;
         std::vector<DrawCommand> DrawList;
+        std::vector<DrawItem> DrawItems;
+        std::vector<DrawItem> DrawItemScratch;
+        std::vector<DrawElementsIndirectCommand> IndirectCommands;
+        std::vector<DrawBatch> DrawBatches;
+        std::vector<MeshInstance> Instances;
+        Ref<VertexBuffer> InstanceBuffer;
+        // Holds IndirectCommands on the GPU; buffers are untyped, so it reuses the vertex buffer wrapper
+        Ref<VertexBuffer> IndirectBuffer;
+        FrustumCuller Culler;
+        std::vector<uint8_t> Visibility;
+        LodSelector DrawLodSelector;
+
+        FrameUniforms Frame;
+        Ref<UniformBuffer> FrameUniformBuffer;
+
+        // Clustered lighting. The light lists are shader storage buffers, kept in vertex buffer wrappers
+        // like the indirect buffer
+        LightGrid ClusterGrid;
+        std::vector<PointLightUniforms> PointLights;
+        Ref<VertexBuffer> PointLightBuffer;
+        Ref<VertexBuffer> LightGridBuffer;
+        Ref<VertexBuffer> LightIndexBuffer;
+        uint32_t ViewportWidth = 1280, ViewportHeight = 720;
+
+        // Per-draw lighting, selected into the instance data of every draw
+        LightSelector DrawLightSelector;
+        std::vector<AABB> InstanceBounds;
+        std::vector<glm::uvec4> InstanceLights;
+
+        SceneRendererOptions Options;
     };
 
     static SceneRendererData s_Data;
+    static Ref<Shader> equirectangularConversionShader, envFilteringShader, envIrradianceShader;
 
     void SceneRenderer::Init()
     {
@@ -63,11 +222,26 @@ namespace Janus
         float gridScale = 16.025f, gridSize = 0.025f;
         s_Data.GridMaterial->Set("u_Scale", gridScale);
         s_Data.GridMaterial->Set("u_Res", gridSize);
+
+        s_Data.InstanceBuffer = Ref<VertexBuffer>::Create(s_InitialInstanceCapacity * sizeof(MeshInstance), VertexBuffer::VertexBufferUsage::Dynamic);
+        s_Data.IndirectBuffer = Ref<VertexBuffer>::Create(s_InitialInstanceCapacity * sizeof(DrawElementsIndirectCommand), VertexBuffer::VertexBufferUsage::Dynamic);
+        s_Data.FrameUniformBuffer = Ref<UniformBuffer>::Create(sizeof(FrameUniforms), UniformBuffer::FrameBinding);
+        s_Data.PointLightBuffer = Ref<VertexBuffer>::Create(sizeof(PointLightUniforms), VertexBuffer::VertexBufferUsage::Dynamic);
+        s_Data.LightGridBuffer = Ref<VertexBuffer>::Create(LightGrid::ClusterCount * sizeof(LightGrid::Cluster), VertexBuffer::VertexBufferUsage::Dynamic);
+        s_Data.LightIndexBuffer = Ref<VertexBuffer>::Create(sizeof(uint32_t), VertexBuffer::VertexBufferUsage::Dynamic);
         //s_Data.CompositeShader = Ref<Shader>::Create("assets/shaders/SceneComposite.glsl");
+
+        // Start the environment compute shaders compiling alongside the library shaders; the first
+        // CreateEnvironmentMap only waits for whatever is left
+        equirectangularConversionShader = Ref<Shader>::Create("assets/shaders/janus_EquirectangularToCubeMap.glsl");
+        envFilteringShader = Ref<Shader>::Create("assets/shaders/janus_EnvironmentMipFilter.glsl");
+        envIrradianceShader = Ref<Shader>::Create("assets/shaders/janus_EnvironmentIrradiance.glsl");
     }
 
     void SceneRenderer::SetViewportSize(uint32_t width, uint32_t height)
     {
+        s_Data.ViewportWidth = std::max(width, 1u);
+        s_Data.ViewportHeight = std::max(height, 1u);
         s_Data.GeoPass->GetSpecification().TargetFramebuffer->Resize(width, height);
         s_Data.CompositePass->GetSpecification().TargetFramebuffer->Resize(width, height);
     }
@@ -92,10 +266,9 @@ namespace Janus
         FlushDrawList();
     }
 
-    void SceneRenderer::SubmitMesh(Ref<Mesh> mesh, const glm::mat4 &transform, Ref<Material> overrideMaterial)
+    void SceneRenderer::SubmitMesh(Ref<Mesh> mesh, const glm::mat4 &transform, Ref<Material> overrideMaterial, uint64_t id)
     {
-        // TODO: Culling, sorting, etc.
-        s_Data.DrawList.push_back({mesh, overrideMaterial, transform});
+        s_Data.DrawList.push_back({mesh, overrideMaterial, transform, id});
     }
 
     void SceneRenderer::GeometryPass()
@@ -107,27 +280,189 @@ namespace Janus
         auto viewProjection = sceneCamera.Camera.GetProjectionMatrix() * sceneCamera.ViewMatrix;
         glm::vec3 cameraPosition = glm::inverse(s_Data.sceneData.sceneCamera.ViewMatrix)[3];
 
-        uint32_t lightCount = uint32_t(s_Data.sceneData.sceneLights.size());
+        // Scene uniforms are shared by every draw, so they are uploaded once per frame
+        auto &frame = s_Data.Frame;
+        auto &lightGrid = s_Data.ClusterGrid;
+        glm::vec2 sliceScaleBias = lightGrid.GetSliceScaleBias();
+        frame.ViewProjection = viewProjection;
+        frame.View = sceneCamera.ViewMatrix;
+        frame.CameraPosition = cameraPosition;
+        frame.PointLightCount = (int32_t)s_Data.PointLights.size();
+        frame.ClusterScale = {(float)LightGrid::TilesX / s_Data.ViewportWidth, (float)LightGrid::TilesY / s_Data.ViewportHeight, sliceScaleBias.x, sliceScaleBias.y};
+        frame.ClusterTilesX = LightGrid::TilesX;
+        frame.ClusterTilesY = LightGrid::TilesY;
+        frame.ClusterSlices = LightGrid::Slices;
+        frame.LightCullingMode = (int32_t)s_Data.Options.PointLightCulling;
+        s_Data.FrameUniformBuffer->SetData(&frame, sizeof(FrameUniforms));
+        s_Data.FrameUniformBuffer->Bind();
 
         auto skyboxShader = s_Data.sceneData.SkyboxMaterial->GetShader();
-        s_Data.sceneData.SkyboxMaterial->Set("u_InverseVP", glm::inverse(viewProjection));
-        s_Data.sceneData.SkyboxMaterial->Set("u_SkyIntensity", s_Data.sceneData.SceneEnvironmentIntensity);
+        s_Data.sceneData.SkyboxMaterial->Set(s_InverseViewProjectionID, glm::inverse(viewProjection));
+        s_Data.sceneData.SkyboxMaterial->Set(s_SkyIntensityID, s_Data.sceneData.SceneEnvironmentIntensity);
         Renderer::SubmitFullscreenQuad(s_Data.sceneData.SkyboxMaterial);
 
+        // Cull whole meshes first, then the submeshes of the meshes that survived
+        Frustum frustum = Frustum::FromViewProjection(viewProjection);
+        auto &culler = s_Data.Culler;
+        culler.Clear();
         for (auto &dc : s_Data.DrawList)
+            culler.Add(dc.Mesh->GetBoundingBox(), dc.Transform);
+        culler.Cull(frustum, s_Data.Visibility);
+
+        s_Data.DrawItems.clear();
+        culler.Clear();
+        for (uint32_t i = 0; i < s_Data.DrawList.size(); i++)
         {
-            auto overrideMaterial = nullptr;
-            auto &materials = dc.Mesh->GetMaterials();
-            for (auto material : materials)
+            if (!s_Data.Visibility[i])
+                continue;
+
+            auto &dc = s_Data.DrawList[i];
+            for (uint32_t j = 0; j < dc.Mesh->m_Submeshes.size(); j++)
             {
-                material->Set("u_ViewProjectionMatrix", viewProjection);
-                material->Set("u_CameraPosition", cameraPosition);
-                material->Set("u_PointLights", s_Data.sceneData.sceneLights);
-                material->Set("u_PointLightCount", lightCount);
+                const Submesh &submesh = dc.Mesh->m_Submeshes[j];
+                uint32_t boundsIndex = culler.Add(submesh.BoundingBox, dc.Transform * submesh.Transform);
+                s_Data.DrawItems.push_back({0, i, j, boundsIndex, 0});
             }
-            Renderer::SubmitMesh(dc.Mesh, dc.Transform, overrideMaterial);
         }
-        s_Data.GridMaterial->Set("u_ViewProjection", viewProjection);
+        culler.Cull(frustum, s_Data.Visibility);
+
+        // Give every visible submesh its level of detail, from the projected size of its bounding sphere, and
+        // its sort key. Every submesh and level sorts apart so their draws can be instanced
+        const glm::mat4 &viewMatrix = sceneCamera.ViewMatrix;
+        auto &lodSelector = s_Data.DrawLodSelector;
+        lodSelector.SetProjection(sceneCamera.Camera.GetProjectionMatrix(), s_Data.ViewportHeight);
+        lodSelector.NextFrame();
+        SortIDMap shaderIDs, materialIDs, submeshIDs;
+        uint32_t visibleCount = 0;
+        for (uint32_t i = 0; i < s_Data.DrawItems.size(); i++)
+        {
+            if (!s_Data.Visibility[i])
+                continue;
+
+            auto item = s_Data.DrawItems[i];
+            auto &dc = s_Data.DrawList[item.DrawCommandIndex];
+            const Submesh &submesh = dc.Mesh->m_Submeshes[item.SubmeshIndex];
+            Ref<Material> material = dc.Mesh->GetMaterials()[submesh.MaterialIndex];
+
+            float depth = -(viewMatrix * glm::vec4(culler.GetCenter(i), 1.0f)).z;
+            // Ids are random, so scattering the submesh index over all bits keeps the keys of an entity's submeshes apart
+            uint64_t drawID = dc.ID ? dc.ID : item.DrawCommandIndex;
+            uint64_t lodKey = drawID ^ item.SubmeshIndex * 0x9e3779b97f4a7c15ull;
+            item.Lod = lodSelector.Select(lodKey, dc.Mesh.Raw(), submesh, depth, glm::length(culler.GetExtents(i)), s_Data.Options.LodPixelError);
+
+            // Every material enables blending by default, so only an explicit Transparent flag moves it to the back to front queue
+            RenderQueue queue = material->GetFlag(MaterialFlag::Transparent) ? RenderQueue::Transparent : RenderQueue::Opaque;
+            uint64_t geometryID = submeshIDs.Get(&submesh) * Submesh::MaxLods + item.Lod;
+            item.SortKey = MakeSortKey(0, queue, shaderIDs.Get(material->GetVariant().Raw()), materialIDs.Get(material.Raw()), geometryID, depth);
+            s_Data.DrawItems[visibleCount++] = item;
+        }
+        s_Data.DrawItems.resize(visibleCount);
+
+        RadixSort64(s_Data.DrawItems, s_Data.DrawItemScratch, [](const SceneRendererData::DrawItem &item)
+                    { return item.SortKey; });
+
+        // Pick the lights of every draw from its world bounds, as one batch over the sorted draw list
+        bool perDrawLights = s_Data.Options.PointLightCulling == LightCulling::PerDraw;
+        if (perDrawLights)
+        {
+            s_Data.InstanceBounds.resize(s_Data.DrawItems.size());
+            for (uint32_t i = 0; i < s_Data.DrawItems.size(); i++)
+            {
+                uint32_t boundsIndex = s_Data.DrawItems[i].BoundsIndex;
+                glm::vec3 center = culler.GetCenter(boundsIndex);
+                glm::vec3 extents = culler.GetExtents(boundsIndex);
+                s_Data.InstanceBounds[i] = AABB(center - extents, center + extents);
+            }
+            s_Data.DrawLightSelector.SetLights(s_Data.sceneData.sceneLights);
+            s_Data.DrawLightSelector.Select(s_Data.InstanceBounds, s_Data.InstanceLights);
+        }
+
+        // Identical draws (same mesh, submesh and level of detail, hence same material) become one instanced indirect command.
+        // Instances are packed in sorted order, so a command's first item is also its base instance.
+        // Commands sharing a material and index format are then drawn together with one multi-draw call
+        s_Data.IndirectCommands.clear();
+        s_Data.DrawBatches.clear();
+        s_Data.Instances.resize(s_Data.DrawItems.size());
+        const SceneRendererData::DrawItem *lastItem = nullptr;
+        for (uint32_t i = 0; i < s_Data.DrawItems.size(); i++)
+        {
+            auto &item = s_Data.DrawItems[i];
+            auto &dc = s_Data.DrawList[item.DrawCommandIndex];
+            const Submesh &submesh = dc.Mesh->m_Submeshes[item.SubmeshIndex];
+            s_Data.Instances[i].Transform = dc.Transform * submesh.GetVertexTransform();
+            s_Data.Instances[i].Lights = perDrawLights ? s_Data.InstanceLights[i] : glm::uvec4(0xffffffff);
+
+            if (lastItem && lastItem->SubmeshIndex == item.SubmeshIndex && lastItem->Lod == item.Lod && s_Data.DrawList[lastItem->DrawCommandIndex].Mesh.Raw() == dc.Mesh.Raw())
+            {
+                s_Data.IndirectCommands.back().InstanceCount++;
+                lastItem = &item;
+                continue;
+            }
+            lastItem = &item;
+
+            const auto &allocation = dc.Mesh->GetGeometryAllocation();
+            SubmeshLod lod = submesh.GetLod(item.Lod);
+            DrawElementsIndirectCommand command;
+            command.Count = lod.IndexCount;
+            command.InstanceCount = 1;
+            command.FirstIndex = allocation.BaseIndex + lod.BaseIndex;
+            command.BaseVertex = (int32_t)(allocation.BaseVertex + submesh.BaseVertex);
+            command.BaseInstance = i;
+            s_Data.IndirectCommands.push_back(command);
+
+            const Ref<Material> &material = dc.Mesh->GetMaterials()[submesh.MaterialIndex];
+            if (s_Data.DrawBatches.empty() || s_Data.DrawBatches.back().Material.Raw() != material.Raw() || s_Data.DrawBatches.back().Format != allocation.Format)
+            {
+                // Upload changed material blocks here so the recording threads only ever read the dirty flags
+                material->FlushUniforms();
+                s_Data.DrawBatches.push_back({material, (uint32_t)s_Data.IndirectCommands.size() - 1, 0, allocation.Format});
+            }
+            s_Data.DrawBatches.back().CommandCount++;
+        }
+
+        UploadFrameData(s_Data.InstanceBuffer, s_Data.Instances.data(), (uint32_t)(s_Data.Instances.size() * sizeof(MeshInstance)));
+        UploadFrameData(s_Data.IndirectBuffer, s_Data.IndirectCommands.data(), (uint32_t)(s_Data.IndirectCommands.size() * sizeof(DrawElementsIndirectCommand)));
+
+        // Every mesh lives in the geometry arena, so its vertex array is bound once for the whole pass
+        if (!s_Data.DrawBatches.empty())
+            Renderer::BindGeometryArena(s_Data.InstanceBuffer);
+
+        auto recordDrawBatches = [](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                auto &batch = s_Data.DrawBatches[i];
+                Renderer::SubmitMultiDrawIndirect(batch.Material, s_Data.IndirectBuffer, batch.FirstCommand, batch.CommandCount, batch.Format);
+            }
+        };
+
+        // Split the batches into contiguous chunks, record each into its own command list on a worker and
+        // stitch the lists back together in chunk order
+        auto &threadPool = ThreadPool::Get();
+        uint32_t drawCount = (uint32_t)s_Data.DrawBatches.size();
+        uint32_t chunkCount = std::min(threadPool.GetWorkerCount() + 1, (drawCount + s_DrawsPerCommandList - 1) / s_DrawsPerCommandList);
+        if (chunkCount <= 1)
+        {
+            recordDrawBatches(0, drawCount);
+        }
+        else
+        {
+            std::vector<RenderCommandQueue *> commandLists(chunkCount);
+            for (auto &commandList : commandLists)
+                commandList = &Renderer::CreateCommandList();
+
+            threadPool.ParallelFor(chunkCount, [&](uint32_t chunk)
+                                   {
+                                       JN_PROFILE_SCOPE("SceneRenderer::RecordDrawList");
+                                       Renderer::BeginCommandList(*commandLists[chunk]);
+                                       recordDrawBatches(chunk * drawCount / chunkCount, (chunk + 1) * drawCount / chunkCount);
+                                       Renderer::EndCommandList();
+                                   });
+
+            for (auto commandList : commandLists)
+                Renderer::SubmitCommandList(*commandList);
+        }
+        s_Data.GridMaterial->Set(s_GridViewProjectionID, viewProjection);
         Renderer::SubmitQuad(s_Data.GridMaterial, glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(16.0f)));
 
         //s_Data.GeoPass->GetSpecification().TargetFramebuffer->BindTexture();
@@ -137,17 +472,67 @@ namespace Janus
         Renderer::EndRenderPass();
     }
 
+    void SceneRenderer::LightingPass()
+    {
+        JN_PROFILE_FUNCTION();
+        // Bin the lights into the cluster grid so each pixel only shades the lights that can reach it. With
+        // per-draw lighting the geometry pass selects lights instead, and the grid is neither built nor uploaded
+        auto &sceneCamera = s_Data.sceneData.sceneCamera;
+        auto &sceneLights = s_Data.sceneData.sceneLights;
+        auto &lightGrid = s_Data.ClusterGrid;
+        bool clustered = s_Data.Options.PointLightCulling == LightCulling::Clustered;
+        lightGrid.SetProjection(sceneCamera.Camera.GetProjectionMatrix(), sceneCamera.Near, sceneCamera.Far);
+        if (clustered)
+            lightGrid.Build(sceneLights, sceneCamera.ViewMatrix);
+
+        s_Data.PointLights.resize(sceneLights.size());
+        for (size_t i = 0; i < sceneLights.size(); i++)
+        {
+            auto &light = s_Data.PointLights[i];
+            light.Position = sceneLights[i].Position;
+            light.Intensity = sceneLights[i].Intensity;
+            light.Radiance = sceneLights[i].Radiance;
+            light.Radius = sceneLights[i].Radius;
+            light.Falloff = sceneLights[i].Falloff;
+        }
+
+        UploadFrameData(s_Data.PointLightBuffer, s_Data.PointLights.data(), (uint32_t)(s_Data.PointLights.size() * sizeof(PointLightUniforms)));
+        if (clustered)
+        {
+            const auto &clusters = lightGrid.GetClusters();
+            const auto &lightIndices = lightGrid.GetLightIndices();
+            UploadFrameData(s_Data.LightGridBuffer, clusters.data(), (uint32_t)(clusters.size() * sizeof(LightGrid::Cluster)));
+            UploadFrameData(s_Data.LightIndexBuffer, lightIndices.data(), (uint32_t)(lightIndices.size() * sizeof(uint32_t)));
+        }
+
+        Ref<VertexBuffer> pointLightBuffer = s_Data.PointLightBuffer;
+        Ref<VertexBuffer> lightGridBuffer = s_Data.LightGridBuffer;
+        Ref<VertexBuffer> lightIndexBuffer = s_Data.LightIndexBuffer;
+        Renderer::Submit([pointLightBuffer, lightGridBuffer, lightIndexBuffer]()
+                         {
+                             RenderStateCache::BindStorageBuffer(s_PointLightBinding, pointLightBuffer->GetRendererID());
+                             RenderStateCache::BindStorageBuffer(s_LightGridBinding, lightGridBuffer->GetRendererID());
+                             RenderStateCache::BindStorageBuffer(s_LightIndexBinding, lightIndexBuffer->GetRendererID());
+                         });
+    }
+
     void SceneRenderer::CompositePass()
     {
     }
 
     void SceneRenderer::FlushDrawList()
     {
+        LightingPass();
         GeometryPass();
         s_Data.DrawList.clear();
         s_Data.sceneData = {};
     }
 
+    SceneRendererOptions &SceneRenderer::GetOptions()
+    {
+        return s_Data.Options;
+    }
+
     Ref<Framebuffer> SceneRenderer::GetFinalColorBuffer()
     {
         return s_Data.GeoPass->GetSpecification().TargetFramebuffer;
@@ -158,7 +543,6 @@ namespace Janus
         return s_Data.GeoPass->GetSpecification().TargetFramebuffer->GetColorAttachmentRendererID();
     }
 
-    static Ref<Shader> equirectangularConversionShader, envFilteringShader, envIrradianceShader;
     std::pair<Ref<TextureCube>, Ref<TextureCube>> SceneRenderer::CreateEnvironmentMap(const std::string &filepath)
     {
         const uint32_t cubemapSize = 2048;
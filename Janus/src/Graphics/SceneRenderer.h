@@ -9,10 +9,21 @@
 namespace Janus
 {
 
+	enum class LightCulling
+	{
+		// Lights are binned into a view space cluster grid and every fragment shades its cluster's lights
+		Clustered = 0,
+		// Every draw shades only its LightSelector::MaxLights most influential lights
+		PerDraw = 1
+	};
+
 	struct SceneRendererOptions
 	{
 		bool ShowGrid = true;
 		bool ShowBoundingBoxes = false;
+		LightCulling PointLightCulling = LightCulling::Clustered;
+		// Largest error, in pixels, of the mesh levels of detail drawn. Zero draws every mesh at full detail
+		float LodPixelError = 1.0f;
 	};
 
 	struct SceneRendererCamera
@@ -33,7 +44,9 @@ namespace Janus
 		static void BeginScene(const Scene *scene, const SceneRendererCamera &camera);
 		static void EndScene();
 
-		static void SubmitMesh(Ref<Mesh> mesh, const glm::mat4 &transform = glm::mat4(1.0f), Ref<Material> overrideMaterial = nullptr);
+		// id identifies the submitter from frame to frame, such as an entity's UUID, so per-draw state like the
+		// selected level of detail follows it. Meshes submitted without one are tracked by submission order
+		static void SubmitMesh(Ref<Mesh> mesh, const glm::mat4 &transform = glm::mat4(1.0f), Ref<Material> overrideMaterial = nullptr, uint64_t id = 0);
 
 		//static Ref<RenderPass> GetFinalRenderPass();
 		static Ref<Framebuffer> GetFinalColorBuffer();
@@ -45,11 +58,12 @@ namespace Janus
 
 		//static void SetFocusPoint(const glm::vec2& point);
 
-		//static SceneRendererOptions& GetOptions();
+		static SceneRendererOptions &GetOptions();
 
 		//static void OnImGuiRender();
 	private:
 		static void FlushDrawList();
+		static void LightingPass();
 		static void GeometryPass();
 		static void CompositePass();
 		//static void BloomBlurPass();
@@ -6,6 +6,11 @@
 
 #include "Graphics/Renderer.h"
 #include "Graphics/Shader.h"
+#include "Graphics/RenderStateCache.h"
+#include "Graphics/UniformBuffer.h"
+#include "Graphics/ShaderCache.h"
+#include "Core/FileWatcher.h"
+#include "Core/ThreadPool.h"
 
 
 GLenum glCheckError_(const char *file, int line)
@@ -48,36 +53,147 @@ namespace Janus
 		return false;
 	}
 
-	Shader::Shader(const std::string &filepath)
-		: m_AssetPath(filepath)
+	// Names defined in every shader; see AddGlobalDefine
+	static std::vector<std::string> s_GlobalDefines;
+
+	// Defines the global names and enabled keywords right after the #version line, which has to stay first
+	static void DefineKeywords(std::string &source, const std::vector<ShaderKeyword> &keywords, uint32_t keywordMask)
 	{
-		JN_PROFILE_FUNCTION();
+		std::string defines;
+		for (const auto &name : s_GlobalDefines)
+			defines += "#define " + name + "\n";
+		for (uint32_t i = 0; i < keywords.size(); i++)
+		{
+			if (keywordMask & (1u << i))
+				defines += "#define " + keywords[i].Name + "\n";
+		}
+		if (defines.empty())
+			return;
 
+		size_t version = source.find("#version");
+		size_t insert = version != std::string::npos ? source.find('\n', version) : std::string::npos;
+		if (insert == std::string::npos)
+			source.insert(0, defines);
+		else
+			source.insert(insert + 1, defines);
+	}
+
+	// Shaders loaded from a file, which the hot reloader checks against changed files. Variants and reload
+	// replacements are not listed; they belong to a listed shader. The last ref to a shader is often released
+	// on the render thread, so the set is guarded by a mutex
+	static std::unordered_set<Shader *> s_LoadedShaders;
+	static std::mutex s_LoadedShadersMutex;
+
+	static std::string GetShaderName(const std::string &filepath)
+	{
 		size_t found = filepath.find_last_of("/\\");
-		m_Name = found != std::string::npos ? filepath.substr(found + 1) : filepath;
-		found = m_Name.find_last_of(".");
-		m_Name = found != std::string::npos ? m_Name.substr(0, found) : m_Name;
-		
+		std::string name = found != std::string::npos ? filepath.substr(found + 1) : filepath;
+		found = name.find_last_of(".");
+		return found != std::string::npos ? name.substr(0, found) : name;
+	}
+
+	Shader::Shader(const std::string &filepath, uint32_t keywordMask, bool compile)
+		: m_Name(GetShaderName(filepath)), m_AssetPath(filepath), m_KeywordMask(keywordMask)
+	{
+		JN_PROFILE_FUNCTION();
+
 		std::string source = ReadShaderFromFile(filepath);
 		m_ShaderSource = PreProcess(source);
 
 		if (!m_IsCompute)
 			Parse();
 
+		if (!compile)
+			return;
+
+		if (m_KeywordMask == 0)
+		{
+			std::lock_guard<std::mutex> lock(s_LoadedShadersMutex);
+			s_LoadedShaders.insert(this);
+			m_Listed = true;
+		}
+		Compile();
+	}
+
+	Shader::Shader(const std::string &filepath, uint32_t keywordMask, DeferredLoad)
+		: m_Name(GetShaderName(filepath)), m_AssetPath(filepath), m_KeywordMask(keywordMask)
+	{
+	}
+
+	void Shader::Compile()
+	{
 		Renderer::Submit([=]()
 						 {
 							 if (m_RendererID)
-								 glDeleteProgram(m_RendererID);
-							 CompileAndUploadShader();
-							 if (!m_IsCompute)
 							 {
-								 ResolveUniforms();
-								 ValidateUniforms();
+								 glDeleteProgram(m_RendererID);
+								 RenderStateCache::OnProgramDeleted(m_RendererID);
 							 }
-							 m_Loaded = true;
+							 BeginCompile();
 						 });
 	}
 
+	std::vector<Ref<Shader>> Shader::GetLoadedShaders()
+	{
+		std::lock_guard<std::mutex> lock(s_LoadedShadersMutex);
+		std::vector<Ref<Shader>> shaders;
+		shaders.reserve(s_LoadedShaders.size());
+		for (Shader *shader : s_LoadedShaders)
+		{
+			// Skips shaders whose destructor is waiting to unlist them
+			if (!shader->TryIncRefCount())
+				continue;
+			shaders.emplace_back(shader);
+			shader->DecRefCount();
+		}
+		return shaders;
+	}
+
+	bool Shader::DependsOn(const std::string &path) const
+	{
+		return std::find(m_Dependencies.begin(), m_Dependencies.end(), path) != m_Dependencies.end();
+	}
+
+	std::vector<Ref<Shader>> Shader::GetVariants()
+	{
+		std::lock_guard<std::mutex> lock(m_VariantMutex);
+		std::vector<Ref<Shader>> variants;
+		for (auto &kv : m_Variants)
+		{
+			if (kv.second->IsReady())
+				variants.push_back(kv.second);
+		}
+		return variants;
+	}
+
+	void Shader::SwapProgram(Shader &other)
+	{
+		JN_ASSERT(!m_Compiling && !other.m_Compiling, "SHADER_ERROR: Cannot swap a program that is still compiling!");
+		std::swap(m_RendererID, other.m_RendererID);
+		std::swap(m_ShaderSource, other.m_ShaderSource);
+		std::swap(m_IsCompute, other.m_IsCompute);
+		std::swap(m_CacheKey, other.m_CacheKey);
+		std::swap(m_VSRendererUniformBuffers, other.m_VSRendererUniformBuffers);
+		std::swap(m_PSRendererUniformBuffers, other.m_PSRendererUniformBuffers);
+		std::swap(m_VSMaterialUniformBuffer, other.m_VSMaterialUniformBuffer);
+		std::swap(m_PSMaterialUniformBuffer, other.m_PSMaterialUniformBuffer);
+		std::swap(m_Resources, other.m_Resources);
+		std::swap(m_UniformBlocks, other.m_UniformBlocks);
+		std::swap(m_MaterialUniformCount, other.m_MaterialUniformCount);
+		std::swap(m_MaterialUniformTable, other.m_MaterialUniformTable);
+		std::swap(m_Reflection, other.m_Reflection);
+		std::swap(m_MissingUniforms, other.m_MissingUniforms);
+		std::swap(m_Structs, other.m_Structs);
+		std::swap(m_Keywords, other.m_Keywords);
+		std::swap(m_Dependencies, other.m_Dependencies);
+		bool compileFailed = m_CompileFailed;
+		m_CompileFailed = other.m_CompileFailed.load();
+		other.m_CompileFailed = compileFailed;
+		// Neither program holds any material's values for the other's layout
+		m_MaterialGeneration = 0;
+		other.m_MaterialGeneration = 0;
+	}
+
 	bool StartsWith(const std::string &string, const std::string &start)
 	{
 		return string.find(start) == 0;
@@ -160,6 +276,31 @@ namespace Janus
 		return std::string(str, length);
 	}
 
+	// A uniform statement opens a block if a '{' comes before its ';'
+	static bool IsUniformBlock(const char *token)
+	{
+		const char *end = strpbrk(token, ";{");
+		return end && *end == '{';
+	}
+
+	// Reads N from a "layout(..., binding = N)" qualifier preceding the token on the same line, or -1
+	static int32_t GetLayoutBinding(const char *source, const char *token)
+	{
+		const char *lineStart = token;
+		while (lineStart != source && lineStart[-1] != '\n')
+			lineStart--;
+
+		std::string qualifier(lineStart, token - lineStart);
+		size_t binding = qualifier.find("binding");
+		if (binding == std::string::npos)
+			return -1;
+
+		size_t equals = qualifier.find('=', binding);
+		if (equals == std::string::npos)
+			return -1;
+		return atoi(qualifier.c_str() + equals + 1);
+	}
+
 	std::string Shader::ReadShaderFromFile(const std::string &filepath) const
 	{
 		JN_PROFILE_FUNCTION();
@@ -193,6 +334,7 @@ namespace Janus
 		m_Structs.clear();
 		m_VSMaterialUniformBuffer.Reset();
 		m_PSMaterialUniformBuffer.Reset();
+		m_UniformBlocks.clear();
 
 		auto &vertexSource = m_ShaderSource[GL_VERTEX_SHADER];
 		auto &fragmentSource = m_ShaderSource[GL_FRAGMENT_SHADER];
@@ -202,7 +344,12 @@ namespace Janus
 			ParseUniformStruct(GetBlock(token, &vstr), ShaderDomain::Vertex);
 		vstr = vertexSource.c_str();
 		while (token = FindToken(vstr, "uniform"))
-			ParseUniform(GetStatement(token, &vstr), ShaderDomain::Vertex);
+		{
+			if (IsUniformBlock(token))
+				ParseUniformBlock(GetBlock(token, &vstr), GetLayoutBinding(vertexSource.c_str(), token), ShaderDomain::Vertex);
+			else
+				ParseUniform(GetStatement(token, &vstr), ShaderDomain::Vertex);
+		}
 
 		fstr = fragmentSource.c_str();
 		while (token = FindToken(fstr, "struct"))
@@ -210,7 +357,66 @@ namespace Janus
 
 		fstr = fragmentSource.c_str();
 		while (token = FindToken(fstr, "uniform"))
-			ParseUniform(GetStatement(token, &fstr), ShaderDomain::Pixel);
+		{
+			if (IsUniformBlock(token))
+				ParseUniformBlock(GetBlock(token, &fstr), GetLayoutBinding(fragmentSource.c_str(), token), ShaderDomain::Pixel);
+			else
+				ParseUniform(GetStatement(token, &fstr), ShaderDomain::Pixel);
+		}
+
+		// Texture units are handed out here rather than when the program links, so materials can place
+		// their textures while the program is still compiling
+		uint32_t sampler = 0;
+		for (ShaderResourceDeclaration *resource : m_Resources)
+		{
+			resource->m_Register = sampler;
+			sampler += std::max(resource->GetCount(), 1u);
+		}
+
+		AssignMaterialUniformIndices();
+		ResolveKeywords();
+	}
+
+	void Shader::AssignMaterialUniformIndices()
+	{
+		m_MaterialUniformCount = 0;
+		m_MaterialUniformTable.clear();
+		auto assign = [this](const ShaderUniformBufferDeclaration &decl)
+		{
+			for (ShaderUniformDeclaration *uniform : decl.GetUniformDeclarations())
+			{
+				uniform->m_MaterialIndex = (int32_t)m_MaterialUniformCount++;
+				m_MaterialUniformTable.push_back({UniformID(uniform->GetName()), uniform});
+			}
+		};
+
+		if (m_VSMaterialUniformBuffer)
+			assign(*m_VSMaterialUniformBuffer);
+		if (m_PSMaterialUniformBuffer)
+			assign(*m_PSMaterialUniformBuffer);
+		for (auto &uniformBlock : m_UniformBlocks)
+		{
+			if (!IsRendererUniformBlock(*uniformBlock))
+				assign(*uniformBlock);
+		}
+
+		JN_ASSERT(m_MaterialUniformCount <= MaxMaterialUniforms, "SHADER_ERROR: Too many material uniforms!");
+
+		std::sort(m_MaterialUniformTable.begin(), m_MaterialUniformTable.end(), [](const auto &a, const auto &b)
+				  { return a.first < b.first; });
+		for (size_t i = 1; i < m_MaterialUniformTable.size(); i++)
+		{
+			JN_ASSERT(m_MaterialUniformTable[i - 1].first != m_MaterialUniformTable[i].first, "SHADER_ERROR: Uniform name hash collision!");
+		}
+	}
+
+	ShaderUniformDeclaration *Shader::FindMaterialUniform(UniformID id) const
+	{
+		auto it = std::lower_bound(m_MaterialUniformTable.begin(), m_MaterialUniformTable.end(), id, [](const auto &entry, UniformID id)
+								   { return entry.first < id; });
+		if (it == m_MaterialUniformTable.end() || it->first != id)
+			return nullptr;
+		return it->second;
 	}
 
 	ShaderStruct *Shader::FindStruct(const std::string &name)
@@ -331,10 +537,76 @@ namespace Janus
 		m_Structs.push_back(uniformStruct);
 	}
 
+	void Shader::ParseUniformBlock(const std::string &block, int32_t binding, ShaderDomain domain)
+	{
+		JN_PROFILE_FUNCTION();
+		size_t open = block.find('{');
+		std::vector<std::string> header = Tokenize(block.substr(0, open));
+		JN_ASSERT(header.size() >= 2, "SHADER_ERROR: Uniform block has no name!");
+		const std::string &name = header[1];
+
+		// Both stages may declare the same block
+		for (auto &uniformBlock : m_UniformBlocks)
+		{
+			if (uniformBlock->GetName() == name)
+				return;
+		}
+
+		// Blocks without an explicit binding take the first binding point that is still free
+		if (binding < 0)
+		{
+			binding = UniformBuffer::FirstMaterialBinding;
+			for (auto &uniformBlock : m_UniformBlocks)
+				binding = std::max(binding, (int32_t)uniformBlock->GetRegister() + 1);
+		}
+
+		Ref<ShaderUniformBufferDeclaration> uniformBlock = Ref<ShaderUniformBufferDeclaration>::Create(name, domain);
+		uniformBlock->m_Register = (uint32_t)binding;
+		int32_t blockIndex = (int32_t)m_UniformBlocks.size();
+
+		std::vector<std::string> members = SplitString(block.substr(open + 1, block.find('}') - open - 1), ";");
+		for (auto &member : members)
+		{
+			std::vector<std::string> tokens = Tokenize(member);
+			if (tokens.size() < 2)
+				continue;
+
+			std::string typeString = tokens[0];
+			std::string memberName = tokens[1];
+			uint32_t count = 1;
+			const char *namestr = memberName.c_str();
+			if (const char *s = strstr(namestr, "["))
+			{
+				const char *end = strstr(namestr, "]");
+				count = atoi(std::string(s + 1, end - s).c_str());
+				memberName = std::string(namestr, s - namestr);
+			}
+
+			ShaderUniformDeclaration *declaration = nullptr;
+			ShaderUniformDeclaration::Type t = ShaderUniformDeclaration::StringToType(typeString);
+			if (t == ShaderUniformDeclaration::Type::NONE)
+			{
+				ShaderStruct *s = FindStruct(typeString);
+				JN_ASSERT(s, "SHADER_ERROR: Unknown uniform datatype!");
+				declaration = new ShaderUniformDeclaration(domain, s, memberName, count);
+			}
+			else
+			{
+				declaration = new ShaderUniformDeclaration(domain, t, memberName, count);
+			}
+			declaration->m_BlockIndex = blockIndex;
+			uniformBlock->PushUniformStd140(declaration);
+		}
+
+		// A block's size is padded to a multiple of a vec4
+		uniformBlock->m_Size = (uniformBlock->m_Size + 15) / 16 * 16;
+		m_UniformBlocks.push_back(uniformBlock);
+	}
+
 	void Shader::ResolveUniforms()
 	{
 		JN_PROFILE_FUNCTION();
-		glUseProgram(m_RendererID);
+		RenderStateCache::UseProgram(m_RendererID);
 		/*
 		for (size_t i = 0; i < m_VSRendererUniformBuffers.size(); i++)
 		{
@@ -384,94 +656,97 @@ namespace Janus
 		}
 		
 		*/
+		auto resolve = [this](const Ref<ShaderUniformBufferDeclaration> &decl)
 		{
-			const auto &decl = m_VSMaterialUniformBuffer;
-			if (decl)
+			if (!decl)
+				return;
+
+			for (ShaderUniformDeclaration *uniform : decl->GetUniformDeclarations())
 			{
-				const ShaderUniformList &uniforms = decl->GetUniformDeclarations();
-				for (size_t j = 0; j < uniforms.size(); j++)
+				UniformID id(uniform->m_Name);
+				if (uniform->GetType() == ShaderUniformDeclaration::Type::STRUCT)
 				{
-					ShaderUniformDeclaration *uniform = uniforms[j];
-					if (uniform->GetType() == ShaderUniformDeclaration::Type::STRUCT)
-					{
-						const ShaderStruct &s = uniform->GetShaderUniformStruct();
-						const auto &fields = s.GetFields();
-						for (size_t k = 0; k < fields.size(); k++)
-						{
-							ShaderUniformDeclaration *field = fields[k];
-							if(!uniform->IsArray())
-								field->m_Location = GetUniformLocation(uniform->m_Name + "." + field->m_Name);
-						}
-					}
-					else
-					{
-						uniform->m_Location = GetUniformLocation(uniform->m_Name);
-					}
-				}
-			}
-		}
+					// Elements of struct arrays are looked up by id as they are uploaded
+					if (uniform->IsArray())
+						continue;
 
-		{
-			const auto &decl = m_PSMaterialUniformBuffer;
-			if (decl)
-			{
-				const ShaderUniformList &uniforms = decl->GetUniformDeclarations();
-				for (size_t j = 0; j < uniforms.size(); j++)
+					for (ShaderUniformDeclaration *field : uniform->GetShaderUniformStruct().GetFields())
+						field->m_Location = GetUniformLocation(id.Append(".").Append(field->m_Name));
+				}
+				else
 				{
-					ShaderUniformDeclaration *uniform = uniforms[j];
-					if (uniform->GetType() == ShaderUniformDeclaration::Type::STRUCT)
-					{
-						const ShaderStruct &s = uniform->GetShaderUniformStruct();
-						const auto &fields = s.GetFields();
-						for (size_t k = 0; k < fields.size(); k++)
-						{
-							ShaderUniformDeclaration *field = fields[k];
-							if(!uniform->IsArray())
-								field->m_Location = GetUniformLocation(uniform->m_Name + "." + field->m_Name);
-						}
-					}
-					else
-					{
-						uniform->m_Location = GetUniformLocation(uniform->m_Name);
-					}
+					uniform->m_Location = GetUniformLocation(id, &uniform->m_Name);
 				}
 			}
+		};
+		resolve(m_VSMaterialUniformBuffer);
+		resolve(m_PSMaterialUniformBuffer);
+
+		// Explicit layout bindings already do this, but older GLSL versions cannot declare them
+		for (auto &uniformBlock : m_UniformBlocks)
+		{
+			const ShaderReflection::UniformBlock *block = m_Reflection.FindUniformBlock(UniformID(uniformBlock->GetName()));
+			if (block && block->Binding != uniformBlock->GetRegister())
+				glUniformBlockBinding(m_RendererID, block->Index, uniformBlock->GetRegister());
 		}
-		
-		uint32_t sampler = 0;
-		for (size_t i = 0; i < m_Resources.size(); i++)
+
+		for (ShaderResourceDeclaration *resource : m_Resources)
 		{
-			ShaderResourceDeclaration *resource = m_Resources[i];
-			int32_t location = GetUniformLocation(resource->m_Name);
+			int32_t location = GetUniformLocation(UniformID(resource->m_Name), &resource->m_Name);
+			if (location == -1)
+				continue;
 
+			uint32_t sampler = resource->GetRegister();
 			if (resource->GetCount() == 1)
 			{
-				resource->m_Register = sampler;
-				if (location != -1)
-					UploadUniformInt(location, sampler);
-
-				sampler++;
+				UploadUniformInt(location, sampler);
 			}
 			else if (resource->GetCount() > 1)
 			{
-				resource->m_Register = sampler;
 				uint32_t count = resource->GetCount();
 				int *samplers = new int[count];
 				for (uint32_t s = 0; s < count; s++)
 					samplers[s] = sampler++;
-				UploadUniformIntArray(resource->GetName(), samplers, count);
+				UploadUniformIntArray(location, samplers, count);
 				delete[] samplers;
 			}
 		}
 	}
 
-	void Shader::CompileAndUploadShader()
+	static bool SupportsParallelCompile()
 	{
-		JN_PROFILE_FUNCTION();
-		// CODE COPIED FROM OPENGL WIKI
-		std::vector<GLuint> shaderRendererIDs;
+		return GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+	}
+
+	// Render thread only. Shaders whose programs are still being compiled by the driver
+	static std::vector<Ref<Shader>> s_PendingShaders;
+
+	// Variants parsed on the thread pool, waiting for the render thread to move the parsed state into the
+	// variant handed out by GetVariant and start its program
+	struct ParsedVariant
+	{
+		Ref<Shader> Variant;
+		Ref<Shader> Parsed;
+	};
+	static std::vector<ParsedVariant> s_ParsedVariants;
+	static std::mutex s_ParsedVariantsMutex;
 
+	void Shader::BeginCompile()
+	{
+		JN_PROFILE_FUNCTION();
+		m_Loaded = false;
+		m_CompileFailed = false;
 		GLuint program = glCreateProgram();
+		m_CacheKey = ShaderCache::ComputeKey(m_ShaderSource);
+		if (ShaderCache::LoadProgram(m_CacheKey, program, m_Reflection))
+		{
+			m_RendererID = program;
+			OnCompiled();
+			return;
+		}
+
+		// Compile and link without querying any status, so the driver is free to finish the work on its
+		// own threads. Errors are collected in FinishCompile
 		for (auto &kv : m_ShaderSource)
 		{
 			GLenum type = kv.first;
@@ -479,31 +754,60 @@ namespace Janus
 			GLuint shaderRendererID = glCreateShader(type);
 			const GLchar *sourceCstr = (const GLchar *)source.c_str();
 			glShaderSource(shaderRendererID, 1, &sourceCstr, 0);
-
 			glCompileShader(shaderRendererID);
 
+			m_CompilingShaders.push_back(shaderRendererID);
+			glAttachShader(program, shaderRendererID);
+		}
+		ShaderCache::PrepareProgram(program);
+		glLinkProgram(program);
+
+		m_RendererID = program;
+		m_Compiling = true;
+		s_PendingShaders.push_back(this);
+	}
+
+	bool Shader::PollCompile()
+	{
+		if (!m_Compiling)
+			return true;
+
+		if (SupportsParallelCompile())
+		{
+			GLint completed = GL_FALSE;
+			glGetProgramiv(m_RendererID, GL_COMPLETION_STATUS_KHR, &completed);
+			if (completed == GL_FALSE)
+				return false;
+		}
+		FinishCompile();
+		return true;
+	}
+
+	void Shader::FinishCompile()
+	{
+		JN_PROFILE_FUNCTION();
+		if (!m_Compiling)
+			return;
+		m_Compiling = false;
+
+		// CODE COPIED FROM OPENGL WIKI
+		GLuint program = m_RendererID;
+		for (auto id : m_CompilingShaders)
+		{
 			GLint isCompiled = 0;
-			glGetShaderiv(shaderRendererID, GL_COMPILE_STATUS, &isCompiled);
+			glGetShaderiv(id, GL_COMPILE_STATUS, &isCompiled);
 			if (isCompiled == GL_FALSE)
 			{
 				GLint maxLength = 0;
-				glGetShaderiv(shaderRendererID, GL_INFO_LOG_LENGTH, &maxLength);
+				glGetShaderiv(id, GL_INFO_LOG_LENGTH, &maxLength);
 
 				// The maxLength includes the NULL character
 				std::vector<GLchar> infoLog(maxLength);
-				glGetShaderInfoLog(shaderRendererID, maxLength, &maxLength, &infoLog[0]);
-
-				std::cout << "ERROR::SHADER::SHADER COMPILATION FAILED" << &infoLog[0] << std::endl;
+				glGetShaderInfoLog(id, maxLength, &maxLength, &infoLog[0]);
 
-				// We don't need the shader anymore.
-				glDeleteShader(shaderRendererID);
+				JN_CORE_ERROR("SHADER_ERROR: Failed to compile a stage of {0}: {1}", m_Name, infoLog.data());
 			}
-
-			shaderRendererIDs.push_back(shaderRendererID);
-			glAttachShader(program, shaderRendererID);
 		}
-		// Link our program
-		glLinkProgram(program);
 
 		// Note the different functions here: glGetProgram* instead of glGetShader*.
 		GLint isLinked = 0;
@@ -516,53 +820,145 @@ namespace Janus
 			// The maxLength includes the NULL character
 			std::vector<GLchar> infoLog(maxLength);
 			glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
-			std::cout << "ERROR::SHADER::SHADER LINKING FAIL" << m_Name << std::endl;
+			JN_CORE_ERROR("SHADER_ERROR: Failed to link {0}: {1}", m_Name, infoLog.data());
+			m_CompileFailed = true;
 			glCheckError();
+			m_Reflection = ShaderReflection();
+		}
+		else
+		{
+			m_Reflection = ShaderReflection::Reflect(program);
+			ShaderCache::SaveProgram(m_CacheKey, program, m_Reflection);
+		}
 
-			GLint pSize = 0;
-			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &pSize);
-
-			GLchar *plog = new GLchar[pSize];
-			for(int i = 0; i < pSize; i++) {
-				plog[i] = 0;
-			}
-			glGetProgramInfoLog(program, pSize, NULL, plog);
-			std::cout << plog;
+		// Shaders are flagged for deletion and freed with the program
+		for (auto id : m_CompilingShaders)
+		{
+			glDetachShader(program, id);
+			glDeleteShader(id);
+		}
+		m_CompilingShaders.clear();
 
-			// We don't need the program anymore.
+		// A program that failed to link can't be made current, so it is dropped rather than left for
+		// RenderStateCache to record as bound. The shader still becomes ready so materials see the errors
+		// and draw with the fallback shader
+		if (m_CompileFailed)
+		{
 			glDeleteProgram(program);
-			// Don't leak shaders either.
-			for (auto id : shaderRendererIDs)
-				glDeleteShader(id);
+			m_RendererID = 0;
 		}
+		OnCompiled();
+	}
 
-		// Always detach shaders after a successful link.
-		for (auto id : shaderRendererIDs)
-			glDetachShader(program, id);
+	void Shader::OnCompiled()
+	{
+		m_MaterialGeneration = 0;
+		m_MissingUniforms.clear();
+		if (!m_IsCompute && !m_CompileFailed)
+		{
+			ResolveUniforms();
+			ValidateUniforms();
+		}
+		m_Loaded = true;
+	}
 
-		m_RendererID = program;
+	void Shader::PollPendingCompiles()
+	{
+		JN_PROFILE_FUNCTION();
+		std::vector<ParsedVariant> parsedVariants;
+		{
+			std::lock_guard<std::mutex> lock(s_ParsedVariantsMutex);
+			parsedVariants.swap(s_ParsedVariants);
+		}
+		// Until it is ready nothing uses the variant's parsed state, so it can be swapped in here
+		for (auto &parsed : parsedVariants)
+		{
+			parsed.Variant->SwapProgram(*parsed.Parsed);
+			parsed.Variant->BeginCompile();
+		}
+
+		auto it = std::remove_if(s_PendingShaders.begin(), s_PendingShaders.end(), [](const Ref<Shader> &shader)
+								 { return shader->PollCompile(); });
+		s_PendingShaders.erase(it, s_PendingShaders.end());
 	}
 
-	void Shader::ValidateUniforms()
+	void Shader::EnableParallelCompile()
 	{
+		if (!SupportsParallelCompile())
+		{
+			JN_CORE_INFO("SHADER_MSG: Parallel shader compilation is not supported, shaders compile on first poll");
+			return;
+		}
+
+		// Let the driver pick how many compiler threads to use
+		if (GLAD_GL_KHR_parallel_shader_compile)
+			glMaxShaderCompilerThreadsKHR(0xffffffff);
+		else
+			glMaxShaderCompilerThreadsARB(0xffffffff);
 	}
 
-	void Shader::SetVSMaterialUniformBuffer(Buffer buffer)
+	void Shader::AddGlobalDefine(const std::string &name)
 	{
-		Renderer::Submit([this, buffer]()
-						 {
-							 glUseProgram(m_RendererID);
-							 ResolveAndSetUniforms(m_VSMaterialUniformBuffer, buffer);
-						 });
+		if (std::find(s_GlobalDefines.begin(), s_GlobalDefines.end(), name) == s_GlobalDefines.end())
+			s_GlobalDefines.push_back(name);
 	}
 
-	void Shader::SetPSMaterialUniformBuffer(Buffer buffer)
+	void Shader::ValidateUniforms()
 	{
-		Renderer::Submit([this, buffer]()
-						 {
-							 glUseProgram(m_RendererID);
-							 ResolveAndSetUniforms(m_PSMaterialUniformBuffer, buffer);
-						 });
+		// Materials size and fill block storage with the parsed std140 layout, so any disagreement with the
+		// driver means their values land in the wrong place
+		for (auto &uniformBlock : m_UniformBlocks)
+		{
+			UniformID blockID(uniformBlock->GetName());
+			const ShaderReflection::UniformBlock *block = m_Reflection.FindUniformBlock(blockID);
+			if (!block)
+				continue;
+
+			if (block->Size != uniformBlock->GetSize())
+				JN_CORE_ERROR("SHADER_ERROR: Block {0} of {1} is {2} bytes, but was parsed as {3}", uniformBlock->GetName(), m_Name, block->Size, uniformBlock->GetSize());
+
+			for (ShaderUniformDeclaration *member : uniformBlock->GetUniformDeclarations())
+			{
+				// A struct member is checked through its first field, which shares its offset
+				UniformID id(member->m_Name);
+				if (member->GetType() == ShaderUniformDeclaration::Type::STRUCT)
+				{
+					const auto &fields = member->GetShaderUniformStruct().GetFields();
+					if (fields.empty())
+						continue;
+					id = (member->IsArray() ? id.AppendIndex(0) : id).Append(".").Append(fields[0]->m_Name);
+				}
+
+				// Members the compiler removed are not reported
+				const ShaderReflection::Uniform *uniform = m_Reflection.FindUniform(id);
+				if (uniform && uniform->Offset != (int32_t)member->GetOffset())
+					JN_CORE_ERROR("SHADER_ERROR: {0} in block {1} of {2} is at offset {3}, but was parsed at {4}", member->m_Name, uniformBlock->GetName(), m_Name, uniform->Offset, member->GetOffset());
+			}
+		}
+	}
+
+	void Shader::UploadMaterialUniforms(Buffer vsStorage, Buffer psStorage, const ShaderUniformMask &mask)
+	{
+		RenderStateCache::UseProgram(m_RendererID);
+		auto upload = [&mask, this](const Ref<ShaderUniformBufferDeclaration> &decl, Buffer storage)
+		{
+			if (!decl || !storage)
+				return;
+
+			for (ShaderUniformDeclaration *uniform : decl->GetUniformDeclarations())
+			{
+				if (!mask.test(uniform->GetMaterialIndex()))
+					continue;
+
+				if (uniform->IsArray())
+					ResolveAndSetUniformArray(uniform, storage);
+				else
+					ResolveAndSetUniform(uniform, storage);
+			}
+		};
+
+		upload(m_VSMaterialUniformBuffer, vsStorage);
+		upload(m_PSMaterialUniformBuffer, psStorage);
 	}
 
 	GLenum Shader::ShaderTypeFromString(const std::string &type)
@@ -604,17 +1000,190 @@ namespace Janus
 				break;
 			}
 		}
+
+		// Stages are visited in a fixed order so every variant numbers the keywords the same way
+		static const GLenum stages[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_COMPUTE_SHADER};
+		std::filesystem::path directory = std::filesystem::path(m_AssetPath).parent_path();
+		m_Keywords.clear();
+		m_Dependencies.clear();
+		m_Dependencies.push_back(FileWatcher::NormalizePath(m_AssetPath));
+		for (GLenum stage : stages)
+		{
+			auto it = shaderSources.find(stage);
+			if (it == shaderSources.end())
+				continue;
+
+			std::unordered_set<std::string> included;
+			it->second = ExpandIncludes(it->second, directory, included);
+			ParseKeywords(it->second);
+			for (const auto &include : included)
+			{
+				std::string dependency = FileWatcher::NormalizePath(include);
+				if (!DependsOn(dependency))
+					m_Dependencies.push_back(dependency);
+			}
+		}
+		for (auto &kv : shaderSources)
+			DefineKeywords(kv.second, m_Keywords, m_KeywordMask);
+
 		return shaderSources;
 	}
 
-	int32_t Shader::GetUniformLocation(const std::string &name) const
+	std::string Shader::ExpandIncludes(const std::string &source, const std::filesystem::path &directory, std::unordered_set<std::string> &included) const
 	{
-		int32_t result = glGetUniformLocation(m_RendererID, name.c_str());
-		if (result == -1)
-			JN_CORE_WARN("Could not find uniform {0} in shader", name);
+		const std::string includeToken = "#include";
+		std::string result;
+		result.reserve(source.size());
+
+		size_t lineBegin = 0;
+		while (lineBegin < source.size())
+		{
+			size_t lineEnd = source.find('\n', lineBegin);
+			if (lineEnd == std::string::npos)
+				lineEnd = source.size();
+
+			std::string line = source.substr(lineBegin, lineEnd - lineBegin);
+			lineBegin = lineEnd + 1;
+
+			size_t first = line.find_first_not_of(" \t");
+			if (first == std::string::npos || line.compare(first, includeToken.size(), includeToken) != 0)
+			{
+				result += line;
+				result += '\n';
+				continue;
+			}
+
+			size_t open = line.find('"', first);
+			size_t close = open != std::string::npos ? line.find('"', open + 1) : std::string::npos;
+			if (close == std::string::npos)
+			{
+				JN_CORE_ERROR("SHADER_ERROR: Malformed include in {0}: {1}", m_AssetPath, line);
+				result += '\n';
+				continue;
+			}
+
+			std::filesystem::path path = (directory / line.substr(open + 1, close - open - 1)).lexically_normal();
+			std::string key = path.generic_string();
+			if (included.insert(key).second)
+			{
+				std::string includeSource = ReadShaderFromFile(key);
+				if (includeSource.empty())
+					JN_CORE_ERROR("SHADER_ERROR: Could not include {0} in {1}", key, m_AssetPath);
+				result += ExpandIncludes(includeSource, path.parent_path(), included);
+			}
+			result += '\n';
+		}
 		return result;
 	}
 
+	void Shader::ParseKeywords(std::string &source)
+	{
+		const std::string keywordToken = "#pragma keyword";
+		size_t pos = source.find(keywordToken);
+		while (pos != std::string::npos)
+		{
+			size_t eol = source.find_first_of("\r\n", pos);
+			if (eol == std::string::npos)
+				eol = source.size();
+
+			std::vector<std::string> tokens = SplitString(source.substr(pos + keywordToken.size(), eol - pos - keywordToken.size()), " \t");
+			if (tokens.empty())
+			{
+				JN_CORE_ERROR("SHADER_ERROR: Keyword without a name in {0}", m_AssetPath);
+			}
+			else
+			{
+				auto existing = std::find_if(m_Keywords.begin(), m_Keywords.end(), [&](const ShaderKeyword &keyword)
+											 { return keyword.Name == tokens[0]; });
+				if (existing == m_Keywords.end())
+				{
+					JN_ASSERT(m_Keywords.size() < MaxShaderKeywords, "SHADER_ERROR: Too many keywords in " + m_AssetPath);
+					ShaderKeyword keyword;
+					keyword.Name = tokens[0];
+					keyword.Conditions.assign(tokens.begin() + 1, tokens.end());
+					m_Keywords.push_back(keyword);
+				}
+			}
+
+			// Blank the line rather than erase it so compiler errors keep their line numbers
+			source.replace(pos, eol - pos, "");
+			pos = source.find(keywordToken, pos);
+		}
+	}
+
+	void Shader::ResolveKeywords()
+	{
+		for (auto &keyword : m_Keywords)
+		{
+			keyword.Texture = nullptr;
+			keyword.Toggle = nullptr;
+			for (const auto &condition : keyword.Conditions)
+			{
+				auto resource = std::find_if(m_Resources.begin(), m_Resources.end(), [&](ShaderResourceDeclaration *resource)
+											 { return resource->GetName() == condition; });
+				if (resource != m_Resources.end())
+				{
+					keyword.Texture = *resource;
+					continue;
+				}
+
+				ShaderUniformDeclaration *uniform = FindMaterialUniform(UniformID(condition));
+				if (uniform && uniform->GetType() == ShaderUniformDeclaration::Type::FLOAT32)
+				{
+					keyword.Toggle = uniform;
+					continue;
+				}
+
+				JN_CORE_WARN("SHADER_MSG: Keyword {0} in {1} depends on {2}, which is not a texture or a float material uniform", keyword.Name, m_AssetPath, condition);
+			}
+		}
+	}
+
+	Ref<Shader> Shader::GetVariant(uint32_t keywordMask)
+	{
+		if (keywordMask == m_KeywordMask)
+			return this;
+
+		std::lock_guard<std::mutex> lock(m_VariantMutex);
+		auto it = m_Variants.find(keywordMask);
+		if (it != m_Variants.end())
+			return it->second;
+
+		// Reading and parsing the source would stall the caller, which is usually building the frame
+		JN_CORE_INFO("SHADER_MSG: Compiling variant {0:#x} of {1}", keywordMask, m_Name);
+		Ref<Shader> variant = new Shader(m_AssetPath, keywordMask, DeferredLoad());
+		m_Variants[keywordMask] = variant;
+		ThreadPool::Get().Enqueue([variant]()
+								  {
+									  JN_PROFILE_SCOPE("Shader::ParseVariant");
+									  Ref<Shader> parsed = Ref<Shader>::Create(variant->m_AssetPath, variant->m_KeywordMask, false);
+									  std::lock_guard<std::mutex> lock(s_ParsedVariantsMutex);
+									  s_ParsedVariants.push_back({variant, parsed});
+								  });
+		return variant;
+	}
+
+	int32_t Shader::GetUniformLocation(const std::string &name) const
+	{
+		return GetUniformLocation(UniformID(name), &name);
+	}
+
+	int32_t Shader::GetUniformLocation(UniformID id, const std::string *name) const
+	{
+		const ShaderReflection::Uniform *uniform = m_Reflection.FindUniform(id);
+		if (uniform)
+			return uniform->Location;
+
+		if (m_MissingUniforms.insert(id.GetHash()).second)
+		{
+			if (name)
+				JN_CORE_WARN("Could not find uniform {0} in shader {1}", *name, m_Name);
+			else
+				JN_CORE_WARN("Could not find uniform with id {0} in shader {1}", id.GetHash(), m_Name);
+		}
+		return -1;
+	}
+
 	void Shader::ResolveAndSetUniforms(const Ref<ShaderUniformBufferDeclaration> &decl, Buffer buffer)
 	{
 		const ShaderUniformList &uniforms = decl->GetUniformDeclarations();
@@ -779,19 +1348,41 @@ namespace Janus
 
 	Shader::~Shader()
 	{
-		glDeleteProgram(m_RendererID);
+		// Unlisted shaders may be released on the thread pool
+		if (m_Listed)
+		{
+			std::lock_guard<std::mutex> lock(s_LoadedShadersMutex);
+			s_LoadedShaders.erase(this);
+		}
+
+		// Reload replacements that were superseded before compiling never created a program
+		GLuint rendererID = m_RendererID;
+		if (!rendererID)
+			return;
+
+		Renderer::Submit([rendererID]()
+						 {
+							 glDeleteProgram(rendererID);
+							 RenderStateCache::OnProgramDeleted(rendererID);
+						 });
 	}
 
 	void Shader::Bind() const
 	{
 		Renderer::Submit([=]()
-						 { JN_PROFILE_FUNCTION(); glUseProgram(m_RendererID); });
+						 {
+							 JN_PROFILE_FUNCTION();
+							 // Direct binds (compute dispatches, fullscreen passes) can't fall back, so wait for the program
+							 if (m_Compiling)
+								 const_cast<Shader *>(this)->FinishCompile();
+							 RenderStateCache::UseProgram(m_RendererID);
+						 });
 	}
 
 	void Shader::Unbind() const
 	{
 		Renderer::Submit([=]()
-						 { glUseProgram(0); });
+						 { RenderStateCache::UseProgram(0); });
 	}
 
 	void Shader::SetFloat(const std::string &name, float value)
@@ -838,12 +1429,72 @@ namespace Janus
 		}
 		else
 		{
-			int location = glGetUniformLocation(m_RendererID, name.c_str());
+			int location = GetUniformLocation(name);
 			if (location != -1)
 				UploadUniformMat4(location, value);
 		}
 	}
 
+	void Shader::SetInt(UniformID id, int value)
+	{
+		Ref<Shader> instance = this;
+		Renderer::Submit([instance, id, value]()
+						 {
+							 RenderStateCache::UseProgram(instance->m_RendererID);
+							 int32_t location = instance->GetUniformLocation(id);
+							 if (location != -1)
+								 instance->UploadUniformInt(location, value);
+						 });
+	}
+
+	void Shader::SetFloat(UniformID id, float value)
+	{
+		Ref<Shader> instance = this;
+		Renderer::Submit([instance, id, value]()
+						 {
+							 RenderStateCache::UseProgram(instance->m_RendererID);
+							 int32_t location = instance->GetUniformLocation(id);
+							 if (location != -1)
+								 instance->UploadUniformFloat(location, value);
+						 });
+	}
+
+	void Shader::SetFloat2(UniformID id, const glm::vec2 &value)
+	{
+		Ref<Shader> instance = this;
+		Renderer::Submit([instance, id, value]()
+						 {
+							 RenderStateCache::UseProgram(instance->m_RendererID);
+							 int32_t location = instance->GetUniformLocation(id);
+							 if (location != -1)
+								 instance->UploadUniformFloat2(location, value);
+						 });
+	}
+
+	void Shader::SetFloat3(UniformID id, const glm::vec3 &value)
+	{
+		Ref<Shader> instance = this;
+		Renderer::Submit([instance, id, value]()
+						 {
+							 RenderStateCache::UseProgram(instance->m_RendererID);
+							 int32_t location = instance->GetUniformLocation(id);
+							 if (location != -1)
+								 instance->UploadUniformFloat3(location, value);
+						 });
+	}
+
+	void Shader::SetMat4(UniformID id, const glm::mat4 &value)
+	{
+		Ref<Shader> instance = this;
+		Renderer::Submit([instance, id, value]()
+						 {
+							 RenderStateCache::UseProgram(instance->m_RendererID);
+							 int32_t location = instance->GetUniformLocation(id);
+							 if (location != -1)
+								 instance->UploadUniformMat4(location, value);
+						 });
+	}
+
 	void Shader::SetIntArray(const std::string &name, int *values, uint32_t size)
 	{
 		Renderer::Submit([=]()
@@ -899,15 +1550,15 @@ namespace Janus
 	{
 		const ShaderStruct &s = uniform->GetShaderUniformStruct();
 		const auto &fields = s.GetFields();
+		UniformID id(uniform->m_Name);
 		for (size_t i = 0; i < uniform->GetCount(); i++) {
+			UniformID elementID = id.AppendIndex((uint32_t)i).Append(".");
 			for (size_t k = 0; k < fields.size(); k++)
 			{
 				ShaderUniformDeclaration *field = (ShaderUniformDeclaration *)fields[k];
 				uint32_t location = field->GetLocation();
-				if(uniform->IsArray()) {
-					const std::string name = uniform->m_Name + "[" + std::to_string(i) + "]." + field->m_Name;
-					location = GetUniformLocation(name);
-				}
+				if(uniform->IsArray())
+					location = GetUniformLocation(elementID.Append(field->m_Name));
 				UploadUniformField(location, *field, buffer, offset);
 				offset += field->m_Size;
 			}
@@ -928,51 +1579,41 @@ namespace Janus
 
 	void Shader::UploadUniformFloat(const std::string &name, float value)
 	{
-		glUseProgram(m_RendererID);
-		auto location = glGetUniformLocation(m_RendererID, name.c_str());
+		RenderStateCache::UseProgram(m_RendererID);
+		auto location = GetUniformLocation(name);
 		if (location != -1)
 			glUniform1f(location, value);
-		else
-			JN_CORE_WARN("Uniform '{0}' not found!", name);
 	}
 
 	void Shader::UploadUniformFloat2(const std::string &name, const glm::vec2 &values)
 	{
-		glUseProgram(m_RendererID);
-		auto location = glGetUniformLocation(m_RendererID, name.c_str());
+		RenderStateCache::UseProgram(m_RendererID);
+		auto location = GetUniformLocation(name);
 		if (location != -1)
 			glUniform2f(location, values.x, values.y);
-		else
-			JN_CORE_WARN("Uniform '{0}' not found!", name);
 	}
 
 	void Shader::UploadUniformFloat3(const std::string &name, const glm::vec3 &values)
 	{
-		glUseProgram(m_RendererID);
-		auto location = glGetUniformLocation(m_RendererID, name.c_str());
+		RenderStateCache::UseProgram(m_RendererID);
+		auto location = GetUniformLocation(name);
 		if (location != -1)
 			glUniform3f(location, values.x, values.y, values.z);
-		else
-			JN_CORE_WARN("Uniform '{0}' not found!", name);
 	}
 
 	void Shader::UploadUniformFloat4(const std::string &name, const glm::vec4 &values)
 	{
-		glUseProgram(m_RendererID);
-		auto location = glGetUniformLocation(m_RendererID, name.c_str());
+		RenderStateCache::UseProgram(m_RendererID);
+		auto location = GetUniformLocation(name);
 		if (location != -1)
 			glUniform4f(location, values.x, values.y, values.z, values.w);
-		else
-			JN_CORE_WARN("Uniform '{0}' not found!", name);
 	}
 
 	void Shader::UploadUniformMat4(const std::string &name, const glm::mat4 &values)
 	{
-		glUseProgram(m_RendererID);
-		auto location = glGetUniformLocation(m_RendererID, name.c_str());
+		RenderStateCache::UseProgram(m_RendererID);
+		auto location = GetUniformLocation(name);
 		if (location != -1)
 			glUniformMatrix4fv(location, 1, GL_FALSE, (const float *)&values);
-		else
-			JN_CORE_WARN("Uniform '{0}' not found!", name);
 	}
 }
\ No newline at end of file
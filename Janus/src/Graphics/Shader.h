@@ -2,6 +2,10 @@
 
 #include <string>
 #include <unordered_map>
+#include <filesystem>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
@@ -9,35 +13,104 @@
 #include "Core/Buffer.h"
 
 #include "Graphics/ShaderUniform.h"
+#include "Graphics/UniformID.h"
+#include "Graphics/ShaderReflection.h"
 
 
 namespace Janus
 {
+	static constexpr uint32_t MaxShaderKeywords = 32;
+
+	// Permutation keyword, declared in the source with "#pragma keyword NAME conditions...". Variants
+	// compiled with the keyword enabled see it #defined. A material enables it while every condition holds;
+	// a condition names either a texture it must have or a float toggle it must have set
+	struct ShaderKeyword
+	{
+		std::string Name;
+		std::vector<std::string> Conditions;
+		ShaderResourceDeclaration *Texture = nullptr;
+		ShaderUniformDeclaration *Toggle = nullptr;
+	};
+
 	class Shader : public RefCounted
 	{
 	public:
-		Shader(const std::string &filepath);
+		// The keyword mask selects which of the declared keywords this variant is compiled with. Without
+		// compile, only the source is read and parsed, which is safe on any thread; Compile starts the program
+		Shader(const std::string &filepath, uint32_t keywordMask = 0, bool compile = true);
 		~Shader();
 
+		void Compile();
+		// Set once the program is ready if it failed to compile or link
+		bool HasCompileErrors() const { return m_CompileFailed.load(std::memory_order_acquire); }
+
 		void Bind() const;
 		void Unbind() const;
 		uint32_t GetRendererID() const { return m_RendererID; }
-
-		void SetVSMaterialUniformBuffer(Buffer buffer);
-		void SetPSMaterialUniformBuffer(Buffer buffer);
+		// False while the driver is still compiling the program. Materials draw with the fallback shader until
+		// then, and for good if HasCompileErrors. Safe to call from any thread
+		bool IsReady() const { return m_Loaded.load(std::memory_order_acquire); }
+
+		// Render thread only. Finishes every program whose compile has completed, without blocking
+		static void PollPendingCompiles();
+		// Asks the driver to compile on background threads when KHR/ARB_parallel_shader_compile is present
+		static void EnableParallelCompile();
+		// Main thread only. Defines name in every shader loaded from now on, for engine-wide configuration
+		// such as the vertex format
+		static void AddGlobalDefine(const std::string &name);
+
+		// Render thread only. Uploads the loose material uniforms selected by mask from the given storage
+		void UploadMaterialUniforms(Buffer vsStorage, Buffer psStorage, const ShaderUniformMask &mask);
+		// Render thread only. Loose uniforms are program state shared by every material using the shader;
+		// this is the upload generation of the material whose values the program holds, 0 if none
+		uint64_t GetMaterialGeneration() const { return m_MaterialGeneration; }
+		void SetMaterialGeneration(uint64_t generation) { m_MaterialGeneration = generation; }
+
+		const std::vector<ShaderKeyword> &GetKeywords() const { return m_Keywords; }
+		uint32_t GetKeywordMask() const { return m_KeywordMask; }
+		// Returns the variant compiled with the given keywords, creating it the first time it is asked for.
+		// A new variant is parsed on the thread pool and then compiled in the background like any other
+		// shader; it is not ready until both are done. Safe to call from any thread
+		Ref<Shader> GetVariant(uint32_t keywordMask);
+		// Variants that are ready. The hot reloader leaves the others alone until they are
+		std::vector<Ref<Shader>> GetVariants();
+
+		// Main thread only. Every shader created from a file, excluding variants
+		static std::vector<Ref<Shader>> GetLoadedShaders();
+		// Whether the source file or one of its includes is the given path, as FileWatcher reports it
+		bool DependsOn(const std::string &path) const;
+		// Exchanges programs and parsed state with a replacement loaded from the same file, which is left
+		// with the old ones. Nothing may use either shader on the render thread during the swap
+		void SwapProgram(Shader &other);
 
 		std::string ReadShaderFromFile(const std::string &filepath) const;
+		// Splits the source into stages, expands #include directives and defines the enabled keywords
 		std::unordered_map<GLenum, std::string> PreProcess(const std::string &source);
-		void CompileAndUploadShader();
+		// Render thread only. Issues the compile and link without waiting on them, or loads a cached binary
+		void BeginCompile();
+		// Render thread only. Returns true once the program is linked and its uniforms are resolved
+		bool PollCompile();
+		// Render thread only. Blocks until the program is linked
+		void FinishCompile();
 
 		void Parse();
 		void ParseUniform(const std::string &statement, ShaderDomain domain);
 		void ParseUniformStruct(const std::string &block, ShaderDomain domain);
+		void ParseUniformBlock(const std::string &block, int32_t binding, ShaderDomain domain);
+		void AssignMaterialUniformIndices();
 		int32_t GetUniformLocation(const std::string &name) const;
+		// Render thread only. Looked up in the program's reflection, so any active uniform is found by id;
+		// the name is only used to report a missing uniform
+		int32_t GetUniformLocation(UniformID id, const std::string *name = nullptr) const;
 		ShaderStruct *FindStruct(const std::string &name);
 
+		// Render thread only. Fills the declared uniforms' locations, block bindings and sampler units from
+		// the program's reflection
 		void ResolveUniforms();
+		// Render thread only. Reports where the parsed block layouts disagree with the driver's
 		void ValidateUniforms();
+		// Layout of the linked program, empty until it is ready
+		const ShaderReflection &GetReflection() const { return m_Reflection; }
 
 		void ResolveAndSetUniforms(const Ref<ShaderUniformBufferDeclaration> &decl, Buffer buffer);
 		void ResolveAndSetUniform(ShaderUniformDeclaration *uniform, Buffer buffer);
@@ -45,6 +118,7 @@ namespace Janus
 		void ResolveAndSetUniformField(const ShaderUniformDeclaration &field, byte *data, int32_t offset);
 
 		const std::string& GetName() const { return m_Name; }
+		const std::string& GetAssetPath() const { return m_AssetPath; }
 		// Preprocess single source string into multiple shader sources
 
 		// Mapping of strings to shader types. Currently only supports "vertex" and "fragment"
@@ -58,6 +132,13 @@ namespace Janus
 		void SetMat4(const std::string &name, const glm::mat4 &value);
 		void SetMat4FromRenderThread(const std::string &name, const glm::mat4 &value, bool bind = true);
 
+		// Id overloads keep the uniform name out of the recorded command
+		void SetInt(UniformID id, int value);
+		void SetFloat(UniformID id, float value);
+		void SetFloat2(UniformID id, const glm::vec2 &value);
+		void SetFloat3(UniformID id, const glm::vec3 &value);
+		void SetMat4(UniformID id, const glm::mat4 &value);
+
 		void SetIntArray(const std::string &name, int *values, uint32_t size);
 
 		const ShaderUniformBufferList &GetVSRendererUniforms() const { return m_VSRendererUniformBuffers; }
@@ -67,8 +148,28 @@ namespace Janus
 		const ShaderUniformBufferDeclaration &GetVSMaterialUniformBuffer() const { return *m_VSMaterialUniformBuffer; }
 		const ShaderUniformBufferDeclaration &GetPSMaterialUniformBuffer() const { return *m_PSMaterialUniformBuffer; }
 		const std::vector<ShaderResourceDeclaration *> &GetResources() const { return m_Resources; }
+		// std140 uniform blocks, indexed by ShaderUniformDeclaration::GetBlockIndex(). Blocks named r_* are
+		// filled by the renderer, the others are backed by per-material uniform buffers
+		const std::vector<Ref<ShaderUniformBufferDeclaration>> &GetUniformBlocks() const { return m_UniformBlocks; }
+		uint32_t GetMaterialUniformCount() const { return m_MaterialUniformCount; }
+		// Binary search of the material uniforms sorted by id
+		ShaderUniformDeclaration *FindMaterialUniform(UniformID id) const;
+		const std::vector<std::pair<UniformID, ShaderUniformDeclaration *>> &GetMaterialUniforms() const { return m_MaterialUniformTable; }
+		static bool IsRendererUniformBlock(const ShaderUniformBufferDeclaration &block) { return block.GetName().rfind("r_", 0) == 0; }
 
 	private:
+		// Empty variant for GetVariant, which takes the parsed state over once it is loaded on the thread pool
+		struct DeferredLoad
+		{
+		};
+		Shader(const std::string &filepath, uint32_t keywordMask, DeferredLoad);
+
+		void OnCompiled();
+		// Includes are resolved relative to the including file and each file is pasted at most once per stage
+		std::string ExpandIncludes(const std::string &source, const std::filesystem::path &directory, std::unordered_set<std::string> &included) const;
+		void ParseKeywords(std::string &source);
+		void ResolveKeywords();
+
 		void UploadUniformField(uint32_t location, const ShaderUniformDeclaration& field, byte *data, int32_t offset);
 		void UploadUniformInt(uint32_t location, int32_t value);
 		void UploadUniformIntArray(uint32_t location, int32_t *values, int32_t count);
@@ -96,14 +197,32 @@ namespace Janus
 		std::string m_Name, m_AssetPath;
 		std::unordered_map<GLenum, std::string> m_ShaderSource;
 
-		bool m_Loaded = false;
+		std::atomic<bool> m_Loaded{false};
 		bool m_IsCompute = false;
+		bool m_Compiling = false;
+		std::atomic<bool> m_CompileFailed{false};
+		bool m_Listed = false;
+		std::vector<GLuint> m_CompilingShaders;
+		uint64_t m_CacheKey = 0;
+
+		std::vector<ShaderKeyword> m_Keywords;
+		uint32_t m_KeywordMask = 0;
+		std::unordered_map<uint32_t, Ref<Shader>> m_Variants;
+		std::mutex m_VariantMutex;
+		std::vector<std::string> m_Dependencies;
 
 		ShaderUniformBufferList m_VSRendererUniformBuffers;
 		ShaderUniformBufferList m_PSRendererUniformBuffers;
 		Ref<ShaderUniformBufferDeclaration> m_VSMaterialUniformBuffer;
 		Ref<ShaderUniformBufferDeclaration> m_PSMaterialUniformBuffer;
 		std::vector<ShaderResourceDeclaration *> m_Resources;
+		std::vector<Ref<ShaderUniformBufferDeclaration>> m_UniformBlocks;
+		uint32_t m_MaterialUniformCount = 0;
+		std::vector<std::pair<UniformID, ShaderUniformDeclaration *>> m_MaterialUniformTable;
+		ShaderReflection m_Reflection;
+		// Ids already reported missing, so each is only reported once
+		mutable std::unordered_set<uint32_t> m_MissingUniforms;
+		uint64_t m_MaterialGeneration = 0;
 		ShaderStructList m_Structs;
 	};
 }
\ No newline at end of file
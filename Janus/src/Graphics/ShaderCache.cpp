@@ -0,0 +1,166 @@
+#include "jnpch.h"
+#include "Graphics/ShaderCache.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace Janus
+{
+	static const char *s_CacheDirectory = "cache/shaders";
+	static constexpr uint32_t s_CacheMagic = 0x4a4e5043; // "JNPC"
+	static constexpr uint32_t s_CacheVersion = 2;
+
+	struct ShaderCacheHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key;
+		uint32_t BinaryFormat;
+		uint32_t BinarySize;
+		uint32_t ReflectionSize;
+	};
+
+	static uint64_t HashBytes(uint64_t hash, const void *data, size_t size)
+	{
+		// 64-bit FNV-1a
+		const uint8_t *bytes = (const uint8_t *)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static uint64_t HashString(uint64_t hash, const char *string)
+	{
+		return string ? HashBytes(hash, string, strlen(string)) : hash;
+	}
+
+	// Binaries are only guaranteed to load on the driver that produced them
+	static uint64_t GetDriverHash()
+	{
+		static uint64_t s_DriverHash = 0;
+		if (!s_DriverHash)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			hash = HashString(hash, (const char *)glGetString(GL_VENDOR));
+			hash = HashString(hash, (const char *)glGetString(GL_RENDERER));
+			hash = HashString(hash, (const char *)glGetString(GL_VERSION));
+			s_DriverHash = hash;
+		}
+		return s_DriverHash;
+	}
+
+	static bool IsSupported()
+	{
+		static int32_t s_FormatCount = -1;
+		if (s_FormatCount < 0)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &s_FormatCount);
+		return s_FormatCount > 0;
+	}
+
+	static std::filesystem::path GetCachePath(uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+		return std::filesystem::path(s_CacheDirectory) / name;
+	}
+
+	uint64_t ShaderCache::ComputeKey(const std::unordered_map<GLenum, std::string> &sources)
+	{
+		// Hash the stages in a fixed order; map iteration order is unspecified
+		std::vector<GLenum> stages;
+		for (auto &kv : sources)
+			stages.push_back(kv.first);
+		std::sort(stages.begin(), stages.end());
+
+		uint64_t hash = GetDriverHash();
+		for (GLenum stage : stages)
+		{
+			const std::string &source = sources.at(stage);
+			hash = HashBytes(hash, &stage, sizeof(stage));
+			hash = HashBytes(hash, source.data(), source.size());
+		}
+		return hash;
+	}
+
+	bool ShaderCache::LoadProgram(uint64_t key, GLuint program, ShaderReflection &reflection)
+	{
+		JN_PROFILE_FUNCTION();
+		if (!IsSupported())
+			return false;
+
+		std::ifstream in(GetCachePath(key), std::ios::binary);
+		if (!in)
+			return false;
+
+		ShaderCacheHeader header;
+		if (!in.read((char *)&header, sizeof(header)) || header.Magic != s_CacheMagic || header.Version != s_CacheVersion || header.Key != key)
+			return false;
+
+		std::vector<char> binary(header.BinarySize);
+		std::vector<char> layout(header.ReflectionSize);
+		if (!in.read(binary.data(), binary.size()) || !in.read(layout.data(), layout.size()))
+			return false;
+		if (!reflection.Deserialize(layout.data(), layout.size()))
+			return false;
+
+		glProgramBinary(program, header.BinaryFormat, binary.data(), (GLsizei)binary.size());
+
+		// The driver may still reject a binary it produced, e.g. after a partial update
+		GLint isLinked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+		if (isLinked == GL_FALSE)
+		{
+			JN_CORE_WARN("SHADER_CACHE_MSG: Cached program {0:016x} was rejected, recompiling", key);
+			return false;
+		}
+		return true;
+	}
+
+	void ShaderCache::PrepareProgram(GLuint program)
+	{
+		if (IsSupported())
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	void ShaderCache::SaveProgram(uint64_t key, GLuint program, const ShaderReflection &reflection)
+	{
+		JN_PROFILE_FUNCTION();
+		if (!IsSupported())
+			return;
+
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+			return;
+
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		std::vector<char> layout;
+		reflection.Serialize(layout);
+
+		std::error_code error;
+		std::filesystem::create_directories(s_CacheDirectory, error);
+		// Write under a temporary name so a crash never leaves a truncated entry behind
+		std::filesystem::path path = GetCachePath(key);
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+		{
+			std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!out)
+			{
+				JN_CORE_WARN("SHADER_CACHE_MSG: Could not write {0}", temporaryPath.string());
+				return;
+			}
+
+			ShaderCacheHeader header = {s_CacheMagic, s_CacheVersion, key, format, (uint32_t)length, (uint32_t)layout.size()};
+			out.write((const char *)&header, sizeof(header));
+			out.write(binary.data(), length);
+			out.write(layout.data(), layout.size());
+		}
+		std::filesystem::rename(temporaryPath, path, error);
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <glad/glad.h>
+
+#include "Graphics/ShaderReflection.h"
+
+namespace Janus
+{
+	// On-disk cache of linked program binaries. Entries are keyed by a hash of the preprocessed stage
+	// sources and the GL driver strings, so editing a shader or updating the driver simply misses the cache.
+	// Each entry also holds the program's reflected layout, so a cache hit needs no interface queries.
+	// Render thread only.
+	class ShaderCache
+	{
+	public:
+		static uint64_t ComputeKey(const std::unordered_map<GLenum, std::string> &sources);
+
+		// Returns true if the program and its reflection were restored from the cache and linked successfully
+		static bool LoadProgram(uint64_t key, GLuint program, ShaderReflection &reflection);
+		// Call before linking so the driver keeps a retrievable binary
+		static void PrepareProgram(GLuint program);
+		static void SaveProgram(uint64_t key, GLuint program, const ShaderReflection &reflection);
+	};
+}
@@ -0,0 +1,135 @@
+#include "jnpch.h"
+#include "Graphics/ShaderReflection.h"
+
+#include <type_traits>
+
+namespace Janus
+{
+	static_assert(std::is_trivially_copyable_v<ShaderReflection::Uniform>);
+	static_assert(std::is_trivially_copyable_v<ShaderReflection::UniformBlock>);
+
+	template <typename T>
+	static const T *FindByID(const std::vector<T> &entries, UniformID id)
+	{
+		auto it = std::lower_bound(entries.begin(), entries.end(), id, [](const T &entry, UniformID id)
+								   { return entry.ID < id; });
+		if (it == entries.end() || it->ID != id)
+			return nullptr;
+		return &*it;
+	}
+
+	template <typename T>
+	static void SortByID(std::vector<T> &entries)
+	{
+		std::sort(entries.begin(), entries.end(), [](const T &a, const T &b)
+				  { return a.ID < b.ID; });
+	}
+
+	ShaderReflection ShaderReflection::Reflect(GLuint program)
+	{
+		JN_PROFILE_FUNCTION();
+		ShaderReflection reflection;
+
+		GLint uniformCount = 0, blockCount = 0, uniformNameLength = 0, blockNameLength = 0;
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+		glGetProgramInterfaceiv(program, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &blockCount);
+		glGetProgramInterfaceiv(program, GL_UNIFORM, GL_MAX_NAME_LENGTH, &uniformNameLength);
+		glGetProgramInterfaceiv(program, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &blockNameLength);
+
+		// One buffer for every name; names are hashed in place and never kept
+		std::vector<char> name(std::max(std::max(uniformNameLength, blockNameLength), 1));
+
+		static const GLenum uniformProperties[] = {GL_LOCATION, GL_BLOCK_INDEX, GL_OFFSET, GL_ARRAY_SIZE, GL_TYPE};
+		reflection.m_Uniforms.reserve(uniformCount);
+		for (GLint i = 0; i < uniformCount; i++)
+		{
+			GLint values[5];
+			glGetProgramResourceiv(program, GL_UNIFORM, i, 5, uniformProperties, 5, nullptr, values);
+
+			GLsizei length = 0;
+			glGetProgramResourceName(program, GL_UNIFORM, i, (GLsizei)name.size(), &length, name.data());
+			if (length > 3 && strcmp(name.data() + length - 3, "[0]") == 0)
+				name[length - 3] = '\0';
+
+			Uniform uniform;
+			uniform.ID = UniformID(name.data());
+			uniform.Location = values[0];
+			uniform.BlockIndex = values[1];
+			uniform.Offset = values[2];
+			uniform.ArraySize = (uint32_t)values[3];
+			uniform.Type = (GLenum)values[4];
+			reflection.m_Uniforms.push_back(uniform);
+		}
+
+		static const GLenum blockProperties[] = {GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE};
+		reflection.m_UniformBlocks.reserve(blockCount);
+		for (GLint i = 0; i < blockCount; i++)
+		{
+			GLint values[2];
+			glGetProgramResourceiv(program, GL_UNIFORM_BLOCK, i, 2, blockProperties, 2, nullptr, values);
+			glGetProgramResourceName(program, GL_UNIFORM_BLOCK, i, (GLsizei)name.size(), nullptr, name.data());
+
+			UniformBlock block;
+			block.ID = UniformID(name.data());
+			block.Index = (uint32_t)i;
+			block.Binding = (uint32_t)values[0];
+			block.Size = (uint32_t)values[1];
+			reflection.m_UniformBlocks.push_back(block);
+		}
+
+		SortByID(reflection.m_Uniforms);
+		SortByID(reflection.m_UniformBlocks);
+		return reflection;
+	}
+
+	const ShaderReflection::Uniform *ShaderReflection::FindUniform(UniformID id) const
+	{
+		return FindByID(m_Uniforms, id);
+	}
+
+	const ShaderReflection::UniformBlock *ShaderReflection::FindUniformBlock(UniformID id) const
+	{
+		return FindByID(m_UniformBlocks, id);
+	}
+
+	// Layout: uniform count, block count, then both arrays as they are in memory
+	void ShaderReflection::Serialize(std::vector<char> &data) const
+	{
+		uint32_t counts[2] = {(uint32_t)m_Uniforms.size(), (uint32_t)m_UniformBlocks.size()};
+		size_t uniformsSize = m_Uniforms.size() * sizeof(Uniform);
+		size_t blocksSize = m_UniformBlocks.size() * sizeof(UniformBlock);
+
+		data.resize(sizeof(counts) + uniformsSize + blocksSize);
+		char *ptr = data.data();
+		memcpy(ptr, counts, sizeof(counts));
+		ptr += sizeof(counts);
+		if (uniformsSize)
+			memcpy(ptr, m_Uniforms.data(), uniformsSize);
+		ptr += uniformsSize;
+		if (blocksSize)
+			memcpy(ptr, m_UniformBlocks.data(), blocksSize);
+	}
+
+	bool ShaderReflection::Deserialize(const char *data, size_t size)
+	{
+		uint32_t counts[2];
+		if (size < sizeof(counts))
+			return false;
+		memcpy(counts, data, sizeof(counts));
+
+		size_t uniformsSize = (size_t)counts[0] * sizeof(Uniform);
+		size_t blocksSize = (size_t)counts[1] * sizeof(UniformBlock);
+		if (size != sizeof(counts) + uniformsSize + blocksSize)
+			return false;
+
+		const char *ptr = data + sizeof(counts);
+		m_Uniforms.resize(counts[0]);
+		if (uniformsSize)
+			memcpy(m_Uniforms.data(), ptr, uniformsSize);
+		ptr += uniformsSize;
+		m_UniformBlocks.resize(counts[1]);
+		if (blocksSize)
+			memcpy(m_UniformBlocks.data(), ptr, blocksSize);
+		return true;
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <glad/glad.h>
+
+#include "Graphics/UniformID.h"
+
+namespace Janus
+{
+	// Active uniforms and uniform blocks of a linked program, as the driver reports them through the program
+	// interface query API. Names are only kept as ids, so the layout is small and plain enough to be stored
+	// next to a cached program binary
+	class ShaderReflection
+	{
+	public:
+		struct Uniform
+		{
+			UniformID ID;
+			// -1 for members of a uniform block
+			int32_t Location;
+			// Index into the program's uniform blocks, or -1 for loose uniforms
+			int32_t BlockIndex;
+			// Byte offset inside the block, or -1 for loose uniforms
+			int32_t Offset;
+			uint32_t ArraySize;
+			GLenum Type;
+		};
+
+		struct UniformBlock
+		{
+			UniformID ID;
+			uint32_t Index;
+			uint32_t Binding;
+			uint32_t Size;
+		};
+
+		// Render thread only. Arrays of basic types are reported by their bare name rather than "name[0]",
+		// struct members by their full name, e.g. "u_Lights[1].Radiance"
+		static ShaderReflection Reflect(GLuint program);
+
+		const Uniform *FindUniform(UniformID id) const;
+		const UniformBlock *FindUniformBlock(UniformID id) const;
+		const std::vector<Uniform> &GetUniforms() const { return m_Uniforms; }
+		const std::vector<UniformBlock> &GetUniformBlocks() const { return m_UniformBlocks; }
+
+		void Serialize(std::vector<char> &data) const;
+		// Returns false if the data is not a complete layout
+		bool Deserialize(const char *data, size_t size);
+
+	private:
+		// Both sorted by id
+		std::vector<Uniform> m_Uniforms;
+		std::vector<UniformBlock> m_UniformBlocks;
+	};
+}
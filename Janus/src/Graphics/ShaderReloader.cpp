@@ -0,0 +1,152 @@
+#include "jnpch.h"
+#include "Graphics/ShaderReloader.h"
+
+#include <atomic>
+
+#include "Core/FileWatcher.h"
+#include "Core/ThreadPool.h"
+#include "Graphics/Renderer.h"
+#include "Graphics/Shader.h"
+#include "Graphics/Material.h"
+
+namespace Janus
+{
+	// Filled on the thread pool and only read once Done is set. Kept apart from the reload so a superseded
+	// parse job only ever releases the unlisted, uncompiled replacements it created
+	struct ShaderReplacements
+	{
+		std::vector<Ref<Shader>> Shaders;
+		std::atomic<bool> Done{false};
+	};
+
+	// A shader and its variants being reloaded together. Targets[0] is the shader loaded from the file, and
+	// replacements are in the order of Targets
+	struct ShaderReload
+	{
+		std::vector<Ref<Shader>> Targets;
+		std::shared_ptr<ShaderReplacements> Replacements = std::make_shared<ShaderReplacements>();
+		bool Compiling = false;
+	};
+
+	struct ShaderReloaderData
+	{
+		std::unique_ptr<FileWatcher> Watcher;
+		std::vector<std::shared_ptr<ShaderReload>> Reloads;
+	};
+
+	static ShaderReloaderData s_Data;
+
+	void ShaderReloader::Init(const std::string &directory)
+	{
+		s_Data.Watcher = std::make_unique<FileWatcher>(directory);
+	}
+
+	void ShaderReloader::Shutdown()
+	{
+		s_Data.Reloads.clear();
+		s_Data.Watcher.reset();
+	}
+
+	static void StartReloads(const std::vector<std::string> &changes)
+	{
+		// Shaders can be released on the render thread, so only take references while it is idle
+		Renderer::WaitForRenderThread();
+		for (auto &shader : Shader::GetLoadedShaders())
+		{
+			bool changed = std::any_of(changes.begin(), changes.end(), [&](const std::string &path)
+									   { return shader->DependsOn(path); });
+			if (!changed)
+				continue;
+
+			// A newer edit supersedes a reload still in flight
+			auto &reloads = s_Data.Reloads;
+			reloads.erase(std::remove_if(reloads.begin(), reloads.end(), [&](const std::shared_ptr<ShaderReload> &reload)
+										 { return reload->Targets[0].Raw() == shader.Raw(); }),
+						  reloads.end());
+
+			auto reload = std::make_shared<ShaderReload>();
+			reload->Targets.push_back(shader);
+			for (auto &variant : shader->GetVariants())
+				reload->Targets.push_back(variant);
+			reloads.push_back(reload);
+
+			std::vector<std::pair<std::string, uint32_t>> sources;
+			for (auto &target : reload->Targets)
+				sources.push_back({shader->GetAssetPath(), target->GetKeywordMask()});
+
+			JN_CORE_INFO("SHADER_MSG: Reloading {0} ({1} programs)", shader->GetName(), sources.size());
+			std::shared_ptr<ShaderReplacements> replacements = reload->Replacements;
+			ThreadPool::Get().Enqueue([replacements, sources]()
+									  {
+										  JN_PROFILE_SCOPE("ShaderReloader::Parse");
+										  for (auto &[path, keywordMask] : sources)
+											  replacements->Shaders.push_back(Ref<Shader>::Create(path, keywordMask, false));
+										  replacements->Done.store(true, std::memory_order_release);
+									  });
+		}
+	}
+
+	void ShaderReloader::Update()
+	{
+		if (!s_Data.Watcher)
+			return;
+
+		JN_PROFILE_FUNCTION();
+		std::vector<std::string> changes = s_Data.Watcher->PopChanges();
+		if (!changes.empty())
+			StartReloads(changes);
+
+		std::vector<std::shared_ptr<ShaderReload>> completed;
+		auto &reloads = s_Data.Reloads;
+		for (auto it = reloads.begin(); it != reloads.end();)
+		{
+			auto &reload = *it;
+			auto &replacements = reload->Replacements->Shaders;
+			if (!reload->Replacements->Done.load(std::memory_order_acquire))
+			{
+				it++;
+				continue;
+			}
+
+			if (!reload->Compiling)
+			{
+				for (auto &replacement : replacements)
+					replacement->Compile();
+				reload->Compiling = true;
+				it++;
+				continue;
+			}
+
+			bool ready = std::all_of(replacements.begin(), replacements.end(), [](const Ref<Shader> &replacement)
+									 { return replacement->IsReady(); });
+			if (!ready)
+			{
+				it++;
+				continue;
+			}
+
+			bool failed = std::any_of(replacements.begin(), replacements.end(), [](const Ref<Shader> &replacement)
+									  { return replacement->HasCompileErrors(); });
+			if (failed)
+				JN_CORE_ERROR("SHADER_ERROR: {0} failed to compile, keeping the previous program", reload->Targets[0]->GetName());
+			else
+				completed.push_back(reload);
+			it = reloads.erase(it);
+		}
+
+		if (completed.empty())
+			return;
+
+		// Nothing has been recorded for this frame yet, so once the render thread finishes the previous one
+		// no command refers to the layouts being replaced
+		Renderer::WaitForRenderThread();
+		for (auto &reload : completed)
+		{
+			auto &replacements = reload->Replacements->Shaders;
+			for (size_t i = 0; i < reload->Targets.size(); i++)
+				reload->Targets[i]->SwapProgram(*replacements[i]);
+			Material::OnShaderReloaded(reload->Targets[0], *replacements[0]);
+			JN_CORE_INFO("SHADER_MSG: Reloaded {0}", reload->Targets[0]->GetName());
+		}
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace Janus
+{
+	// Reloads shaders whose source or includes change on disk. Sources are parsed on the thread pool and
+	// programs compile in the background like any other shader. Once a shader and all of its variants are
+	// ready they are swapped in together at a frame boundary, and the materials using them remap their
+	// storage. A reload that fails to compile keeps the previous programs
+	class ShaderReloader
+	{
+	public:
+		static void Init(const std::string &directory);
+		static void Shutdown();
+
+		// Main thread only, at the start of a frame before anything has been recorded
+		static void Update();
+	};
+}
@@ -121,6 +121,101 @@ namespace Janus
 		m_Uniforms.push_back(uniform);
 	}
 
+	static uint32_t RoundUp(uint32_t value, uint32_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	static uint32_t Std140Alignment(ShaderUniformDeclaration::Type type)
+	{
+		switch (type)
+		{
+		case ShaderUniformDeclaration::Type::BOOL:
+		case ShaderUniformDeclaration::Type::INT32:
+		case ShaderUniformDeclaration::Type::FLOAT32:
+			return 4;
+		case ShaderUniformDeclaration::Type::VEC2:
+			return 8;
+		// vec3, vec4, matrix columns and structs all align to a vec4
+		case ShaderUniformDeclaration::Type::VEC3:
+		case ShaderUniformDeclaration::Type::VEC4:
+		case ShaderUniformDeclaration::Type::MAT3:
+		case ShaderUniformDeclaration::Type::MAT4:
+		case ShaderUniformDeclaration::Type::STRUCT:
+			return 16;
+		default:
+			JN_ASSERT(false, "SHADER_ERROR: Unknown uniform type!");
+			return 0;
+		}
+	}
+
+	// Structs are sized by Std140StructSize
+	static uint32_t Std140Size(ShaderUniformDeclaration::Type type)
+	{
+		switch (type)
+		{
+		case ShaderUniformDeclaration::Type::BOOL:
+			return 4;
+		case ShaderUniformDeclaration::Type::MAT3:
+			return 3 * 16;
+		case ShaderUniformDeclaration::Type::INT32:
+		case ShaderUniformDeclaration::Type::FLOAT32:
+		case ShaderUniformDeclaration::Type::VEC2:
+		case ShaderUniformDeclaration::Type::VEC3:
+		case ShaderUniformDeclaration::Type::VEC4:
+		case ShaderUniformDeclaration::Type::MAT4:
+			return ShaderUniformDeclaration::SizeOfUniformType(type);
+		default:
+			JN_ASSERT(false, "SHADER_ERROR: Unknown uniform type!");
+			return 0;
+		}
+	}
+
+	static uint32_t Std140StructSize(const ShaderStruct &uniformStruct)
+	{
+		uint32_t offset = 0;
+		for (ShaderUniformDeclaration *field : uniformStruct.GetFields())
+		{
+			uint32_t alignment = Std140Alignment(field->GetType());
+			uint32_t size = field->GetType() == ShaderUniformDeclaration::Type::STRUCT ? Std140StructSize(field->GetShaderUniformStruct()) : Std140Size(field->GetType());
+			if (field->IsArray())
+			{
+				alignment = 16;
+				size = RoundUp(size, 16) * field->GetCount();
+			}
+			offset = RoundUp(offset, alignment) + size;
+		}
+		return RoundUp(offset, 16);
+	}
+
+	void ShaderUniformBufferDeclaration::PushUniformStd140(ShaderUniformDeclaration *uniform)
+	{
+		uint32_t alignment = 16;
+		uint32_t elementSize;
+		if (uniform->GetType() == ShaderUniformDeclaration::Type::STRUCT)
+		{
+			elementSize = Std140StructSize(uniform->GetShaderUniformStruct());
+		}
+		else
+		{
+			alignment = Std140Alignment(uniform->GetType());
+			elementSize = Std140Size(uniform->GetType());
+		}
+
+		// Array elements are padded to a vec4 stride
+		if (uniform->IsArray())
+		{
+			alignment = 16;
+			elementSize = RoundUp(elementSize, 16);
+		}
+
+		uint32_t offset = RoundUp(m_Size, alignment);
+		uniform->m_Size = elementSize * uniform->GetCount();
+		uniform->SetOffset(offset);
+		m_Size = offset + uniform->GetSize();
+		m_Uniforms.push_back(uniform);
+	}
+
 	ShaderUniformDeclaration *ShaderUniformBufferDeclaration::FindUniform(const std::string &name)
 	{
 		for (ShaderUniformDeclaration *uniform : m_Uniforms)
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <bitset>
 
 #include "Core/Core.h"
 #include "Core/Log.h"
@@ -21,6 +22,7 @@ namespace Janus {
     private:
         friend class ShaderStruct;   
         friend class Shader;    
+        friend class ShaderUniformBufferDeclaration;
     public:
         enum class Type
         {
@@ -32,6 +34,10 @@ namespace Janus {
 		inline uint32_t GetCount() const  { return m_Count; }
 		inline uint32_t GetOffset() const  { return m_Offset; }
 		inline ShaderDomain GetDomain() const { return m_Domain; }
+		// Index of the shader uniform block this uniform is a member of, or -1 for a loose uniform
+		inline int32_t GetBlockIndex() const { return m_BlockIndex; }
+		// Bit of this uniform in a ShaderUniformMask, or -1 if materials do not own it
+		inline int32_t GetMaterialIndex() const { return m_MaterialIndex; }
 
 		int32_t GetLocation() const { return m_Location; }
 		inline Type GetType() const { return m_Type; }
@@ -55,10 +61,16 @@ namespace Janus {
         Type m_Type;
         ShaderStruct* m_Struct;
         mutable int32_t m_Location;
+        int32_t m_BlockIndex = -1;
+        int32_t m_MaterialIndex = -1;
     };
 
     typedef std::vector<ShaderUniformDeclaration*> ShaderUniformList;
 
+    // One bit per material owned uniform of a shader
+    static constexpr uint32_t MaxMaterialUniforms = 64;
+    typedef std::bitset<MaxMaterialUniforms> ShaderUniformMask;
+
     class ShaderUniformBufferDeclaration : public RefCounted
     {
 	private:
@@ -73,6 +85,8 @@ namespace Janus {
 		ShaderUniformBufferDeclaration(const std::string& name, ShaderDomain domain);
 
 		void PushUniform(ShaderUniformDeclaration* uniform);
+		// Places the uniform at its std140 offset and gives it its std140 size, array padding included
+		void PushUniformStd140(ShaderUniformDeclaration* uniform);
 
 		inline const std::string& GetName() const  { return m_Name; }
 		inline uint32_t GetRegister() const  { return m_Register; }
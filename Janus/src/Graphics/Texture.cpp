@@ -4,6 +4,7 @@
 
 #include "Graphics/Texture.h"
 #include "Graphics/Renderer.h"
+#include "Graphics/RenderStateCache.h"
 namespace Janus
 {
 
@@ -84,6 +85,7 @@ namespace Janus
                              glGenerateMipmap(GL_TEXTURE_2D);
 
                              glBindTexture(GL_TEXTURE_2D, 0);
+                             RenderStateCache::InvalidateTextureUnit(0);
 
                              stbi_image_free(instance->m_ImageData.Data);
                          });
@@ -93,6 +95,7 @@ namespace Janus
 		GLuint rendererID = m_RendererID;
 		Renderer::Submit([rendererID]() {
 			glDeleteTextures(1, &rendererID);
+			RenderStateCache::OnTexturesDeleted(1, &rendererID);
 		});
 	}
 
@@ -105,7 +108,7 @@ namespace Janus
     {
         Ref<Texture2D> instance = this;
         Renderer::Submit([instance, slot]() mutable
-                         { glBindTextureUnit(slot, instance->m_RendererID); });
+                         { RenderStateCache::BindTextureUnit(slot, instance->m_RendererID); });
     }
 
 	TextureCube::TextureCube(TextureFormat format, uint32_t width, uint32_t height, void* data)
@@ -242,6 +245,7 @@ namespace Janus
 			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
 			glBindTexture(GL_TEXTURE_2D, 0);
+			RenderStateCache::InvalidateTextureUnit(0);
 
 			for (size_t i = 0; i < faces.size(); i++)
 				delete[] faces[i];
@@ -255,6 +259,7 @@ namespace Janus
 		GLuint rendererID = m_RendererID;
 		Renderer::Submit([rendererID]() {
 			glDeleteTextures(1, &rendererID);
+			RenderStateCache::OnTexturesDeleted(1, &rendererID);
 		});
 	}
 
@@ -262,7 +267,7 @@ namespace Janus
 	{
 		Ref<const TextureCube> instance = this;
 		Renderer::Submit([instance, slot]() {
-			glBindTextureUnit(slot, instance->m_RendererID);
+			RenderStateCache::BindTextureUnit(slot, instance->m_RendererID);
 		});
 	}
 
@@ -0,0 +1,68 @@
+#include "jnpch.h"
+#include "Graphics/UniformBuffer.h"
+
+#include <glad/glad.h>
+
+#include "Core/Buffer.h"
+#include "Graphics/Renderer.h"
+#include "Graphics/RenderStateCache.h"
+
+namespace Janus
+{
+	UniformBuffer::UniformBuffer(uint32_t size, uint32_t binding)
+		: m_Size(size), m_Binding(binding)
+	{
+		Ref<UniformBuffer> instance = this;
+		Renderer::Submit([instance]() mutable
+						 {
+							 glCreateBuffers(1, &instance->m_RendererID);
+							 glNamedBufferData(instance->m_RendererID, instance->m_Size, nullptr, GL_DYNAMIC_DRAW);
+						 });
+	}
+
+	UniformBuffer::~UniformBuffer()
+	{
+		GLuint rendererID = m_RendererID;
+		Renderer::Submit([rendererID]()
+						 {
+							 glDeleteBuffers(1, &rendererID);
+							 RenderStateCache::OnBuffersDeleted(1, &rendererID);
+						 });
+	}
+
+	void UniformBuffer::SetData(const void *data, uint32_t size, uint32_t offset)
+	{
+		JN_ASSERT(offset + size <= m_Size, "UNIFORM_BUFFER_ERROR: Data does not fit in the buffer!");
+
+		Buffer snapshot = Buffer::Copy((void *)data, size);
+		Ref<UniformBuffer> instance = this;
+		Renderer::Submit([instance, snapshot, offset]() mutable
+						 {
+							 glNamedBufferSubData(instance->m_RendererID, offset, snapshot.Size, snapshot.Data);
+							 snapshot.Release();
+						 });
+	}
+
+	void UniformBuffer::Bind() const
+	{
+		Ref<const UniformBuffer> instance = this;
+		Renderer::Submit([instance]()
+						 { RenderStateCache::BindUniformBuffer(instance->m_Binding, instance->m_RendererID); });
+	}
+
+	void UniformBuffer::BindRange(uint32_t offset, uint32_t size) const
+	{
+		JN_ASSERT(offset % MaxOffsetAlignment == 0 && offset + size <= m_Size, "UNIFORM_BUFFER_ERROR: Invalid range!");
+
+		Ref<const UniformBuffer> instance = this;
+		Renderer::Submit([instance, offset, size]()
+						 { RenderStateCache::BindUniformBufferRange(instance->m_Binding, instance->m_RendererID, offset, size); });
+	}
+
+	void UniformBuffer::Orphan()
+	{
+		Ref<UniformBuffer> instance = this;
+		Renderer::Submit([instance]()
+						 { glNamedBufferData(instance->m_RendererID, instance->m_Size, nullptr, GL_DYNAMIC_DRAW); });
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Core/Core.h"
+
+namespace Janus
+{
+	// GL buffer backing a std140 uniform block, bound to a fixed binding point
+	class UniformBuffer : public RefCounted
+	{
+	public:
+		// Binding points of the renderer owned blocks (r_ prefixed in GLSL). Material blocks use the others
+		static constexpr uint32_t FrameBinding = 0;
+		static constexpr uint32_t DrawBinding = 1;
+		static constexpr uint32_t FirstMaterialBinding = 2;
+		// Largest offset alignment GL allows an implementation to require of bound ranges
+		static constexpr uint32_t MaxOffsetAlignment = 256;
+
+		UniformBuffer(uint32_t size, uint32_t binding);
+		~UniformBuffer();
+
+		// Copies the data and uploads it on the render thread, so it is safe to call while recording in parallel
+		void SetData(const void *data, uint32_t size, uint32_t offset = 0);
+		void Bind() const;
+		// Binds size bytes starting at offset, which has to be a multiple of MaxOffsetAlignment
+		void BindRange(uint32_t offset, uint32_t size) const;
+		// Gives the buffer new storage, so writes after it don't wait for draws still reading the old contents
+		void Orphan();
+
+		uint32_t GetRendererID() const { return m_RendererID; }
+		uint32_t GetSize() const { return m_Size; }
+		uint32_t GetBinding() const { return m_Binding; }
+
+	private:
+		uint32_t m_RendererID = 0;
+		uint32_t m_Size;
+		uint32_t m_Binding;
+	};
+}
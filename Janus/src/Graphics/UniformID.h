@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstdio>
+
+namespace Janus
+{
+	// 32-bit FNV-1a hash of a uniform name. Constructed from a literal in a constexpr context, the name is
+	// hashed at compile time:
+	//     static constexpr UniformID s_TransformID("u_Transform");
+	class UniformID
+	{
+	public:
+		constexpr UniformID() = default;
+		explicit constexpr UniformID(const char *name) : m_Hash(Hash(name)) {}
+		explicit UniformID(const std::string &name) : m_Hash(Hash(name.c_str())) {}
+
+		constexpr uint32_t GetHash() const { return m_Hash; }
+
+		// The id of this name with suffix appended, so member ids such as "u_Lights[2].Radiance" can be
+		// formed without building the string
+		constexpr UniformID Append(const char *suffix) const { return UniformID(Hash(suffix, m_Hash), 0); }
+		UniformID Append(const std::string &suffix) const { return Append(suffix.c_str()); }
+		UniformID AppendIndex(uint32_t index) const
+		{
+			char digits[16];
+			snprintf(digits, sizeof(digits), "[%u]", index);
+			return Append(digits);
+		}
+
+		constexpr bool operator==(const UniformID &other) const { return m_Hash == other.m_Hash; }
+		constexpr bool operator!=(const UniformID &other) const { return m_Hash != other.m_Hash; }
+		constexpr bool operator<(const UniformID &other) const { return m_Hash < other.m_Hash; }
+
+	private:
+		constexpr UniformID(uint32_t hash, int) : m_Hash(hash) {}
+
+		static constexpr uint32_t Hash(const char *name, uint32_t hash = 2166136261u)
+		{
+			while (*name)
+			{
+				hash ^= (uint8_t)*name++;
+				hash *= 16777619u;
+			}
+			return hash;
+		}
+
+	private:
+		uint32_t m_Hash = 0;
+	};
+
+	static_assert(UniformID("u_Transform") != UniformID("u_Transforms"));
+	static_assert(UniformID("u_Light").Append(".Radiance") == UniformID("u_Light.Radiance"));
+}
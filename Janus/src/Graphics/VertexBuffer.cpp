@@ -5,6 +5,7 @@
 
 #include "Graphics/VertexBuffer.h"
 #include "Graphics/Renderer.h"
+#include "Graphics/RenderStateCache.h"
 namespace Janus
 {
     GLenum VertexBuffer::Usage(VertexBufferUsage usage)
@@ -44,21 +45,24 @@ namespace Janus
     {
         GLuint rendererID = m_RendererID;
         Renderer::Submit([rendererID]()
-                         { glDeleteBuffers(1, &rendererID); });
+                         {
+                             glDeleteBuffers(1, &rendererID);
+                             RenderStateCache::OnBuffersDeleted(1, &rendererID);
+                         });
     }
 
     void VertexBuffer::Bind()
     {
         Ref<const VertexBuffer> instance = this;
         Renderer::Submit([instance]()
-                         { JN_PROFILE_FUNCTION(); glBindBuffer(GL_ARRAY_BUFFER, instance->m_RendererID); });
+                         { JN_PROFILE_FUNCTION(); RenderStateCache::BindBuffer(GL_ARRAY_BUFFER, instance->m_RendererID); });
     }
 
     void VertexBuffer::Unbind()
     {
         Ref<const VertexBuffer> instance = this;
         Renderer::Submit([instance]()
-                         { glBindBuffer(GL_ARRAY_BUFFER, 0); });
+                         { RenderStateCache::BindBuffer(GL_ARRAY_BUFFER, 0); });
     }
 
     const BufferLayout &VertexBuffer::GetLayout()
@@ -21,7 +21,11 @@ namespace Janus
         Int2,
         Int3,
         Int4,
-        Bool
+        Bool,
+        // Packed types for compact vertices, read as floats. Shorts are usually normalized
+        UShort4,
+        Short2,
+        Half2
     };
 
     // Helper function to compute size of data types
@@ -51,6 +55,12 @@ namespace Janus
             return 4 * 4;
         case ShaderDataType::Bool:
             return 1;
+        case ShaderDataType::UShort4:
+            return 2 * 4;
+        case ShaderDataType::Short2:
+            return 2 * 2;
+        case ShaderDataType::Half2:
+            return 2 * 2;
         }
         return 0;
     }
@@ -67,8 +77,8 @@ namespace Janus
 
         BufferElement() {}
 
-        BufferElement(ShaderDataType type, const std::string &name, bool Normalized = false)
-            : Name(name), Type(type), Size(ShaderDataTypeSize(type)), Offset(0), Normalized(false)
+        BufferElement(ShaderDataType type, const std::string &name, bool normalized = false)
+            : Name(name), Type(type), Size(ShaderDataTypeSize(type)), Offset(0), Normalized(normalized)
         {
         }
 
@@ -98,6 +108,12 @@ namespace Janus
                 return 4;
             case ShaderDataType::Bool:
                 return 1;
+            case ShaderDataType::UShort4:
+                return 4;
+            case ShaderDataType::Short2:
+                return 2;
+            case ShaderDataType::Half2:
+                return 2;
             }
             return 0;
         }
@@ -154,6 +170,7 @@ namespace Janus
         ~VertexBuffer();
         void Bind();
         void Unbind();
+        uint32_t GetRendererID() const { return m_RendererID; }
         void SetLayout(const BufferLayout &layout);
         const BufferLayout &GetLayout();
         void SetData(void *data, uint32_t size, uint32_t offset = 0);
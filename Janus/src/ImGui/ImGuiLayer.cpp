@@ -6,6 +6,8 @@
 
 #include "Core/Application.h"
 
+#include "Graphics/Renderer.h"
+
 #include "ImGui/ImGuiLayer.h"
 
 #include <glad/glad.h>
@@ -58,6 +60,9 @@ namespace Janus
 		// Setup Platform/Renderer bindings
 		ImGui_ImplGlfw_InitForOpenGL(window, true);
 		ImGui_ImplOpenGL3_Init("#version 410");
+		// Create the GL objects up front while the main thread still owns the context,
+		// so ImGui_ImplOpenGL3_NewFrame never touches GL from the main thread
+		ImGui_ImplOpenGL3_CreateDeviceObjects();
 	}
 
 	void ImGuiLayer::OnDetach()
@@ -85,23 +90,80 @@ namespace Janus
 		//ImGuizmo::BeginFrame();
 	}
 
+	// ImGui rebuilds its draw lists every frame, so the render thread gets its own copy of them
+	struct ImGuiViewportSnapshot
+	{
+		GLFWwindow *Window = nullptr;
+		ImDrawData DrawData;
+		std::vector<ImDrawList *> CmdLists;
+	};
+
+	static void SnapshotDrawData(ImDrawData *drawData, GLFWwindow *window, std::vector<ImGuiViewportSnapshot> &snapshots)
+	{
+		if (!drawData || !drawData->Valid)
+			return;
+
+		auto &snapshot = snapshots.emplace_back();
+		snapshot.Window = window;
+		snapshot.DrawData = *drawData;
+		snapshot.CmdLists.reserve(drawData->CmdListsCount);
+		for (int i = 0; i < drawData->CmdListsCount; i++)
+			snapshot.CmdLists.push_back(drawData->CmdLists[i]->CloneOutput());
+	}
+
 	void ImGuiLayer::End()
 	{
 		ImGuiIO &io = ImGui::GetIO();
 		Application &app = Application::Get();
 		io.DisplaySize = ImVec2((float)app.GetWindow().GetWidth(), (float)app.GetWindow().GetHeight());
 
-		// Rendering
 		ImGui::Render();
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+		std::vector<ImGuiViewportSnapshot> snapshots;
+		SnapshotDrawData(ImGui::GetDrawData(), nullptr, snapshots);
 
 		if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 		{
+			// Platform windows are created and destroyed here, which must not overlap with the render thread drawing into them
+			Renderer::WaitForRenderThread();
+
 			GLFWwindow *backup_current_context = glfwGetCurrentContext();
 			ImGui::UpdatePlatformWindows();
-			ImGui::RenderPlatformWindowsDefault();
 			glfwMakeContextCurrent(backup_current_context);
+
+			ImGuiPlatformIO &platformIO = ImGui::GetPlatformIO();
+			for (int i = 1; i < platformIO.Viewports.Size; i++)
+			{
+				ImGuiViewport *viewport = platformIO.Viewports[i];
+				SnapshotDrawData(viewport->DrawData, (GLFWwindow *)viewport->PlatformHandle, snapshots);
+			}
 		}
+
+		GLFWwindow *mainWindow = static_cast<GLFWwindow *>(app.GetWindow().GetNativeWindow());
+		Renderer::Submit([snapshots = std::move(snapshots), mainWindow]() mutable
+						 {
+							 JN_PROFILE_SCOPE("ImGuiLayer::RenderDrawData");
+							 bool switchedContext = false;
+							 for (auto &snapshot : snapshots)
+							 {
+								 snapshot.DrawData.CmdLists = snapshot.CmdLists.data();
+								 if (snapshot.Window)
+								 {
+									 glfwMakeContextCurrent(snapshot.Window);
+									 switchedContext = true;
+								 }
+
+								 ImGui_ImplOpenGL3_RenderDrawData(&snapshot.DrawData);
+
+								 if (snapshot.Window)
+									 glfwSwapBuffers(snapshot.Window);
+
+								 for (ImDrawList *cmdList : snapshot.CmdLists)
+									 IM_DELETE(cmdList);
+							 }
+							 if (switchedContext)
+								 glfwMakeContextCurrent(mainWindow);
+						 });
 	}
 
 	void ImGuiLayer::SetDarkThemeColors()
@@ -1,4 +1,5 @@
 #pragma once
+#include <cfloat>
 #include <glm/glm.hpp>
 
 struct AABB
@@ -10,4 +11,36 @@ struct AABB
 
     AABB(const glm::vec3 &min, const glm::vec3 &max)
         : Min(min), Max(max) {}
-};
\ No newline at end of file
+
+    // Inverted box that any Expand call will overwrite
+    static AABB Empty()
+    {
+        return AABB(glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX));
+    }
+
+    bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+
+    glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+    glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+    void Expand(const glm::vec3 &point)
+    {
+        Min = glm::min(Min, point);
+        Max = glm::max(Max, point);
+    }
+
+    void Expand(const AABB &other)
+    {
+        Min = glm::min(Min, other.Min);
+        Max = glm::max(Max, other.Max);
+    }
+
+    // Box enclosing this box after an affine transform
+    AABB Transform(const glm::mat4 &transform) const
+    {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+        glm::mat3 absolute = glm::mat3(glm::abs(glm::vec3(transform[0])), glm::abs(glm::vec3(transform[1])), glm::abs(glm::vec3(transform[2])));
+        glm::vec3 extents = absolute * GetExtents();
+        return AABB(center - extents, center + extents);
+    }
+};
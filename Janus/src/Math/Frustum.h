@@ -0,0 +1,59 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include "AABB.h"
+
+// View frustum as six inward facing planes (xyz = normal, w = distance), normalized
+struct Frustum
+{
+    enum Plane
+    {
+        Left = 0,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+        Count
+    };
+
+    glm::vec4 Planes[Count];
+
+    // Extracts the planes from a combined view-projection matrix (OpenGL clip space)
+    static Frustum FromViewProjection(const glm::mat4 &viewProjection)
+    {
+        glm::vec4 row0 = {viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]};
+        glm::vec4 row1 = {viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]};
+        glm::vec4 row2 = {viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]};
+        glm::vec4 row3 = {viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]};
+
+        Frustum frustum;
+        frustum.Planes[Left] = row3 + row0;
+        frustum.Planes[Right] = row3 - row0;
+        frustum.Planes[Bottom] = row3 + row1;
+        frustum.Planes[Top] = row3 - row1;
+        frustum.Planes[Near] = row3 + row2;
+        frustum.Planes[Far] = row3 - row2;
+
+        for (auto &plane : frustum.Planes)
+            plane /= glm::length(glm::vec3(plane));
+
+        return frustum;
+    }
+
+    // Conservative test: boxes straddling a frustum corner may be reported as visible
+    bool Intersects(const AABB &aabb) const
+    {
+        glm::vec3 center = (aabb.Min + aabb.Max) * 0.5f;
+        glm::vec3 extents = (aabb.Max - aabb.Min) * 0.5f;
+        for (const auto &plane : Planes)
+        {
+            glm::vec3 normal = glm::vec3(plane);
+            float distance = glm::dot(normal, center) + plane.w;
+            float radius = glm::dot(glm::abs(normal), extents);
+            if (distance + radius < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
@@ -5,6 +5,7 @@
 #include "Core/Events/KeyEvent.h"
 
 #include "Platform/Windows/WindowsWindow.h"
+#include "Graphics/Renderer.h"
 #include "Core/stb_image/stb_image.h"
 namespace Janus
 {
@@ -165,15 +166,28 @@ namespace Janus
 	void WindowsWindow::OnUpdate()
 	{
 		glfwPollEvents();
+	}
+
+	void WindowsWindow::SwapBuffers()
+	{
 		glfwSwapBuffers(m_Window);
 	}
 
+	void WindowsWindow::SetContextCurrent(bool current)
+	{
+		glfwMakeContextCurrent(current ? m_Window : nullptr);
+	}
+
 	void WindowsWindow::SetVSync(bool enabled)
 	{
-		if (enabled)
-			glfwSwapInterval(1);
-		else
-			glfwSwapInterval(0);
+		// The swap interval belongs to the context, which lives on the render thread
+		Renderer::Submit([enabled]()
+						 {
+							 if (enabled)
+								 glfwSwapInterval(1);
+							 else
+								 glfwSwapInterval(0);
+						 });
 
 		m_Data.VSync = enabled;
 	}
@@ -15,6 +15,8 @@ namespace Janus
 		virtual ~WindowsWindow();
 
 		void OnUpdate() override;
+		void SwapBuffers() override;
+		void SetContextCurrent(bool current) override;
 
 		inline unsigned int GetWidth() const override { return m_Data.Width; }
 		inline unsigned int GetHeight() const override { return m_Data.Height; }
@@ -9,6 +9,14 @@
 #include "Graphics/Renderer.h"
 namespace Janus
 {
+	// Tracks an entity's leaf in the scene BVH together with the state its bounds were computed from
+	struct BVHProxyComponent
+	{
+		uint32_t Proxy = SceneBVH::NullNode;
+		glm::vec3 Translation, Rotation, Scale;
+		Mesh *LastMesh = nullptr;
+	};
+
 	Scene::Scene(const std::string &debugName)
 		: m_DebugName(debugName)
 	{
@@ -29,7 +37,6 @@ namespace Janus
 	void Scene::OnUpdate(Timestep ts, EditorCamera &editorCamera)
 	{
 		JN_PROFILE_FUNCTION();
-		glEnable(GL_DEPTH_TEST);
 
 		auto lights = m_Registry.group<SkyLightComponent>(entt::get<TransformComponent>);
 		for (auto entity : lights)
@@ -65,19 +72,70 @@ namespace Janus
 			}
 		}
 
+		UpdateBVH();
+
 		SceneRenderer::BeginScene(this, {editorCamera, editorCamera.GetViewMatrix(), 0.1f, 1000.0f, 45.0f});
+		m_VisibleEntities.clear();
+		m_BVH.QueryFrustum(Frustum::FromViewProjection(editorCamera.GetViewProjection()), m_VisibleEntities);
+		for (uint32_t id : m_VisibleEntities)
+		{
+			auto entity = (entt::entity)id;
+			auto [idComponent, transformComponent, meshComponent] = m_Registry.get<IDComponent, TransformComponent, MeshComponent>(entity);
+			Ref<Material> overrideMaterial = nullptr;
+			SceneRenderer::SubmitMesh(meshComponent.Mesh, transformComponent.GetTransform(), overrideMaterial, idComponent.ID);
+		}
+		SceneRenderer::EndScene();
+	}
+
+	void Scene::UpdateBVH()
+	{
+		JN_PROFILE_FUNCTION();
+
+		// Proxies of entities that lost their mesh
+		auto orphans = m_Registry.view<BVHProxyComponent>(entt::exclude<MeshComponent>);
+		std::vector<entt::entity> removed(orphans.begin(), orphans.end());
+		for (auto entity : removed)
+		{
+			m_BVH.DestroyProxy(m_Registry.get<BVHProxyComponent>(entity).Proxy);
+			m_Registry.remove<BVHProxyComponent>(entity);
+		}
+
+		// Transforms are edited in place, so changes are found by comparing against the last synced state
 		auto group = m_Registry.group<MeshComponent>(entt::get<TransformComponent>);
 		for (auto entity : group)
 		{
 			auto [transformComponent, meshComponent] = group.get<TransformComponent, MeshComponent>(entity);
-			if (meshComponent.Mesh)
+			auto *proxy = m_Registry.try_get<BVHProxyComponent>(entity);
+			if (!meshComponent.Mesh)
 			{
-				Entity e = Entity(entity, this);
-				Ref<Material> overrideMaterial = nullptr;
-				SceneRenderer::SubmitMesh(meshComponent.Mesh, transformComponent.GetTransform(), overrideMaterial);
+				if (proxy)
+				{
+					m_BVH.DestroyProxy(proxy->Proxy);
+					m_Registry.remove<BVHProxyComponent>(entity);
+				}
+				continue;
 			}
+
+			if (proxy && proxy->LastMesh == meshComponent.Mesh.Raw() && proxy->Translation == transformComponent.Translation &&
+				proxy->Rotation == transformComponent.Rotation && proxy->Scale == transformComponent.Scale)
+				continue;
+
+			AABB bounds = meshComponent.Mesh->GetBoundingBox().Transform(transformComponent.GetTransform());
+			if (!proxy)
+			{
+				proxy = &m_Registry.emplace<BVHProxyComponent>(entity);
+				proxy->Proxy = m_BVH.CreateProxy(bounds, (uint32_t)entity);
+			}
+			else
+			{
+				m_BVH.MoveProxy(proxy->Proxy, bounds);
+			}
+
+			proxy->Translation = transformComponent.Translation;
+			proxy->Rotation = transformComponent.Rotation;
+			proxy->Scale = transformComponent.Scale;
+			proxy->LastMesh = meshComponent.Mesh.Raw();
 		}
-		SceneRenderer::EndScene();
 	}
 
 	Entity Scene::CreateEntity(const std::string &name)
@@ -116,6 +174,8 @@ namespace Janus
 	void Scene::DestroyEntity(Entity entity)
 	{
 		JN_PROFILE_FUNCTION();
+		if (auto *proxy = m_Registry.try_get<BVHProxyComponent>(entity.m_EntityHandle))
+			m_BVH.DestroyProxy(proxy->Proxy);
 		m_Registry.destroy(entity.m_EntityHandle);
 	}
 
@@ -146,6 +206,22 @@ namespace Janus
 		return Entity{};
 	}
 
+	void Scene::Raycast(const Ray &ray, std::vector<Entity> &entities, float maxDistance)
+	{
+		std::vector<SceneBVH::RayHit> hits;
+		m_BVH.QueryRay(ray, hits, maxDistance);
+		for (const auto &hit : hits)
+			entities.emplace_back((entt::entity)hit.UserData, this);
+	}
+
+	void Scene::QueryBox(const AABB &box, std::vector<Entity> &entities)
+	{
+		std::vector<uint32_t> handles;
+		m_BVH.QueryBox(box, handles);
+		for (uint32_t handle : handles)
+			entities.emplace_back((entt::entity)handle, this);
+	}
+
 	Ref<Scene> Scene::CreateEmpty()
 	{
 		return new Scene("Empty");
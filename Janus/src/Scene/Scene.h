@@ -9,6 +9,7 @@
 #include "entt/entt.hpp"
 #include "Core/UUID.h"
 #include "Graphics/Environment.h"
+#include "Scene/SceneBVH.h"
 namespace Janus
 {
 
@@ -54,12 +55,22 @@ namespace Janus
         float &GetSkyboxLOD() { return m_SkyboxLod; }
         void SetSkybox(const Ref<TextureCube> &skybox);
 
+        // World space bounds of every mesh entity, refreshed each OnUpdate. User data is the entt handle
+        const SceneBVH &GetBVH() const { return m_BVH; }
+        // Picking and overlap queries against the bounds of mesh entities, as of the last OnUpdate. Ray hits
+        // are appended nearest first
+        void Raycast(const Ray &ray, std::vector<Entity> &entities, float maxDistance = FLT_MAX);
+        void QueryBox(const AABB &box, std::vector<Entity> &entities);
+
         Light m_Light;
 
     public:
         static Ref<Scene> CreateEmpty();
         Ref<Material> m_SkyboxMaterial;
 
+    private:
+        void UpdateBVH();
+
     private:
         UUID m_SceneID;
         std::string m_DebugName;
@@ -72,6 +83,8 @@ namespace Janus
         LightEnvironment m_LightEnvironment;
         float m_SkyboxLod = 0.1f;
         float m_EnvironmentIntensity = 1.0f;
+        SceneBVH m_BVH;
+        std::vector<uint32_t> m_VisibleEntities;
 
         friend class Entity;
         friend class SceneRenderer;
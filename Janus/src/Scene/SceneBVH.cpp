@@ -0,0 +1,427 @@
+#include "jnpch.h"
+#include "Scene/SceneBVH.h"
+
+namespace Janus
+{
+	// Leaves are enlarged by this fraction of their extents, plus a constant, so small moves need no update
+	static constexpr float s_FatMarginScale = 0.1f;
+	static constexpr float s_FatMarginMin = 0.05f;
+
+	static float SurfaceArea(const AABB &box)
+	{
+		glm::vec3 d = box.Max - box.Min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	static AABB Union(const AABB &a, const AABB &b)
+	{
+		return AABB(glm::min(a.Min, b.Min), glm::max(a.Max, b.Max));
+	}
+
+	static bool Contains(const AABB &outer, const AABB &inner)
+	{
+		return glm::all(glm::lessThanEqual(outer.Min, inner.Min)) && glm::all(glm::greaterThanEqual(outer.Max, inner.Max));
+	}
+
+	static bool Overlaps(const AABB &a, const AABB &b)
+	{
+		return glm::all(glm::lessThanEqual(a.Min, b.Max)) && glm::all(glm::greaterThanEqual(a.Max, b.Min));
+	}
+
+	static AABB Fatten(const AABB &bounds)
+	{
+		glm::vec3 margin = bounds.GetExtents() * s_FatMarginScale + glm::vec3(s_FatMarginMin);
+		return AABB(bounds.Min - margin, bounds.Max + margin);
+	}
+
+	uint32_t SceneBVH::AllocateNode()
+	{
+		uint32_t index;
+		if (m_FreeList != NullNode)
+		{
+			index = m_FreeList;
+			m_FreeList = m_Nodes[index].Parent;
+		}
+		else
+		{
+			index = (uint32_t)m_Nodes.size();
+			m_Nodes.emplace_back();
+		}
+
+		m_Nodes[index] = Node();
+		return index;
+	}
+
+	void SceneBVH::FreeNode(uint32_t index)
+	{
+		Node &node = m_Nodes[index];
+		if (!node.IsLeaf())
+			m_Cost -= SurfaceArea(node.Bounds);
+
+		node = Node();
+		node.Free = true;
+		node.Parent = m_FreeList;
+		m_FreeList = index;
+	}
+
+	void SceneBVH::SetBounds(uint32_t index, const AABB &bounds)
+	{
+		Node &node = m_Nodes[index];
+		if (!node.IsLeaf())
+			m_Cost += SurfaceArea(bounds) - SurfaceArea(node.Bounds);
+		node.Bounds = bounds;
+	}
+
+	void SceneBVH::RefitAncestors(uint32_t index)
+	{
+		while (index != NullNode)
+		{
+			const Node &node = m_Nodes[index];
+			SetBounds(index, Union(m_Nodes[node.Left].Bounds, m_Nodes[node.Right].Bounds));
+			index = m_Nodes[index].Parent;
+		}
+	}
+
+	void SceneBVH::InsertLeaf(uint32_t leaf)
+	{
+		if (m_Root == NullNode)
+		{
+			m_Root = leaf;
+			m_Nodes[leaf].Parent = NullNode;
+			return;
+		}
+
+		// Descend towards the sibling that adds the least surface area to the tree
+		AABB leafBounds = m_Nodes[leaf].Bounds;
+		uint32_t index = m_Root;
+		while (!m_Nodes[index].IsLeaf())
+		{
+			const Node &node = m_Nodes[index];
+			float area = SurfaceArea(node.Bounds);
+			float combinedArea = SurfaceArea(Union(node.Bounds, leafBounds));
+
+			// Cost of pairing the leaf with this node, and the cost pushed down to either child
+			float cost = 2.0f * combinedArea;
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto childCost = [&](uint32_t child)
+			{
+				const Node &childNode = m_Nodes[child];
+				float unionArea = SurfaceArea(Union(childNode.Bounds, leafBounds));
+				if (childNode.IsLeaf())
+					return unionArea + inheritanceCost;
+				return unionArea - SurfaceArea(childNode.Bounds) + inheritanceCost;
+			};
+
+			float leftCost = childCost(node.Left);
+			float rightCost = childCost(node.Right);
+			if (cost < leftCost && cost < rightCost)
+				break;
+
+			index = leftCost < rightCost ? node.Left : node.Right;
+		}
+
+		uint32_t sibling = index;
+		uint32_t oldParent = m_Nodes[sibling].Parent;
+		uint32_t newParent = AllocateNode();
+		m_Nodes[newParent].Parent = oldParent;
+		m_Nodes[newParent].Left = sibling;
+		m_Nodes[newParent].Right = leaf;
+		SetBounds(newParent, Union(m_Nodes[sibling].Bounds, leafBounds));
+		m_Nodes[sibling].Parent = newParent;
+		m_Nodes[leaf].Parent = newParent;
+
+		if (oldParent == NullNode)
+		{
+			m_Root = newParent;
+			return;
+		}
+
+		if (m_Nodes[oldParent].Left == sibling)
+			m_Nodes[oldParent].Left = newParent;
+		else
+			m_Nodes[oldParent].Right = newParent;
+		RefitAncestors(oldParent);
+	}
+
+	void SceneBVH::RemoveLeaf(uint32_t leaf)
+	{
+		if (leaf == m_Root)
+		{
+			m_Root = NullNode;
+			return;
+		}
+
+		uint32_t parent = m_Nodes[leaf].Parent;
+		uint32_t grandParent = m_Nodes[parent].Parent;
+		uint32_t sibling = m_Nodes[parent].Left == leaf ? m_Nodes[parent].Right : m_Nodes[parent].Left;
+
+		m_Nodes[sibling].Parent = grandParent;
+		FreeNode(parent);
+		m_Nodes[leaf].Parent = NullNode;
+
+		if (grandParent == NullNode)
+		{
+			m_Root = sibling;
+			return;
+		}
+
+		if (m_Nodes[grandParent].Left == parent)
+			m_Nodes[grandParent].Left = sibling;
+		else
+			m_Nodes[grandParent].Right = sibling;
+		RefitAncestors(grandParent);
+	}
+
+	uint32_t SceneBVH::CreateProxy(const AABB &bounds, uint32_t userData)
+	{
+		uint32_t leaf = AllocateNode();
+		m_Nodes[leaf].Bounds = Fatten(bounds);
+		m_Nodes[leaf].UserData = userData;
+
+		// Structural changes move the baseline along with the cost; only refits count as degradation
+		float cost = m_Cost;
+		InsertLeaf(leaf);
+		m_RebuildCost += m_Cost - cost;
+
+		m_ProxyCount++;
+		return leaf;
+	}
+
+	void SceneBVH::DestroyProxy(uint32_t proxy)
+	{
+		JN_ASSERT(proxy < m_Nodes.size() && !m_Nodes[proxy].Free && m_Nodes[proxy].IsLeaf(), "SCENE_BVH_ERROR: Invalid proxy!");
+
+		float cost = m_Cost;
+		RemoveLeaf(proxy);
+		m_RebuildCost += m_Cost - cost;
+
+		FreeNode(proxy);
+		m_ProxyCount--;
+	}
+
+	bool SceneBVH::MoveProxy(uint32_t proxy, const AABB &bounds)
+	{
+		JN_ASSERT(proxy < m_Nodes.size() && !m_Nodes[proxy].Free && m_Nodes[proxy].IsLeaf(), "SCENE_BVH_ERROR: Invalid proxy!");
+		if (Contains(m_Nodes[proxy].Bounds, bounds))
+			return false;
+
+		m_Nodes[proxy].Bounds = Fatten(bounds);
+		RefitAncestors(m_Nodes[proxy].Parent);
+
+		if (m_ProxyCount > 2 && m_Cost > m_RebuildCost * m_RebuildThreshold)
+			Rebuild();
+		return true;
+	}
+
+	void SceneBVH::Rebuild()
+	{
+		JN_PROFILE_FUNCTION();
+		if (m_Root == NullNode)
+			return;
+
+		// Keep the leaves, which are the proxy ids, and throw away every internal node
+		std::vector<uint32_t> leaves;
+		leaves.reserve(m_ProxyCount);
+		std::vector<uint32_t> stack = { m_Root };
+		while (!stack.empty())
+		{
+			uint32_t index = stack.back();
+			stack.pop_back();
+			if (m_Nodes[index].IsLeaf())
+			{
+				leaves.push_back(index);
+				continue;
+			}
+
+			stack.push_back(m_Nodes[index].Left);
+			stack.push_back(m_Nodes[index].Right);
+			FreeNode(index);
+		}
+
+		m_Cost = 0.0f;
+		m_Root = BuildRange(leaves.data(), (uint32_t)leaves.size());
+		m_Nodes[m_Root].Parent = NullNode;
+		m_RebuildCost = m_Cost;
+	}
+
+	uint32_t SceneBVH::BuildRange(uint32_t *leaves, uint32_t count)
+	{
+		if (count == 1)
+			return leaves[0];
+
+		// Median split along the widest axis of the leaf centers
+		AABB centers = AABB::Empty();
+		for (uint32_t i = 0; i < count; i++)
+			centers.Expand(m_Nodes[leaves[i]].Bounds.GetCenter());
+
+		glm::vec3 size = centers.Max - centers.Min;
+		int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+		uint32_t half = count / 2;
+		std::nth_element(leaves, leaves + half, leaves + count, [this, axis](uint32_t a, uint32_t b)
+						 { return m_Nodes[a].Bounds.GetCenter()[axis] < m_Nodes[b].Bounds.GetCenter()[axis]; });
+
+		uint32_t left = BuildRange(leaves, half);
+		uint32_t right = BuildRange(leaves + half, count - half);
+
+		uint32_t node = AllocateNode();
+		m_Nodes[node].Left = left;
+		m_Nodes[node].Right = right;
+		m_Nodes[left].Parent = node;
+		m_Nodes[right].Parent = node;
+		SetBounds(node, Union(m_Nodes[left].Bounds, m_Nodes[right].Bounds));
+		return node;
+	}
+
+	void SceneBVH::CollectLeaves(uint32_t index, std::vector<uint32_t> &results) const
+	{
+		std::vector<uint32_t> stack = { index };
+		while (!stack.empty())
+		{
+			const Node &node = m_Nodes[stack.back()];
+			stack.pop_back();
+			if (node.IsLeaf())
+			{
+				results.push_back(node.UserData);
+				continue;
+			}
+			stack.push_back(node.Left);
+			stack.push_back(node.Right);
+		}
+	}
+
+	void SceneBVH::QueryFrustum(const Frustum &frustum, std::vector<uint32_t> &results) const
+	{
+		JN_PROFILE_FUNCTION();
+		if (m_Root == NullNode)
+			return;
+
+		std::vector<uint32_t> stack = { m_Root };
+		while (!stack.empty())
+		{
+			uint32_t index = stack.back();
+			stack.pop_back();
+			const Node &node = m_Nodes[index];
+
+			glm::vec3 center = node.Bounds.GetCenter();
+			glm::vec3 extents = node.Bounds.GetExtents();
+			bool outside = false, intersecting = false;
+			for (const auto &plane : frustum.Planes)
+			{
+				glm::vec3 normal = glm::vec3(plane);
+				float distance = glm::dot(normal, center) + plane.w;
+				float radius = glm::dot(glm::abs(normal), extents);
+				if (distance + radius < 0.0f)
+				{
+					outside = true;
+					break;
+				}
+				intersecting |= distance - radius < 0.0f;
+			}
+
+			if (outside)
+				continue;
+
+			if (!intersecting || node.IsLeaf())
+			{
+				CollectLeaves(index, results);
+				continue;
+			}
+
+			stack.push_back(node.Left);
+			stack.push_back(node.Right);
+		}
+	}
+
+	void SceneBVH::QuerySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &results) const
+	{
+		if (m_Root == NullNode)
+			return;
+
+		float radiusSquared = radius * radius;
+		std::vector<uint32_t> stack = { m_Root };
+		while (!stack.empty())
+		{
+			uint32_t index = stack.back();
+			stack.pop_back();
+			const Node &node = m_Nodes[index];
+
+			glm::vec3 closest = glm::clamp(center, node.Bounds.Min, node.Bounds.Max);
+			glm::vec3 toClosest = closest - center;
+			if (glm::dot(toClosest, toClosest) > radiusSquared)
+				continue;
+
+			// The box is inside the sphere when its farthest corner is
+			glm::vec3 farthest = glm::max(glm::abs(node.Bounds.Min - center), glm::abs(node.Bounds.Max - center));
+			if (node.IsLeaf() || glm::dot(farthest, farthest) <= radiusSquared)
+			{
+				CollectLeaves(index, results);
+				continue;
+			}
+
+			stack.push_back(node.Left);
+			stack.push_back(node.Right);
+		}
+	}
+
+	void SceneBVH::QueryBox(const AABB &box, std::vector<uint32_t> &results) const
+	{
+		if (m_Root == NullNode)
+			return;
+
+		std::vector<uint32_t> stack = { m_Root };
+		while (!stack.empty())
+		{
+			uint32_t index = stack.back();
+			stack.pop_back();
+			const Node &node = m_Nodes[index];
+
+			if (!Overlaps(box, node.Bounds))
+				continue;
+
+			if (node.IsLeaf() || Contains(box, node.Bounds))
+			{
+				CollectLeaves(index, results);
+				continue;
+			}
+
+			stack.push_back(node.Left);
+			stack.push_back(node.Right);
+		}
+	}
+
+	void SceneBVH::QueryRay(const Ray &ray, std::vector<RayHit> &hits, float maxDistance) const
+	{
+		if (m_Root == NullNode)
+			return;
+
+		size_t firstHit = hits.size();
+		std::vector<uint32_t> stack = { m_Root };
+		while (!stack.empty())
+		{
+			const Node &node = m_Nodes[stack.back()];
+			stack.pop_back();
+
+			float t;
+			if (!ray.IntersectsAABB(node.Bounds, t))
+				continue;
+
+			// t is negative when the ray starts inside the box
+			t = std::max(t, 0.0f);
+			if (t > maxDistance)
+				continue;
+
+			if (node.IsLeaf())
+			{
+				hits.push_back({node.UserData, t});
+				continue;
+			}
+
+			stack.push_back(node.Left);
+			stack.push_back(node.Right);
+		}
+
+		std::sort(hits.begin() + firstHit, hits.end(), [](const RayHit &a, const RayHit &b)
+				  { return a.Distance < b.Distance; });
+	}
+}
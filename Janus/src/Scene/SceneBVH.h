@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Math/AABB.h"
+#include "Math/Frustum.h"
+#include "Math/Ray.h"
+
+namespace Janus
+{
+	// Dynamic bounding volume hierarchy over world space boxes. Leaves store a slightly enlarged ("fat")
+	// box so small movements need no update at all. Larger movements refit the leaf's ancestors in place,
+	// and the whole tree is rebuilt once refits have degraded it past a threshold. Proxy ids are leaf node
+	// indices and stay valid across rebuilds.
+	class SceneBVH
+	{
+	public:
+		static constexpr uint32_t NullNode = 0xffffffff;
+
+		struct RayHit
+		{
+			uint32_t UserData;
+			float Distance;
+		};
+
+		uint32_t CreateProxy(const AABB &bounds, uint32_t userData);
+		void DestroyProxy(uint32_t proxy);
+		// Returns true if the tree had to be updated
+		bool MoveProxy(uint32_t proxy, const AABB &bounds);
+
+		uint32_t GetUserData(uint32_t proxy) const { return m_Nodes[proxy].UserData; }
+		const AABB &GetFatBounds(uint32_t proxy) const { return m_Nodes[proxy].Bounds; }
+		uint32_t GetProxyCount() const { return m_ProxyCount; }
+
+		// Top-down rebuild. Called automatically when the tree cost grows past the threshold times its
+		// cost after the last rebuild
+		void Rebuild();
+		void SetRebuildThreshold(float threshold) { m_RebuildThreshold = threshold; }
+		// Sum of the surface areas of all internal nodes
+		float GetCost() const { return m_Cost; }
+
+		// Queries append the user data of every proxy whose fat bounds pass the test. Subtrees that are
+		// entirely inside the query volume are appended without testing their leaves
+		void QueryFrustum(const Frustum &frustum, std::vector<uint32_t> &results) const;
+		void QuerySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &results) const;
+		void QueryBox(const AABB &box, std::vector<uint32_t> &results) const;
+		// Hits are sorted by their distance along the ray
+		void QueryRay(const Ray &ray, std::vector<RayHit> &hits, float maxDistance = FLT_MAX) const;
+
+	private:
+		struct Node
+		{
+			AABB Bounds;
+			uint32_t Parent = NullNode;
+			uint32_t Left = NullNode;
+			uint32_t Right = NullNode;
+			uint32_t UserData = 0;
+			// Set while the node is on the free list, so stale proxy ids can be caught
+			bool Free = false;
+
+			bool IsLeaf() const { return Left == NullNode; }
+		};
+
+		uint32_t AllocateNode();
+		void FreeNode(uint32_t index);
+		void SetBounds(uint32_t index, const AABB &bounds);
+		void InsertLeaf(uint32_t leaf);
+		void RemoveLeaf(uint32_t leaf);
+		void RefitAncestors(uint32_t index);
+		uint32_t BuildRange(uint32_t *leaves, uint32_t count);
+		void CollectLeaves(uint32_t index, std::vector<uint32_t> &results) const;
+
+	private:
+		std::vector<Node> m_Nodes;
+		uint32_t m_Root = NullNode;
+		uint32_t m_FreeList = NullNode;
+		uint32_t m_ProxyCount = 0;
+
+		float m_Cost = 0.0f;
+		float m_RebuildCost = 0.0f;
+		float m_RebuildThreshold = 1.5f;
+	};
+}
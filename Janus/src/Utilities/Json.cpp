@@ -0,0 +1,310 @@
+#include "jnpch.h"
+#include "Utilities/Json.h"
+
+namespace Janus
+{
+	// Deeper documents are rejected rather than risking the stack
+	static constexpr uint32_t s_MaxDepth = 256;
+
+	static const JsonValue s_NullValue;
+
+	class JsonParser
+	{
+	public:
+		JsonParser(const char *text, size_t length)
+			: m_Text(text), m_End(text + length), m_Position(text) {}
+
+		bool ParseDocument(JsonValue &value)
+		{
+			if (!ParseValue(value, 0))
+				return false;
+			SkipWhitespace();
+			if (m_Position != m_End)
+				return Fail("unexpected data after the document");
+			return true;
+		}
+
+		const std::string &GetError() const { return m_Error; }
+
+	private:
+		bool Fail(const char *message)
+		{
+			if (m_Error.empty())
+				m_Error = std::string(message) + " at offset " + std::to_string(m_Position - m_Text);
+			return false;
+		}
+
+		void SkipWhitespace()
+		{
+			while (m_Position != m_End && (*m_Position == ' ' || *m_Position == '\t' || *m_Position == '\n' || *m_Position == '\r'))
+				m_Position++;
+		}
+
+		bool Consume(const char *literal)
+		{
+			size_t length = strlen(literal);
+			if ((size_t)(m_End - m_Position) < length || memcmp(m_Position, literal, length) != 0)
+				return false;
+			m_Position += length;
+			return true;
+		}
+
+		bool ParseValue(JsonValue &value, uint32_t depth)
+		{
+			if (depth > s_MaxDepth)
+				return Fail("document nested too deeply");
+
+			SkipWhitespace();
+			if (m_Position == m_End)
+				return Fail("unexpected end of document");
+
+			switch (*m_Position)
+			{
+			case '{':
+				return ParseObject(value, depth);
+			case '[':
+				return ParseArray(value, depth);
+			case '"':
+				value.m_Type = JsonValue::Type::String;
+				return ParseString(value.m_String);
+			case 't':
+				value.m_Type = JsonValue::Type::Bool;
+				value.m_Bool = true;
+				return Consume("true") || Fail("invalid literal");
+			case 'f':
+				value.m_Type = JsonValue::Type::Bool;
+				value.m_Bool = false;
+				return Consume("false") || Fail("invalid literal");
+			case 'n':
+				value.m_Type = JsonValue::Type::Null;
+				return Consume("null") || Fail("invalid literal");
+			default:
+				return ParseNumber(value);
+			}
+		}
+
+		bool ParseObject(JsonValue &value, uint32_t depth)
+		{
+			value.m_Type = JsonValue::Type::Object;
+			m_Position++;
+			SkipWhitespace();
+			if (m_Position != m_End && *m_Position == '}')
+			{
+				m_Position++;
+				return true;
+			}
+
+			while (true)
+			{
+				SkipWhitespace();
+				if (m_Position == m_End || *m_Position != '"')
+					return Fail("expected a member name");
+				std::string &key = value.m_Keys.emplace_back();
+				if (!ParseString(key))
+					return false;
+
+				SkipWhitespace();
+				if (m_Position == m_End || *m_Position++ != ':')
+					return Fail("expected ':'");
+				if (!ParseValue(value.m_Elements.emplace_back(), depth + 1))
+					return false;
+
+				SkipWhitespace();
+				if (m_Position == m_End)
+					return Fail("unterminated object");
+				char c = *m_Position++;
+				if (c == '}')
+					return true;
+				if (c != ',')
+					return Fail("expected ',' or '}'");
+			}
+		}
+
+		bool ParseArray(JsonValue &value, uint32_t depth)
+		{
+			value.m_Type = JsonValue::Type::Array;
+			m_Position++;
+			SkipWhitespace();
+			if (m_Position != m_End && *m_Position == ']')
+			{
+				m_Position++;
+				return true;
+			}
+
+			while (true)
+			{
+				if (!ParseValue(value.m_Elements.emplace_back(), depth + 1))
+					return false;
+
+				SkipWhitespace();
+				if (m_Position == m_End)
+					return Fail("unterminated array");
+				char c = *m_Position++;
+				if (c == ']')
+					return true;
+				if (c != ',')
+					return Fail("expected ',' or ']'");
+			}
+		}
+
+		static void AppendUTF8(std::string &string, uint32_t codePoint)
+		{
+			if (codePoint < 0x80)
+			{
+				string += (char)codePoint;
+			}
+			else if (codePoint < 0x800)
+			{
+				string += (char)(0xc0 | codePoint >> 6);
+				string += (char)(0x80 | (codePoint & 0x3f));
+			}
+			else if (codePoint < 0x10000)
+			{
+				string += (char)(0xe0 | codePoint >> 12);
+				string += (char)(0x80 | (codePoint >> 6 & 0x3f));
+				string += (char)(0x80 | (codePoint & 0x3f));
+			}
+			else
+			{
+				string += (char)(0xf0 | codePoint >> 18);
+				string += (char)(0x80 | (codePoint >> 12 & 0x3f));
+				string += (char)(0x80 | (codePoint >> 6 & 0x3f));
+				string += (char)(0x80 | (codePoint & 0x3f));
+			}
+		}
+
+		bool ParseHex4(uint32_t &value)
+		{
+			if (m_End - m_Position < 4)
+				return Fail("invalid unicode escape");
+
+			value = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				char c = *m_Position++;
+				value <<= 4;
+				if (c >= '0' && c <= '9')
+					value |= c - '0';
+				else if (c >= 'a' && c <= 'f')
+					value |= c - 'a' + 10;
+				else if (c >= 'A' && c <= 'F')
+					value |= c - 'A' + 10;
+				else
+					return Fail("invalid unicode escape");
+			}
+			return true;
+		}
+
+		bool ParseString(std::string &string)
+		{
+			m_Position++;
+			while (true)
+			{
+				// Copy unescaped runs in one go
+				const char *runStart = m_Position;
+				while (m_Position != m_End && *m_Position != '"' && *m_Position != '\\')
+					m_Position++;
+				string.append(runStart, m_Position);
+
+				if (m_Position == m_End)
+					return Fail("unterminated string");
+				if (*m_Position++ == '"')
+					return true;
+
+				if (m_Position == m_End)
+					return Fail("unterminated string");
+				char escape = *m_Position++;
+				switch (escape)
+				{
+				case '"': string += '"'; break;
+				case '\\': string += '\\'; break;
+				case '/': string += '/'; break;
+				case 'b': string += '\b'; break;
+				case 'f': string += '\f'; break;
+				case 'n': string += '\n'; break;
+				case 'r': string += '\r'; break;
+				case 't': string += '\t'; break;
+				case 'u':
+				{
+					uint32_t codePoint;
+					if (!ParseHex4(codePoint))
+						return false;
+					// Characters outside the basic plane are escaped as a surrogate pair
+					if (codePoint >= 0xd800 && codePoint < 0xdc00)
+					{
+						uint32_t low;
+						if (!Consume("\\u") || !ParseHex4(low) || low < 0xdc00 || low >= 0xe000)
+							return Fail("invalid surrogate pair");
+						codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+					}
+					AppendUTF8(string, codePoint);
+					break;
+				}
+				default:
+					return Fail("invalid escape");
+				}
+			}
+		}
+
+		bool ParseNumber(JsonValue &value)
+		{
+			const char *start = m_Position;
+			while (m_Position != m_End && (isdigit((unsigned char)*m_Position) || *m_Position == '-' || *m_Position == '+' || *m_Position == '.' || *m_Position == 'e' || *m_Position == 'E'))
+				m_Position++;
+
+			// The text may not be null terminated, so the number is copied before conversion
+			char buffer[64];
+			size_t length = m_Position - start;
+			if (length == 0 || length >= sizeof(buffer))
+				return Fail("invalid value");
+			memcpy(buffer, start, length);
+			buffer[length] = '\0';
+
+			char *end = nullptr;
+			value.m_Type = JsonValue::Type::Number;
+			value.m_Number = strtod(buffer, &end);
+			if (end != buffer + length)
+				return Fail("invalid number");
+			return true;
+		}
+
+	private:
+		const char *m_Text;
+		const char *m_End;
+		const char *m_Position;
+		std::string m_Error;
+	};
+
+	bool JsonValue::Parse(const char *text, size_t length, JsonValue &value, std::string &error)
+	{
+		JN_PROFILE_FUNCTION();
+		value = JsonValue();
+		JsonParser parser(text, length);
+		if (parser.ParseDocument(value))
+			return true;
+
+		error = parser.GetError();
+		value = JsonValue();
+		return false;
+	}
+
+	const JsonValue &JsonValue::operator[](size_t index) const
+	{
+		return index < m_Elements.size() ? m_Elements[index] : s_NullValue;
+	}
+
+	const JsonValue &JsonValue::operator[](const char *key) const
+	{
+		for (size_t i = 0; i < m_Keys.size(); i++)
+		{
+			if (m_Keys[i] == key)
+				return m_Elements[i];
+		}
+		return s_NullValue;
+	}
+
+	bool JsonValue::Contains(const char *key) const
+	{
+		return std::find(m_Keys.begin(), m_Keys.end(), key) != m_Keys.end();
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Janus
+{
+	// Read-only JSON document, as used by asset formats such as glTF. Parsing builds the whole tree up front;
+	// lookups that miss or hit the wrong type return a null value or the given fallback, so nested optional
+	// properties can be read without checking every level
+	class JsonValue
+	{
+	public:
+		enum class Type : uint8_t
+		{
+			Null = 0,
+			Bool,
+			Number,
+			String,
+			Array,
+			Object
+		};
+
+		// The text does not need to be null terminated. Returns false and describes the first error if it is
+		// not a single valid JSON value
+		static bool Parse(const char *text, size_t length, JsonValue &value, std::string &error);
+
+		Type GetType() const { return m_Type; }
+		bool IsNull() const { return m_Type == Type::Null; }
+		bool IsNumber() const { return m_Type == Type::Number; }
+		bool IsString() const { return m_Type == Type::String; }
+		bool IsArray() const { return m_Type == Type::Array; }
+		bool IsObject() const { return m_Type == Type::Object; }
+
+		bool AsBool(bool fallback = false) const { return m_Type == Type::Bool ? m_Bool : fallback; }
+		double AsNumber(double fallback = 0.0) const { return m_Type == Type::Number ? m_Number : fallback; }
+		float AsFloat(float fallback = 0.0f) const { return m_Type == Type::Number ? (float)m_Number : fallback; }
+		// Fractional numbers are truncated
+		int64_t AsInt(int64_t fallback = 0) const { return m_Type == Type::Number ? (int64_t)m_Number : fallback; }
+		// Empty for anything but strings
+		const std::string &AsString() const { return m_String; }
+
+		// Elements of an array or members of an object, zero for anything else
+		size_t GetSize() const { return m_Elements.size(); }
+		const JsonValue &operator[](size_t index) const;
+		const JsonValue &operator[](const char *key) const;
+		bool Contains(const char *key) const;
+		// Name of the member at index, for iterating over objects
+		const std::string &GetKey(size_t index) const { return m_Keys[index]; }
+
+	private:
+		Type m_Type = Type::Null;
+		bool m_Bool = false;
+		double m_Number = 0.0;
+		std::string m_String;
+		// Array elements, or object member values in the order they appear
+		std::vector<JsonValue> m_Elements;
+		// Object member names, parallel to m_Elements
+		std::vector<std::string> m_Keys;
+
+		friend class JsonParser;
+	};
+}
@@ -0,0 +1,31 @@
+// Renderer owned blocks shared by every scene shader. Blocks named r_* are filled by the renderer;
+// see SceneRenderer's FrameUniforms
+
+struct PointLight {
+    vec3 Position;
+    float Intensity;
+    vec3 Radiance;
+    float Radius;
+    float Falloff;
+};
+
+// u_ClusterScale.xy converts pixels to light grid tiles, .zw are the slice scale and bias applied to
+// log(view depth); see janus_lights.glsl. u_LightCulling selects between the cluster lists and the
+// per-draw light selection
+layout (std140, binding = 0) uniform r_Frame
+{
+    mat4 u_ViewProjectionMatrix;
+    mat4 u_ViewMatrix;
+    vec3 u_CameraPosition;
+    int u_PointLightCount;
+    vec4 u_ClusterScale;
+    int u_ClusterTilesX;
+    int u_ClusterTilesY;
+    int u_ClusterSlices;
+    int u_LightCulling;
+};
+
+layout (std140, binding = 1) uniform r_Draw
+{
+    mat4 u_Transform;
+};
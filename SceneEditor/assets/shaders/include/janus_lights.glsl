@@ -0,0 +1,40 @@
+// Clustered light lists, filled by SceneRenderer from its LightGrid. Fragment stages only; include after
+// janus_frame.glsl. Each cluster of the grid lists the lights that reach it as a range of u_LightIndices.
+// With per-draw culling the draw's own lights come from its instance data instead, see GetDrawLight
+
+const int LightCullingClustered = 0;
+const int LightCullingPerDraw = 1;
+
+// Per-draw selections hold MaxDrawLights indices into u_PointLights, most influential first, packed two
+// per component with the first in the low bits. Unused slots are NoDrawLight
+const int MaxDrawLights = 8;
+const uint NoDrawLight = 0xffffu;
+
+layout (std430, binding = 0) readonly buffer r_PointLights
+{
+    PointLight u_PointLights[];
+};
+
+layout (std430, binding = 1) readonly buffer r_LightGrid
+{
+    uvec2 u_LightGrid[];
+};
+
+layout (std430, binding = 2) readonly buffer r_LightIndices
+{
+    uint u_LightIndices[];
+};
+
+// Offset and count in u_LightIndices of the lights reaching the cluster of a fragment
+uvec2 GetLightCluster(vec3 worldPosition)
+{
+    float depth = max(-(u_ViewMatrix * vec4(worldPosition, 1.0)).z, 0.0001);
+    int slice = clamp(int(log(depth) * u_ClusterScale.z + u_ClusterScale.w), 0, u_ClusterSlices - 1);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy * u_ClusterScale.xy), ivec2(u_ClusterTilesX - 1, u_ClusterTilesY - 1));
+    return u_LightGrid[tile.x + (tile.y + slice * u_ClusterTilesY) * u_ClusterTilesX];
+}
+
+uint GetDrawLight(uvec4 drawLights, int slot)
+{
+    return (drawLights[slot >> 1] >> ((slot & 1) * 16)) & 0xffffu;
+}
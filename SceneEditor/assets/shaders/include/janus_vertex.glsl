@@ -0,0 +1,48 @@
+// Mesh vertex and instance attributes, see Mesh::GetVertexLayout and Mesh::GetInstanceLayout.
+// JN_COMPACT_VERTICES is defined by the renderer when meshes use MeshVertexFormat::Compact
+#ifdef JN_COMPACT_VERTICES
+// Quantized position in the unit cube; the position decode is part of the instance transform.
+// w is 1 when the bitangent points against cross(normal, tangent)
+layout (location = 0) in vec4 a_Position;
+// Octahedral-encoded unit vectors
+layout (location = 1) in vec2 a_Normal;
+layout (location = 2) in vec2 a_Tangent;
+layout (location = 3) in vec2 a_TexCoord;
+#else
+layout (location = 0) in vec3 a_Position;
+layout (location = 1) in vec3 a_Normal;
+layout (location = 2) in vec3 a_Tangent;
+layout (location = 3) in vec3 a_Binormal;
+layout (location = 4) in vec2 a_TexCoord;
+#endif
+// Per-instance model matrix. Non-instanced draws bind a single identity instance and set u_Transform
+layout (location = 5) in mat4 a_InstanceTransform;
+// Per-instance point light selection for per-draw light culling, see janus_lights.glsl
+layout (location = 9) in ivec4 a_InstanceLights;
+
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.x += v.x >= 0.0 ? -t : t;
+    v.y += v.y >= 0.0 ? -t : t;
+    return normalize(v);
+}
+
+// Mesh space attributes of the current vertex in either format
+void GetVertexAttributes(out vec3 position, out vec3 normal, out vec3 tangent, out vec3 binormal, out vec2 texCoord)
+{
+#ifdef JN_COMPACT_VERTICES
+    position = a_Position.xyz;
+    normal = DecodeOctahedral(a_Normal);
+    tangent = DecodeOctahedral(a_Tangent);
+    binormal = cross(normal, tangent) * (a_Position.w > 0.5 ? -1.0 : 1.0);
+    texCoord = a_TexCoord;
+#else
+    position = a_Position;
+    normal = a_Normal;
+    tangent = a_Tangent;
+    binormal = a_Binormal;
+    texCoord = a_TexCoord;
+#endif
+}
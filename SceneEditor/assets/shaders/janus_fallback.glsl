@@ -0,0 +1,34 @@
+// Fallback Shader
+// Drawn in place of a material whose shader is still compiling. Kept tiny so it is ready by the first frame
+
+#type vertex
+#version 450 core
+
+#include "include/janus_frame.glsl"
+#include "include/janus_vertex.glsl"
+
+out vec3 v_Normal;
+
+void main()
+{
+    vec3 position, normal, tangent, binormal;
+    vec2 texCoord;
+    GetVertexAttributes(position, normal, tangent, binormal, texCoord);
+
+    mat4 transform = u_Transform * a_InstanceTransform;
+    v_Normal = mat3(transform) * normal;
+    gl_Position = u_ViewProjectionMatrix * transform * vec4(position, 1.0);
+}
+
+#type fragment
+#version 450 core
+out vec4 FragColor;
+
+in vec3 v_Normal;
+
+void main()
+{
+    // Flat grey with a fixed key light, enough to read the silhouette
+    float lighting = 0.35 + 0.65 * max(dot(normalize(v_Normal), normalize(vec3(0.4, 1.0, 0.3))), 0.0);
+    FragColor = vec4(vec3(0.6) * lighting, 1.0);
+}
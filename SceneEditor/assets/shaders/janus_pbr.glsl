@@ -1,14 +1,8 @@
 #type vertex
-#version 330 core
-layout (location = 0) in vec3 a_Position;
-layout (location = 1) in vec3 a_Normal;
-layout (location = 2) in vec3 a_Tangent;
-layout (location = 3) in vec3 a_Binormal;
-layout (location = 4) in vec2 a_TexCoord;
-// TO DO: Upload model matrix to transform models
+#version 450 core
 
-uniform mat4 u_ViewProjectionMatrix;
-uniform mat4 u_Transform;
+#include "include/janus_frame.glsl"
+#include "include/janus_vertex.glsl"
 
 out VertexOutput
 {
@@ -19,23 +13,30 @@ out VertexOutput
 	mat3 WorldTransform;
 	vec3 Binormal;
 } vs_Output;
+flat out uvec4 vs_DrawLights;
 
 void main()
 {
     // Calculate final gl (screen) position
     // TO DO: Include model matrix in calculation
-	vs_Output.WorldPosition = vec3(u_Transform * vec4(a_Position, 1.0));
-    vs_Output.Normal = a_Normal;
-	vs_Output.TexCoord = vec2(a_TexCoord.x, 1.0 - a_TexCoord.y);
-	vs_Output.WorldNormals = mat3(u_Transform) * mat3(a_Tangent, a_Binormal, a_Normal);
-	vs_Output.WorldTransform = mat3(u_Transform);
-    vs_Output.Binormal = a_Binormal;
-
-    gl_Position = u_ViewProjectionMatrix * u_Transform * vec4(a_Position, 1.0);
+	vec3 position, normal, tangent, binormal;
+	vec2 texCoord;
+	GetVertexAttributes(position, normal, tangent, binormal, texCoord);
+
+	mat4 transform = u_Transform * a_InstanceTransform;
+	vs_Output.WorldPosition = vec3(transform * vec4(position, 1.0));
+    vs_Output.Normal = normal;
+	vs_Output.TexCoord = vec2(texCoord.x, 1.0 - texCoord.y);
+	vs_Output.WorldNormals = mat3(transform) * mat3(tangent, binormal, normal);
+	vs_Output.WorldTransform = mat3(transform);
+    vs_Output.Binormal = binormal;
+    vs_DrawLights = uvec4(a_InstanceLights);
+
+    gl_Position = u_ViewProjectionMatrix * transform * vec4(position, 1.0);
 }
 
 #type fragment
-#version 330 core
+#version 450 core
 out vec4 FragColor;
 
 const float PI = 3.141592;
@@ -44,13 +45,16 @@ vec3 Fdielectric = vec3(0.04);
 
 const int LightCount = 1;
 
-struct PointLight {
-    vec3 Position;
-    vec3 Radiance;
-    float Intensity;
-    float Radius;
-    float Falloff;
-};  
+#include "include/janus_frame.glsl"
+#include "include/janus_lights.glsl"
+
+// Each map is compiled in only for materials that have the texture and its toggle set. Declarations
+// stay unconditional so every variant shares the material layout
+#pragma keyword JN_ALBEDO_MAP u_AlbedoTexture u_AlbedoTexToggle
+#pragma keyword JN_NORMAL_MAP u_NormalTexture u_NormalTexToggle
+#pragma keyword JN_METALNESS_MAP u_MetalnessTexture u_MetalnessTexToggle
+#pragma keyword JN_ROUGHNESS_MAP u_RoughnessTexture u_RoughnessTexToggle
+#pragma keyword JN_AO_MAP u_AoTexture u_AoTexToggle
 
 
 in VertexOutput
@@ -62,6 +66,7 @@ in VertexOutput
 	mat3 WorldTransform;
 	vec3 Binormal;
 } vs_Input;
+flat in uvec4 vs_DrawLights;
 
 uniform sampler2D u_AlbedoTexture;
 uniform sampler2D u_NormalTexture;
@@ -69,19 +74,18 @@ uniform sampler2D u_MetalnessTexture;
 uniform sampler2D u_RoughnessTexture;
 uniform sampler2D u_AoTexture;
 
-uniform vec3 u_AlbedoColor;
-uniform float u_Metalness;
-uniform float u_Roughness;
-
-uniform float u_AlbedoTexToggle;
-uniform float u_NormalTexToggle;
-uniform float u_MetalnessTexToggle;
-uniform float u_RoughnessTexToggle;
-uniform float u_AoTexToggle;
-
-uniform PointLight u_PointLights[100];
-uniform int u_PointLightCount;
-uniform vec3 u_CameraPosition;
+layout (std140, binding = 2) uniform Material
+{
+    vec3 u_AlbedoColor;
+    float u_Metalness;
+    float u_Roughness;
+    float u_AlbedoTexToggle;
+    float u_NormalTexToggle;
+    float u_MetalnessTexToggle;
+    float u_RoughnessTexToggle;
+    float u_AoTexToggle;
+    float u_Transparency;
+};
 
 struct PBRParameters
 {
@@ -132,55 +136,84 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0)
     return F0 + (1.0 - F0) * pow(1.0 - cosTheta, 5.0);
 }
 
-vec3 Lighting(vec3 F0) {
-    vec3 result = vec3(0.0);
-    for(int i = 0; i < u_PointLightCount; i++) {
+vec3 PointLightContribution(PointLight light, vec3 F0) {
+    vec3 L = normalize(light.Position - vs_Input.WorldPosition);
+    vec3 H = normalize(m_Params.View + L);
 
-        PointLight light = u_PointLights[i];
-        vec3 L = normalize(light.Position - vs_Input.WorldPosition);
-        vec3 H = normalize(m_Params.View + L);
+    float distance = length(light.Position - vs_Input.WorldPosition);
 
-        float distance = length(light.Position - vs_Input.WorldPosition);
+    float attenuation = clamp(1.0 - (distance * distance) / (light.Radius * light.Radius), 0.0, 1.0);
+	attenuation *= mix(attenuation, 1.0, light.Falloff);
 
-        float attenuation = clamp(1.0 - (distance * distance) / (light.Radius * light.Radius), 0.0, 1.0);
-		attenuation *= mix(attenuation, 1.0, light.Falloff);
+    vec3 radiance = light.Radiance * 20 * light.Intensity * attenuation;
 
-        vec3 radiance = light.Radiance * 20 * light.Intensity * attenuation;
+    float NDF = DistributionGGX(m_Params.Normal,H,m_Params.Roughness);
+    float G = GeometrySmith(m_Params.Normal,m_Params.View,L, m_Params.Roughness);
+    vec3 F = fresnelSchlick(max(dot(H, m_Params.View), 0.0), F0);
 
-        float NDF = DistributionGGX(m_Params.Normal,H,m_Params.Roughness);
-        float G = GeometrySmith(m_Params.Normal,m_Params.View,L, m_Params.Roughness);
-        vec3 F = fresnelSchlick(max(dot(H, m_Params.View), 0.0), F0);
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - m_Params.Metalness;
 
-        vec3 kS = F;
-        vec3 kD = vec3(1.0) - kS;
-        kD *= 1.0 - m_Params.Metalness;
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(m_Params.Normal,m_Params.View), 0.0) * max(dot(m_Params.Normal, L), 0.0) + 0.0001;
+    vec3 specular = numerator / denominator;
 
-        vec3 numerator = NDF * G * F;
-        float denominator = 4.0 * max(dot(m_Params.Normal,m_Params.View), 0.0) * max(dot(m_Params.Normal, L), 0.0) + 0.0001;
-        vec3 specular = numerator / denominator;
+    float NdotL = max(dot(m_Params.Normal, L), 0.0);
+    return (kD * m_Params.Albedo / PI + specular) * radiance * NdotL;
+}
 
-        float NdotL = max(dot(m_Params.Normal, L), 0.0);
-        result += (kD * m_Params.Albedo / PI + specular) * radiance * NdotL;
+vec3 Lighting(vec3 F0) {
+    vec3 result = vec3(0.0);
+    if (u_LightCulling == LightCullingPerDraw) {
+        // The lights selected for this draw, at most MaxDrawLights of them
+        for (int i = 0; i < MaxDrawLights; i++) {
+            uint index = GetDrawLight(vs_DrawLights, i);
+            if (index == NoDrawLight)
+                break;
+            result += PointLightContribution(u_PointLights[index], F0);
+        }
+        return result;
     }
+
+    // Only the lights whose radius reaches this fragment's cluster
+    uvec2 cluster = GetLightCluster(vs_Input.WorldPosition);
+    for(uint i = 0; i < cluster.y; i++)
+        result += PointLightContribution(u_PointLights[u_LightIndices[cluster.x + i]], F0);
     return result;
 }
 
 void main()
 {
     
-    m_Params.Albedo = u_AlbedoTexToggle > 0.5 ? texture(u_AlbedoTexture, vs_Input.TexCoord).rgb : u_AlbedoColor;
-    //m_Params.Metalness = 0.0;
-    m_Params.Metalness = u_MetalnessTexToggle > 0.5 ? texture(u_MetalnessTexture, vs_Input.TexCoord).r : u_Metalness;
-    m_Params.Roughness = u_RoughnessTexToggle > 0.5 ? texture(u_RoughnessTexture, vs_Input.TexCoord).r : u_Roughness;
+#ifdef JN_ALBEDO_MAP
+    m_Params.Albedo = texture(u_AlbedoTexture, vs_Input.TexCoord).rgb;
+#else
+    m_Params.Albedo = u_AlbedoColor;
+#endif
+#ifdef JN_METALNESS_MAP
+    m_Params.Metalness = texture(u_MetalnessTexture, vs_Input.TexCoord).r;
+#else
+    m_Params.Metalness = u_Metalness;
+#endif
+#ifdef JN_ROUGHNESS_MAP
+    m_Params.Roughness = texture(u_RoughnessTexture, vs_Input.TexCoord).r;
+#else
+    m_Params.Roughness = u_Roughness;
+#endif
     m_Params.Roughness = max(m_Params.Roughness, 0.05);
-    m_Params.Ao = u_AoTexToggle > 0.5 ? texture(u_AoTexture, vs_Input.TexCoord).r : 1.0;
-
+#ifdef JN_AO_MAP
+    m_Params.Ao = texture(u_AoTexture, vs_Input.TexCoord).r;
+#else
+    m_Params.Ao = 1.0;
+#endif
+
+#ifdef JN_NORMAL_MAP
+	m_Params.Normal = normalize(2.0 * texture(u_NormalTexture, vs_Input.TexCoord).rgb - 1.0);
+	m_Params.Normal = normalize(vs_Input.WorldNormals * m_Params.Normal);
+#else
 	m_Params.Normal = normalize(vs_Input.Normal);
-	if (u_NormalTexToggle > 0.5)
-	{
-		m_Params.Normal = normalize(2.0 * texture(u_NormalTexture, vs_Input.TexCoord).rgb - 1.0);
-		m_Params.Normal = normalize(vs_Input.WorldNormals * m_Params.Normal);
-	}
+#endif
 
 
     m_Params.View = normalize(u_CameraPosition - vs_Input.WorldPosition);
@@ -199,7 +232,8 @@ void main()
     color = color / (color + vec3(1.0));
     color = pow(color, vec3(1.0/2.2));  
     
-    FragColor = vec4(color, 1.0);
+    // Transparency is one minus opacity, so materials that never set it stay opaque
+    FragColor = vec4(color, 1.0 - u_Transparency);
     
 }
 
@@ -325,11 +325,11 @@ public:
 
                                 if (useMetalnessMap)
                                 {
-                                    material->Set("u_MetalnessTexToggle", 1.0);
+                                    material->Set("u_MetalnessTexToggle", 1.0f);
                                 }
                                 else
                                 {
-                                    material->Set("u_MetalnessTexToggle", 0.0);
+                                    material->Set("u_MetalnessTexToggle", 0.0f);
                                 }
                                 ImGui::SameLine();
                                 if (ImGui::SliderFloat("Value##MetalnessInput", &metalness, 0.0f, 1.0f))